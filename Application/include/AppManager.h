@@ -8,11 +8,16 @@
 #include "MainWindow.h"
 #include "ICamera.h"
 #include "CameraService.h"
+#include "CameraManager.h"
+#include <chrono>
+#include <string>
+#include <vector>
 
 class AppManager : public QObject {
     Q_OBJECT
 public:
-    explicit AppManager(QObject* parent = nullptr);
+    // launchTime：进程启动时刻 (main() 第一行打点)，用于统计启动到首帧显示的耗时
+    explicit AppManager(std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now(), QObject* parent = nullptr);
     ~AppManager() override;
 
     // 统一步骤：初始化 -> 装配 -> 启动
@@ -20,9 +25,19 @@ public:
     void start();
 
 private:
+    // 按命令行选择相机后端：--camera=hik (默认，仅 Windows) / --camera=sim / --camera=replay
+    // 同时解析 --serials=SN1,SN2 (只打开指定的相机，缺省打开枚举到的全部)
+    CameraFactory createCameraFactory();
+
     // 专门用来处理跨层信号与槽的连线
     void wireConnections();
 
+    // 后台打开相机完成：同步界面参数、装配连线并开始取流
+    void onCamerasOpened(int opened);
+
+    // 自启动以来经过的毫秒数
+    qint64 elapsedSinceLaunchMs() const;
+
 private:
     // ==========================================
     // 系统的核心组件 (未来这里可以加激光器、数据库等)
@@ -31,10 +46,14 @@ private:
     // UI 层
     MainWindow* m_mainWindow;
 
-    // 基础设施与业务层
-    ICamera* m_camera;
+    // 服务层：每台相机的驱动实例、CameraService 与线程都由管理器持有
+    CameraManager* m_cameraManager;
+    std::vector<std::string> m_serialNumbers;
+    QString m_eventDirectory;  // 非空时主相机开启事件录制
+    bool m_ringAnalysis = false; // 主相机开启实时负压环分析，画面显示标注结果
+    int m_analysisWorkers = 0;   // > 0 时改为帧级并行分析，同时分析这么多帧
+    bool m_pinWorkers = false;   // 共享调度器的工作线程逐个绑核
 
-    // 服务层与线程
-    CameraService* m_cameraService;
-    QThread* m_cameraThread;
+    // 启动耗时统计
+    std::chrono::steady_clock::time_point m_launchTime;
 };
\ No newline at end of file
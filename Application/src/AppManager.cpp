@@ -1,94 +1,248 @@
 ﻿#include "AppManager.h"
+#include "SimulatedCamera.h"
+#include "ReplayCamera.h"
+#include "TaskScheduler.h"
+#ifdef HAS_HIK_CAMERA
 #include "HikCamera.h" 
+#endif
+#include <QCoreApplication>
 #include <QDebug>
+#include <algorithm>
+#include <thread>
 
-AppManager::AppManager(QObject* parent)
+// 界面刷新用不着比显示器更快：高帧率相机的多余帧在服务层就跳过，不做显示转换
+static constexpr double kPreviewFps = 30.0;
+
+AppManager::AppManager(std::chrono::steady_clock::time_point launchTime, QObject* parent)
     : QObject(parent),
     m_mainWindow(nullptr),
-    m_camera(nullptr),
-    m_cameraService(nullptr),
-    m_cameraThread(nullptr) {
+    m_cameraManager(nullptr),
+    m_launchTime(launchTime) {
 }
 
 AppManager::~AppManager() {
     // 1. 【极其致命的顺序】：必须先让底层硬件彻底停止抓图，掐断幽灵回调的源头！
-    if (m_camera) {
-        m_camera->stopStream();
-        m_camera->closeDevice();
-    }
-
-    // 2. 然后再优雅退出 Qt 线程
-    if (m_cameraThread) {
-        m_cameraThread->quit();
-        m_cameraThread->wait();
-    }
+    //    CameraManager 会对每台相机依次：停流关设备 -> 退出线程 -> 释放实例
+    delete m_cameraManager;
 
-    // 3. 最后再安全地释放各层指针 (此时绝对不会再有回调来打扰它们了)
-    delete m_cameraService;
-    delete m_camera;
+    // 2. 最后再安全地释放 UI (此时绝对不会再有回调来打扰它了)
     delete m_mainWindow;
 }
 
 void AppManager::initialize() {
-    // 1. 实例化硬件接口
-    m_camera = new HikCamera();
+    // 1. 按命令行准备相机工厂，交给管理器 (每台相机一个实例、一条线程)
+    m_cameraManager = new CameraManager(createCameraFactory());
 
-    // 2. 实例化服务层并注入硬件
-    m_cameraService = new CameraService(m_camera);
+    // 2. 共享任务调度器 (须在第一次使用之前配置)：分析任务最多占到线程数 - 1，总给显示类任务留一条线程
+    TaskSchedulerConfig schedulerConfig;
+    schedulerConfig.workers = std::max(2u, std::thread::hardware_concurrency());
+    schedulerConfig.maxConcurrent[static_cast<size_t>(TaskPriority::ANALYSIS)] = schedulerConfig.workers - 1;
+    schedulerConfig.pinWorkers = m_pinWorkers;
+    TaskScheduler::configureShared(schedulerConfig);
 
     // 3. 实例化 UI
     m_mainWindow = new MainWindow();
 
-    // 4. 配置多线程
-    m_cameraThread = new QThread(this);
-    m_cameraService->moveToThread(m_cameraThread);
+    // 4. 周期打印每台相机与汇总的帧率、丢帧
+    connect(m_cameraManager, &CameraManager::statsUpdated, this, [this](const CameraManagerStats& stats) {
+        for (int i = 0; i < static_cast<int>(stats.cameras.size()); i++) {
+            const CameraRuntimeStats& camera = stats.cameras[i];
+            qDebug() << "[AppManager]" << QString::fromStdString(camera.serialNumber)
+                << "fps:" << camera.fps << "丢帧:" << camera.dropped;
+
+            // 各订阅者的积压与丢帧：哪一路跟不上一目了然
+            for (const FrameBusSubscriberStats& subscriber : m_cameraManager->service(i)->getFrameBusStats()) {
+                if (subscriber.dropped() == 0 && subscriber.queueDepth == 0) continue;
+                qDebug() << "[AppManager]    订阅者" << QString::fromStdString(subscriber.name)
+                    << "积压:" << subscriber.queueDepth << "/" << subscriber.queueCapacity << "丢帧:" << subscriber.dropped();
+            }
+        }
+        qDebug() << "[AppManager] 合计 fps:" << stats.totalFps << "丢帧:" << stats.totalDropped;
+
+        // 帧级并行分析跑在共享调度器上：排队与窃取情况
+        if (m_analysisWorkers > 0) {
+            TaskSchedulerStats scheduler = TaskScheduler::shared().getStats();
+            const TaskClassStats& analysis = scheduler.classes[static_cast<size_t>(TaskPriority::ANALYSIS)];
+            qDebug() << "[AppManager] 调度器 分析排队:" << analysis.queued << "执行中:" << analysis.running
+                << "平均等待(ms):" << analysis.avgWaitMs << "窃取:" << scheduler.steals;
+        }
+        });
+}
+
+CameraFactory AppManager::createCameraFactory() {
+    // 示例：MainApp.exe --camera=sim --sim-count=4 --sim-format=mono --sim-fps=120 --sim-size=1920x1080
+    //       MainApp.exe --camera=hik --serials=DA0001,DA0002
+    //       MainApp.exe --camera=replay --replay-source=D:/record/line1.ocvraw --replay-fast --replay-loop
+    //       MainApp.exe --camera=hik --event-dir=D:/events --analysis
+    //       MainApp.exe --camera=sim --sim-fps=120 --analysis-workers=4 --pin-workers
+    QString backend;
+    SimulatedCameraConfig simConfig;
+    ReplayConfig replayConfig;
+    for (const QString& arg : QCoreApplication::arguments()) {
+        if (arg.startsWith("--camera=")) {
+            backend = arg.section('=', 1);
+        }
+        else if (arg.startsWith("--serials=")) {
+            for (const QString& serial : arg.section('=', 1).split(',')) {
+                if (!serial.isEmpty()) m_serialNumbers.push_back(serial.toStdString());
+            }
+        }
+        else if (arg.startsWith("--sim-count=")) {
+            simConfig.deviceCount = arg.section('=', 1).toInt();
+        }
+        else if (arg.startsWith("--sim-fps=")) {
+            simConfig.frameRate = arg.section('=', 1).toDouble();
+        }
+        else if (arg.startsWith("--sim-size=")) {
+            QStringList size = arg.section('=', 1).split('x');
+            if (size.size() == 2) {
+                simConfig.width = size[0].toInt();
+                simConfig.height = size[1].toInt();
+            }
+        }
+        else if (arg.startsWith("--sim-format=")) {
+            QString format = arg.section('=', 1);
+            if (format == "mono") simConfig.format = PixelFormat::MONO8;
+            else if (format == "rgb") simConfig.format = PixelFormat::RGB8;
+            else if (format == "bgr") simConfig.format = PixelFormat::BGR8;
+            else if (format == "bayer") simConfig.format = PixelFormat::BAYER_RG8;
+            else qDebug() << "[AppManager] 错误：未知的 --sim-format 取值" << format << "(可选 mono/rgb/bgr/bayer)，保持默认格式";
+        }
+        else if (arg.startsWith("--replay-source=")) {
+            replayConfig.source = arg.section('=', 1).toStdString();
+        }
+        else if (arg == "--replay-fast") {
+            replayConfig.timing = ReplayTiming::AS_FAST_AS_POSSIBLE;
+        }
+        else if (arg == "--replay-loop") {
+            replayConfig.loop = true;
+        }
+        else if (arg.startsWith("--event-dir=")) {
+            m_eventDirectory = arg.section('=', 1);
+        }
+        else if (arg == "--analysis") {
+            m_ringAnalysis = true;
+        }
+        else if (arg.startsWith("--analysis-workers=")) {
+            m_analysisWorkers = arg.section('=', 1).toInt();
+            m_ringAnalysis = m_analysisWorkers > 0;
+        }
+        else if (arg == "--pin-workers") {
+            m_pinWorkers = true;
+        }
+    }
 
-    // 5. 进行信号槽装配
-    wireConnections();
+    if (backend == "replay") {
+        qDebug() << "[AppManager] 使用回放相机：" << QString::fromStdString(replayConfig.source);
+        return [replayConfig]() -> ICamera* { return new ReplayCamera(replayConfig); };
+    }
+
+#ifdef HAS_HIK_CAMERA
+    if (backend != "sim") {
+        return []() -> ICamera* { return new HikCamera(); };
+    }
+#endif
+
+    // 没有海康插件的平台 (Linux 构建机) 只能使用模拟相机
+    qDebug() << "[AppManager] 使用模拟相机：" << simConfig.deviceCount << "台" << simConfig.width << "x" << simConfig.height << "@" << simConfig.frameRate << "fps";
+    return [simConfig]() -> ICamera* { return new SimulatedCamera(simConfig); };
 }
 
 void AppManager::wireConnections() {
-    // ---- A. 线程与生命周期 ----
-    connect(m_cameraThread, &QThread::started,
-        m_cameraService, &CameraService::startWorkLoop);
-    connect(m_cameraThread, &QThread::finished,
-        m_cameraThread, &QObject::deleteLater);
-
-    // ---- B. 业务数据流 (Service -> UI) ----
-    connect(m_cameraService, &CameraService::frameReadyToShow,
-        m_mainWindow->getCameraView(), &CameraView::onFrameReady);
+    // 界面只有一个画面：显示并控制第一台相机，其余相机照常取流、参与统计
+    CameraService* primary = m_cameraManager->service(0);
+
+    // ---- A. 业务数据流 (Service -> UI) ----
+    primary->setPreviewFrameRate(kPreviewFps);
+
+    // 事件录制：内存里常备最近 3 秒原始帧，检测目标丢失时连同其后 0.5 秒一起落盘
+    if (!m_eventDirectory.isEmpty()) primary->enableEventCapture(PreTriggerConfig(), m_eventDirectory);
+    // 图走信箱、信号只做通知：界面忙时积压不超过一帧
+    // 开启实时分析时改为显示分析信箱里的标注图 (帧率等于流水线的吞吐量)
+    if (m_ringAnalysis) {
+        if (m_analysisWorkers > 0) {
+            // 显示链路宁可跳过一帧也不要被一帧卡住：队首迟迟不出结果就跳过它
+            ParallelAnalyzerConfig parallel;
+            parallel.workers = static_cast<size_t>(m_analysisWorkers);
+            parallel.reorderWindow = parallel.workers * 2;
+            parallel.dropLate = true;
+            primary->enableParallelRingAnalysis(parallel);
+        }
+        else {
+            primary->enableRingAnalysis();
+        }
+        m_mainWindow->getCameraView()->setFrameSource(primary->analysisMailbox());
+        connect(primary, &CameraService::analysisFrameAvailable,
+            m_mainWindow->getCameraView(), &CameraView::onFrameAvailable);
+    }
+    else {
+        m_mainWindow->getCameraView()->setFrameSource(primary->previewMailbox());
+        connect(primary, &CameraService::previewFrameAvailable,
+            m_mainWindow->getCameraView(), &CameraView::onFrameAvailable);
+    }
 
-    // ---- C. 控制流 (UI -> Service) 【本次新增】 ----
+    // ---- B. 控制流 (UI -> Service) ----
     // UI 参数调节 -> Service 参数下发 (Service 会通过多态指针调用底层硬件)
     connect(m_mainWindow->getCameraView(), &CameraView::exposureTimeChanged,
-        m_cameraService, &CameraService::setExposureTime);
+        primary, &CameraService::setExposureTime);
 
     connect(m_mainWindow->getCameraView(), &CameraView::gainChanged,
-        m_cameraService, &CameraService::setGain);
+        primary, &CameraService::setGain);
+
+    // 参数下发后回显设备实际采用的值 (Service -> UI)
+    connect(primary, &CameraService::exposureTimeApplied,
+        m_mainWindow->getCameraView(), &CameraView::onExposureTimeApplied);
+
+    connect(primary, &CameraService::gainApplied,
+        m_mainWindow->getCameraView(), &CameraView::onGainApplied);
+
+    // 断线期间在画面上提示；重连成功后的第一帧会把提示自然替换掉
+    connect(primary, &CameraService::connectionStateChanged, m_mainWindow->getCameraView(), [this](bool connected, const QString& msg) {
+        if (connected) m_mainWindow->getCameraView()->showStatus(msg);
+        else m_mainWindow->getCameraView()->showMessage(msg);
+        });
 }
 
 void AppManager::start() {
-    CameraStatus status = m_camera->openDevice();
+    // 1. 界面先出来：枚举与打开相机要走好几轮 USB 往返，不能让窗口干等
+    m_mainWindow->getCameraView()->showStatus("正在连接相机...");
+    m_mainWindow->showMaximized();
+    qDebug() << "[AppManager] 启动耗时: 窗口显示" << elapsedSinceLaunchMs() << "ms";
 
-    if (status == CameraStatus::SUCCESS) {
-        qDebug() << "[AppManager] 相机打开成功，启动数据流线程！";
+    connect(m_mainWindow->getCameraView(), &CameraView::firstFrameDisplayed, this, [this]() {
+        qDebug() << "[AppManager] 启动耗时: 首帧显示" << elapsedSinceLaunchMs() << "ms";
+        });
 
-        // 1. 捞取相机当前值
-        float currentExposure = m_camera->getExposureTime();
-        float currentGain = m_camera->getGain();
+    // 2. 相机在后台打开，完成后回到这里继续装配
+    connect(m_cameraManager, &CameraManager::openFinished, this, &AppManager::onCamerasOpened);
+    m_cameraManager->openAllAsync(m_serialNumbers);
+}
+
+void AppManager::onCamerasOpened(int opened) {
+    qDebug() << "[AppManager] 启动耗时: 相机就绪" << elapsedSinceLaunchMs() << "ms";
+
+    if (opened > 0) {
+        qDebug() << "[AppManager] 打开了" << opened << "台相机，启动数据流线程！";
+        ICamera* camera = m_cameraManager->camera(0);
 
-        // 2. 【新增】：捞取相机的物理极限值
-        float maxGain = m_camera->getMaxGain();
+        // 1. 当前值与物理极限在后台打开时已读进参数快照，这里不再访问设备
+        CameraParams params = camera->getParams();
 
-        // 3. 把这些真实的数据一股脑喂给 UI，让 UI 根据硬件能力变形！
-        m_mainWindow->getCameraView()->setInitialParams(currentExposure, currentGain, maxGain);
+        // 2. 把这些真实的数据一股脑喂给 UI，让 UI 根据硬件能力变形！
+        double maxGain = params.gain.available && params.gain.max > 0.0 ? params.gain.max : 12.0;
+        m_mainWindow->getCameraView()->setInitialParams(params.exposureTime.current, params.gain.current, maxGain);
+        m_mainWindow->getCameraView()->showStatus("相机已连接，等待画面...");
 
-        m_cameraThread->start();
+        // 3. 服务已创建，装配信号槽后再让每台相机在自己的线程里开始取流
+        wireConnections();
+        m_cameraManager->startAll();
     }
     else {
-        qDebug() << "[AppManager] 致命错误：相机打开失败！错误码：" << static_cast<int>(status);
+        qDebug() << "[AppManager] 致命错误：没有任何相机打开成功！";
         m_mainWindow->getCameraView()->showMessage("相机连接失败，请检查网线、电源或 USB 配置！");
     }
+}
 
-    m_mainWindow->showMaximized();
-}
\ No newline at end of file
+qint64 AppManager::elapsedSinceLaunchMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_launchTime).count();
+}
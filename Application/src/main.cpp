@@ -2,13 +2,17 @@
 #include <QApplication>
 #include "AppManager.h"
 #include <QMetaType> // 加上头文件
+#include <chrono>
 
 int main(int argc, char* argv[]) {
+    // 启动耗时的起点：从这里到第一帧画面显示出来
+    auto launchTime = std::chrono::steady_clock::now();
+
     QApplication a(argc, argv);
     qRegisterMetaType<cv::Mat>("cv::Mat");
 
     // 实例化总调度师
-    AppManager appManager;
+    AppManager appManager(launchTime);
 
     // 让调度师去完成所有底层组装
     appManager.initialize();
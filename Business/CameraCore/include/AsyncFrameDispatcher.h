@@ -0,0 +1,101 @@
+﻿// Business/CameraCore/include/AsyncFrameDispatcher.h
+#pragma once
+
+#include "Frame.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =========================================================
+// 分发统计：排查“转换跟不上采集”或“消费者太慢”的问题
+// =========================================================
+struct DispatchStats {
+    size_t queueDepth = 0;      // 当前排队等待转换的帧数
+    size_t queueCapacity = 0;   // 队列容量
+    size_t peakDepth = 0;       // 历史最大排队深度
+    unsigned int workers = 0;   // 转换线程数
+    uint64_t posted = 0;        // 采集线程投递的帧数
+    uint64_t dropped = 0;       // 队列满时被挤掉的旧帧数 (溢出丢帧)
+    uint64_t failed = 0;        // 转换失败 (或转换/交付抛出异常) 而未完整交付的帧数
+    uint64_t delivered = 0;     // 成功交付给上层回调的帧数
+    uint64_t incomplete = 0;    // 传输丢包的残帧，在投递前就由相机驱动丢弃 (不占缓冲、不转换)
+};
+
+// 一个待转换的任务：frame.image() 里是已拷出 SDK 缓冲的原始数据
+struct FrameJob {
+    Frame frame;
+    uint32_t nativeType = 0;    // 相机私有的原始像素类型 (如海康 MvGvspPixelType)，业务层不解读
+    int width = 0;              // 原始图像尺寸：业务层不认识的格式按字节原样存放时，
+    int height = 0;             // frame.image() 的行列不代表真实尺寸
+};
+
+// =========================================================
+// AsyncFrameDispatcher：把像素转换与回调链从相机 SDK 的采集线程上挪走
+//
+// 采集线程只调用 post()：把原始帧放进有界队列后立即返回，不做任何转换；
+// 队列满时挤掉最旧的一帧 (实时系统宁可丢旧帧，也不能拖住驱动回收缓冲)。
+// 转换线程池并行执行 converter，但 sink 严格按入队顺序、一次一帧地调用，
+// 上层看到的回调顺序与单线程时完全一致。converter 或 sink 抛出的异常在线程内吞掉，
+// 该帧记为失败，交付序号照常推进，后面的帧不会因此卡住。
+// =========================================================
+class AsyncFrameDispatcher {
+public:
+    // 在转换线程上执行：把 job.frame 转为输出格式，返回 false 表示丢弃该帧
+    using Converter = std::function<bool(FrameJob& job)>;
+    // 按顺序交付转换完成的帧
+    using Sink = std::function<void(const Frame& frame)>;
+
+    /**
+     * @param capacity 队列容量 (最多积压多少帧原始数据)
+     * @param workers 转换线程数
+     */
+    explicit AsyncFrameDispatcher(size_t capacity = 4, unsigned int workers = 2);
+    ~AsyncFrameDispatcher();
+
+    AsyncFrameDispatcher(const AsyncFrameDispatcher&) = delete;
+    AsyncFrameDispatcher& operator=(const AsyncFrameDispatcher&) = delete;
+
+    // 启动转换线程池 (已启动时直接返回)
+    void start(Converter converter, Sink sink);
+
+    /**
+     * @brief 停止线程池：丢弃仍在排队的帧，等待正在转换/交付的帧结束
+     * @note 不能在 sink 内部调用，否则会等待自己退出
+     */
+    void stop();
+
+    /**
+     * @brief 投递一帧 (采集线程调用，永不阻塞)
+     * @return false 表示为此挤掉了一帧更旧的积压，或分发器尚未启动
+     */
+    bool post(FrameJob job);
+
+    // 当前线程是否是本分发器的转换线程 (即正在 sink 里)：此时调用 stop() 会等待自己
+    bool isWorkerThread() const;
+
+    DispatchStats getStats() const;
+
+private:
+    void workerLoop();
+
+private:
+    size_t m_capacity;
+    unsigned int m_workerCount;
+    Converter m_converter;
+    Sink m_sink;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notEmpty;      // 有新任务
+    std::condition_variable m_turn;          // 轮到下一个序号交付
+    std::deque<FrameJob> m_queue;
+    std::vector<std::thread> m_workers;
+    bool m_running;
+
+    uint64_t m_nextTicket;                   // 出队时发放的交付序号
+    uint64_t m_nextDelivery;                 // 下一个允许交付的序号
+    DispatchStats m_stats;
+};
@@ -0,0 +1,82 @@
+﻿// Business/CameraCore/include/ClockCorrelator.h
+#pragma once
+
+#include "Frame.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+struct ClockCorrelatorConfig {
+    std::chrono::milliseconds slot{ 50 };            // 每个时间槽只保留到达延迟最小的一帧作为拟合点
+    size_t window = 128;                             // 参与拟合的最近时间槽数 (默认约 6.4 秒)
+    size_t minSamples = 8;                           // 少于这么多个拟合点时不给出换算结果
+    std::chrono::microseconds outlierThreshold{ 5000 }; // 到达比拟合线晚这么多的样本 (调度卡顿) 不参与拟合
+    std::chrono::milliseconds resyncThreshold{ 1000 };  // 预测偏差超过这么多即认为设备时钟被重置 (断线重连、重新上电)
+};
+
+struct ClockCorrelationStats {
+    bool locked = false;           // 样本足够，toHost() 可用
+    uint64_t samples = 0;          // 收到的样本总数
+    uint64_t rejected = 0;         // 作为离群点未参与拟合的样本数
+    uint64_t resyncs = 0;          // 设备时钟回退/跳变后重新拟合的次数
+    double ticksPerSecond = 0.0;   // 拟合出的设备时钟频率
+    double residualRmsUs = 0.0;    // 拟合点相对拟合线的均方根偏差 (越小说明换算越可信)
+    double envelopeOffsetUs = 0.0; // 拟合线到下包络的距离：换算结果据此扣除平均排队延迟
+};
+
+// =========================================================
+// ClockCorrelator：把设备时钟 tick 换算成主机 steady_clock 时刻
+// 每帧的 (设备时间戳, 到达主机时刻) 是一个样本，滑动窗口内做最小二乘直线拟合
+// (斜率 = 主机秒/设备 tick，吸收两边晶振的频差)。
+//
+// 到达时刻 = 设备时刻 + 固定的读出/传输时间 + 随机的排队与调度延迟，只会晚、不会早；
+// 所以每个时间槽只留延迟最小的一帧来拟合 (拟合的是下包络而不是均值，窗口也因此能覆盖更长时间)，
+// 换算结果再贴到窗口内的最低点上。固定的读出/传输时间无法从样本里分离，仍包含在结果里。
+//
+// 线程安全；addSample() 应按帧到达顺序调用 (相机的采集线程)。
+// =========================================================
+class ClockCorrelator {
+public:
+    explicit ClockCorrelator(const ClockCorrelatorConfig& config = ClockCorrelatorConfig());
+
+    // 送入一个样本
+    void addSample(uint64_t deviceTicks, std::chrono::steady_clock::time_point hostArrival);
+
+    // 设备时刻 -> 主机时刻；未锁定时返回默认构造的 time_point
+    std::chrono::steady_clock::time_point toHost(uint64_t deviceTicks) const;
+
+    // 便捷入口：用帧自带的设备时间戳与到达时刻送入样本，并填好 Frame::hostExposure
+    void correlate(Frame& frame);
+
+    bool isLocked() const;
+    ClockCorrelationStats getStats() const;
+    void reset();
+
+private:
+    struct Sample {
+        uint64_t ticks;
+        std::chrono::steady_clock::time_point host;
+        std::chrono::steady_clock::time_point slotStart; // 所在时间槽的起点 (槽内第一帧的到达时刻)
+    };
+
+    // 以下均需持有 m_mutex
+    void clearLocked();
+    // 以窗口首个样本为原点重新拟合 (两遍法，数值稳定)，并更新下包络与残差统计
+    void refitLocked();
+    // 拟合线在该设备时刻的主机纳秒数 (相对窗口首个样本)，不含下包络修正
+    double predictLocked(uint64_t deviceTicks) const;
+    double hostOffsetNs(std::chrono::steady_clock::time_point host) const;
+
+private:
+    const ClockCorrelatorConfig m_config;
+
+    mutable std::mutex m_mutex;
+    std::deque<Sample> m_samples;      // 最近 window 个时间槽的拟合点，按到达顺序
+    bool m_fitValid;
+    double m_slope;                    // 主机纳秒 / 设备 tick
+    double m_intercept;                // 首个样本处的主机纳秒 (相对首个样本的到达时刻)
+    double m_envelope;                 // 最小残差 (<= 0)，换算时加上它落到下包络
+
+    ClockCorrelationStats m_stats;
+};
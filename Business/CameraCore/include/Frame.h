@@ -0,0 +1,172 @@
+﻿// Business/CameraCore/include/Frame.h
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "BayerDemosaic.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// =========================================================
+// 像素格式：与具体相机 SDK 解耦的统一描述
+// =========================================================
+enum class PixelFormat {
+    UNKNOWN,
+    MONO8,
+    RGB8,
+    BGR8,
+    BAYER_RG8,
+    BAYER_GB8,
+    BAYER_GR8,
+    BAYER_BG8
+};
+
+// 是否为 8 位 Bayer 原始格式
+inline bool isBayerFormat(PixelFormat format) {
+    return format == PixelFormat::BAYER_RG8 || format == PixelFormat::BAYER_GB8 ||
+        format == PixelFormat::BAYER_GR8 || format == PixelFormat::BAYER_BG8;
+}
+
+// Bayer 像素格式 -> 去马赛克引擎的排列 (非 Bayer 格式调用无意义，按 RG 处理)
+inline BayerPattern bayerPatternOf(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::BAYER_GB8: return BayerPattern::GB;
+    case PixelFormat::BAYER_GR8: return BayerPattern::GR;
+    case PixelFormat::BAYER_BG8: return BayerPattern::BG;
+    default:                     return BayerPattern::RG;
+    }
+}
+
+// 该像素格式对应的 cv::Mat 类型 (Bayer 原始数据按单通道存放)
+inline int cvTypeOf(PixelFormat format) {
+    return (format == PixelFormat::RGB8 || format == PixelFormat::BGR8) ? CV_8UC3 : CV_8UC1;
+}
+
+// 界面显示用的格式：黑白保持单通道，其余一律 RGB8 (与 CameraView 的 QImage 格式对应)
+inline PixelFormat displayFormatOf(PixelFormat format) {
+    return format == PixelFormat::MONO8 ? PixelFormat::MONO8 : PixelFormat::RGB8;
+}
+
+constexpr int kPixelFormatCount = static_cast<int>(PixelFormat::BAYER_BG8) + 1;
+
+// =========================================================
+// 按需转换缓存：同一帧的所有拷贝共享一份，每种目标格式最多转换一次
+// 多个消费者同时要不同格式时互不阻塞，同时要同一格式时只有一个真正去转换
+// =========================================================
+struct FrameConversionCache {
+    std::once_flag once[kPixelFormatCount];
+    cv::Mat images[kPixelFormatCount];
+};
+
+// 帧对转换缓存的引用：构造帧时不分配，第一次 toFormat() 或第一次被拷贝时才创建，
+// 之后拷贝出去的帧共享同一份。缓存块用完回收复用，稳态取流下不再向堆申请内存
+class FrameConversionRef {
+public:
+    FrameConversionRef() = default;
+    FrameConversionRef(const FrameConversionRef& other) : m_cache(other.get()) {}
+    FrameConversionRef(FrameConversionRef&& other) noexcept : m_cache(other.take()) {}
+    FrameConversionRef& operator=(const FrameConversionRef& other) {
+        if (this != &other) replace(other.get());
+        return *this;
+    }
+    FrameConversionRef& operator=(FrameConversionRef&& other) noexcept {
+        if (this != &other) replace(other.take());
+        return *this;
+    }
+
+    // 取缓存，没有就创建 (多线程同时取时只创建一份)
+    std::shared_ptr<FrameConversionCache> get() const;
+
+    // 断开与其它拷贝的共享：本帧下次转换时另起一份
+    void reset() { replace(nullptr); }
+
+private:
+    std::shared_ptr<FrameConversionCache> take() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::move(m_cache);
+    }
+    void replace(std::shared_ptr<FrameConversionCache> cache) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache.swap(cache);
+    }
+
+    mutable std::mutex m_mutex;   // 只护住指针本身，转换在锁外进行
+    mutable std::shared_ptr<FrameConversionCache> m_cache;
+};
+
+// =========================================================
+// Frame：一帧图像 + 它的“身世”
+// 作用：取代裸 cv::Mat，把 SDK 帧信息里的时间戳、帧号、丢包数一起带给下游，
+//       下游据此测量端到端延迟、根据帧号断层发现丢帧、提前丢弃残帧。
+// 拷贝代价：cv::Mat 与转换缓存只增加引用计数，其余都是标量，可放心按值传递。
+//
+// 图像默认以传感器原始格式在系统里流转 (例如 Bayer)，各消费者调用 toFormat()
+// 按自己需要的格式取图：灰度流水线从此不必先转 RGB 再转灰度。
+// 图像只能通过 setImage() 替换：替换时本帧与旧图的转换结果一并脱钩，其它拷贝不受影响。
+// 换 pixelFormat 时请同时 setImage()，否则已缓存的转换结果仍按旧格式得出。
+// =========================================================
+struct Frame {
+    PixelFormat pixelFormat = PixelFormat::UNKNOWN;       // image() 当前的像素格式
+    PixelFormat sensorFormat = PixelFormat::UNKNOWN;      // 传感器输出的原始像素格式
+
+    uint64_t frameNumber = 0;       // 设备帧号 (连续递增，出现断层即说明中途丢帧)
+    uint64_t deviceTimestamp = 0;   // 设备时间戳 (设备时钟 tick，单位由相机决定)
+    uint32_t lostPackets = 0;       // 本帧传输丢包数，非 0 说明图像残缺
+    uint64_t triggerId = 0;         // 设备触发计数 (触发模式下有效，多相机据此组帧；连续采集时为 0)
+
+    // 本帧在传感器全幅坐标系中的位置 (ROI)，以及每个输出像素对应的传感器像素数 (binning x decimation)
+    // sensorRect 为空表示未知，按全幅、无合并处理
+    cv::Rect sensorRect;
+    int pixelStep = 1;
+
+    // 到达主机的时刻 (在 SDK 回调入口处打点)，用于计算端到端延迟
+    std::chrono::steady_clock::time_point hostArrival;
+
+    // 设备时间戳换算到主机时钟的时刻 (见 ClockCorrelator)，即曝光发生的时刻；时钟尚未拟合好时为默认值
+    std::chrono::steady_clock::time_point hostExposure;
+
+    // 图像数据 (pixelFormat 格式)，只读；像素与其它拷贝共享
+    const cv::Mat& image() const { return m_image; }
+
+    // 替换图像数据，并丢弃本帧对旧转换结果的引用
+    void setImage(const cv::Mat& image) {
+        m_image = image;
+        m_conversions.reset();
+    }
+
+    bool empty() const { return m_image.empty(); }
+
+    // 传输是否完整：残帧没有分析价值，应在耗费 CPU 之前就丢弃
+    bool isComplete() const { return lostPackets == 0; }
+
+    // 把图像坐标换算回传感器全幅坐标 (ROI 跟随、多分辨率结果对比时使用)
+    cv::Point2f toSensor(const cv::Point2f& point) const {
+        return cv::Point2f(sensorRect.x + point.x * pixelStep, sensorRect.y + point.y * pixelStep);
+    }
+
+    // 从到达主机至今经过的毫秒数
+    double ageMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hostArrival).count();
+    }
+
+    bool hasHostExposure() const { return hostExposure.time_since_epoch().count() != 0; }
+
+    // 从曝光至今经过的毫秒数 (含传感器读出与传输)，即“镜头到屏幕”的真实延迟；曝光时刻未知时退回 ageMs()
+    double exposureAgeMs() const {
+        if (!hasHostExposure()) return ageMs();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hostExposure).count();
+    }
+
+    /**
+     * @brief 按指定格式取图：与 pixelFormat 相同时直接返回 image()，否则转换一次后缓存在帧上
+     * @details Bayer 源走 BayerDemosaic (双线性)，其余走 cv::cvtColor；线程安全。
+     * @return 无法转换 (例如把 RGB 转回 Bayer、源格式未知) 时返回空 Mat
+     * @note 返回的 Mat 与缓存共享内存，调用方只能读，需要修改请先 clone()
+     */
+    cv::Mat toFormat(PixelFormat format) const;
+
+private:
+    cv::Mat m_image;
+    FrameConversionRef m_conversions;
+};
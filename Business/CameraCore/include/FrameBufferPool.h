@@ -0,0 +1,56 @@
+﻿// Business/CameraCore/include/FrameBufferPool.h
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstddef>
+
+// =========================================================
+// 帧缓冲池统计信息：用于排查“池子太小”或“消费者霸占图像不放”的问题
+// =========================================================
+struct FramePoolStats {
+    size_t slotCount = 0;     // 池中缓冲块总数
+    size_t slotBytes = 0;     // 当前单块容量 (字节)
+    size_t inUse = 0;         // 当前仍被消费者持有的块数
+    uint64_t acquired = 0;    // 累计从池中成功取出的次数
+    uint64_t exhausted = 0;   // 池子耗尽、被迫回退到普通堆内存的次数
+    uint64_t regrown = 0;     // 单块容量不足而重新分配的次数 (稳态下应为 0)
+};
+
+// =========================================================
+// FrameBufferPool：固定块数、页对齐的帧缓冲池
+// 作用：取代每帧一次的 cv::Mat::clone()，稳态取流时零堆分配、零多余拷贝。
+//
+// 原理：池子本身实现了 OpenCV 的 cv::MatAllocator。acquire() 交出去的 cv::Mat
+// 和普通 Mat 一样带引用计数，可以随意拷贝、跨线程传递；
+// 当最后一个持有者释放它时，OpenCV 会回调 deallocate()，缓冲块自动回到池中。
+// =========================================================
+class FrameBufferPool {
+public:
+    /**
+     * @param slotCount 缓冲块数量 (决定了最多能有多少帧同时“在路上”)
+     * @param slotBytes 每块的初始容量，可为 0，稍后通过 reserve() 预分配
+     */
+    explicit FrameBufferPool(size_t slotCount, size_t slotBytes = 0);
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    /**
+     * @brief 预分配：保证每个空闲块至少有 bytes 字节 (一般在打开设备、得知分辨率后调用一次)
+     */
+    void reserve(size_t bytes);
+
+    /**
+     * @brief 从池中取出一块缓冲，包装为 rows x cols 的 cv::Mat
+     * @note 池子耗尽时不会阻塞取流线程，而是回退为普通堆内存并计入 exhausted
+     */
+    cv::Mat acquire(int rows, int cols, int type);
+
+    FramePoolStats getStats() const;
+
+private:
+    class Allocator;          // 真正实现 cv::MatAllocator 的内部对象
+    Allocator* m_allocator;   // 池子析构时若仍有帧在外流通，由它自行延迟销毁
+};
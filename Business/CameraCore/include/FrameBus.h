@@ -0,0 +1,118 @@
+﻿// Business/CameraCore/include/FrameBus.h
+#pragma once
+
+#include "Frame.h"
+#include "FrameRateLimiter.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 订阅者的队列满了怎么办
+enum class BackpressurePolicy {
+    DROP_OLDEST,   // 挤掉队列里最旧的一帧 (预览、实时分析：只关心最新画面)
+    DROP_NEWEST,   // 丢掉新来的这一帧 (想要一段连续帧，宁可晚点断开也不要跳着拿)
+    BLOCK          // 让发布方等待 blockTimeout，仍然没有空位才丢 (录像：尽量不丢帧)
+};
+
+struct FrameSubscription {
+    std::string name;                               // 统计与日志里显示的名字
+    size_t depth = 2;                               // 队列容量 (最多积压多少帧)
+    BackpressurePolicy policy = BackpressurePolicy::DROP_OLDEST;
+    std::chrono::milliseconds blockTimeout{ 20 };   // 仅 BLOCK：发布方最多等这么久
+    double targetFps = 0.0;                         // 入队前先按帧率抽稀，<= 0 表示每帧都要
+};
+
+// 每个订阅者一份：队列深度与各类丢帧分开计数，一眼看出是谁跟不上
+struct FrameBusSubscriberStats {
+    std::string name;
+    BackpressurePolicy policy = BackpressurePolicy::DROP_OLDEST;
+    size_t queueDepth = 0;      // 当前排队的帧数
+    size_t queueCapacity = 0;
+    size_t peakDepth = 0;       // 历史最大排队深度
+    uint64_t passed = 0;        // 通过帧率抽稀、尝试入队的帧数
+    uint64_t skipped = 0;       // 为满足目标帧率而跳过的帧数 (不算丢帧)
+    uint64_t delivered = 0;     // 已交给回调的帧数
+    uint64_t droppedOldest = 0; // DROP_OLDEST：被挤掉的旧帧
+    uint64_t droppedNewest = 0; // DROP_NEWEST：进不了队列的新帧
+    uint64_t blockTimeouts = 0; // BLOCK：等满 blockTimeout 仍没有空位而丢掉的帧
+    double blockedMs = 0.0;     // BLOCK：发布方累计等待的毫秒数
+    uint64_t dropped() const { return droppedOldest + droppedNewest + blockTimeouts; }
+};
+
+// 在订阅者自己的交付线程上调用 (与 ICamera 的 FrameCallback 同型)
+using FrameBusCallback = std::function<void(const Frame&)>;
+
+// =========================================================
+// FrameBus：一路帧流分发给多个订阅者 (预览、分析、录像 ...)
+// 每个订阅者有自己的有界队列、背压策略与交付线程：慢的订阅者只会让自己丢帧，
+// 不会拖慢发布方，也不会拖慢别的订阅者 (BLOCK 策略除外，它本来就是要让发布方等；
+// 但它只让发布方等，同一帧先交给其他订阅者，等待期间也不占总线锁)。
+//
+// 零拷贝：入队的是 Frame (cv::Mat 与转换缓存只增加引用计数)，所有订阅者共享同一份像素；
+//        被抽稀跳过的帧连引用计数都不加。
+// 线程：publish() 通常在相机回调线程上调用；回调在各自订阅者的交付线程上、按发布顺序调用。
+//      subscribe()/unsubscribe() 可在任意线程调用，但不能在回调里调用。
+// =========================================================
+class FrameBus {
+public:
+    FrameBus();
+    // 退订全部订阅者 (积压的帧直接丢弃)
+    ~FrameBus();
+
+    FrameBus(const FrameBus&) = delete;
+    FrameBus& operator=(const FrameBus&) = delete;
+
+    // 返回订阅号 (从 1 开始)
+    int subscribe(const FrameSubscription& subscription, FrameBusCallback callback);
+
+    // 积压的帧直接丢弃；返回后回调不会再被调用 (正在发布的帧也不会再入队)
+    void unsubscribe(int id);
+    void unsubscribeAll();
+
+    // 取流中调整某个订阅者的目标帧率
+    void setTargetFps(int id, double targetFps);
+
+    // 发布一帧：按各订阅者的帧率与背压策略入队 (不阻塞的订阅者先入队，BLOCK 订阅者最后)
+    void publish(const Frame& frame);
+
+    FrameBusSubscriberStats getStats(int id) const;
+    std::vector<FrameBusSubscriberStats> getAllStats() const;
+
+private:
+    struct Subscriber {
+        Subscriber(int subscriberId, const FrameSubscription& config, FrameBusCallback cb)
+            : id(subscriberId), subscription(config), limiter(config.targetFps), callback(std::move(cb)) {}
+        const int id;
+        const FrameSubscription subscription;
+        FrameRateLimiter limiter;
+        const FrameBusCallback callback;
+
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<Frame> queue;
+        bool running = true;
+        std::thread worker;
+        FrameBusSubscriberStats stats;   // 不含 passed/skipped (在 limiter 里)
+    };
+
+    void enqueue(Subscriber& subscriber, const Frame& frame);
+    static void deliverLoop(Subscriber* subscriber);
+    static void stop(Subscriber& subscriber);
+    FrameBusSubscriberStats snapshot(Subscriber& subscriber) const;
+
+private:
+    // 只保护订阅者列表：发布方在锁内拷一份 shared_ptr 就放开，入队与 BLOCK 等待都在锁外
+    // (退订后发布方手里的那份只会看到 running == false，不会再入队)
+    mutable std::mutex m_mutex;
+    std::list<std::shared_ptr<Subscriber>> m_subscribers;
+    int m_nextId;
+};
@@ -0,0 +1,46 @@
+﻿// Business/CameraCore/include/FrameRateLimiter.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct FrameRateLimiterStats {
+    uint64_t passed = 0;     // 放行的帧数
+    uint64_t skipped = 0;    // 为满足目标帧率而跳过的帧数
+};
+
+// =========================================================
+// FrameRateLimiter：把一路帧流按目标帧率抽稀 (预览 30 fps、归档 1 fps ...)
+// 按帧的到达时刻判断，不看帧号：相机帧率变化、偶尔丢帧都不影响输出节拍。
+//
+// 节拍：放行后把下一个允许时刻推后一个目标周期 (绝对时刻，不累积漂移)；
+//      判断时放宽半个源帧间隔，60 -> 30 fps 时恰好隔一帧放一帧，而不是被抖动打乱。
+// 线程：accept() 应始终在同一条线程 (相机回调线程) 上调用；
+//      setTargetFps() 与 getStats() 可在任意线程调用。
+// =========================================================
+class FrameRateLimiter {
+public:
+    // targetFps <= 0 表示不限，每帧都放行
+    explicit FrameRateLimiter(double targetFps = 0.0);
+
+    void setTargetFps(double fps);
+    double targetFps() const;
+
+    // 该帧是否交给下游；返回 false 的帧下游不应再做任何转换或拷贝
+    bool accept(std::chrono::steady_clock::time_point arrival);
+
+    FrameRateLimiterStats getStats() const;
+
+private:
+    std::atomic<double> m_targetFps;
+
+    // 以下仅 accept() 所在线程访问
+    bool m_started;
+    std::chrono::steady_clock::time_point m_nextDue;   // 下一帧最早可以放行的时刻
+    std::chrono::steady_clock::time_point m_lastArrival;
+    std::chrono::steady_clock::duration m_sourceInterval; // 源帧间隔的平滑估计
+
+    std::atomic<uint64_t> m_passed;
+    std::atomic<uint64_t> m_skipped;
+};
@@ -0,0 +1,99 @@
+﻿// Business/CameraCore/include/FrameSynchronizer.h
+#pragma once
+
+#include "Frame.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// 组帧依据
+enum class SyncPolicy {
+    TRIGGER_ID,       // 按 Frame::triggerId 组帧：同一次触发的帧为一组 (要求各相机同时开始取流、共用触发源)
+    TIMESTAMP_WINDOW  // 按到达主机的时刻组帧：落在同一时间窗内的帧为一组 (连续采集或触发计数不可用时)
+};
+
+struct SyncConfig {
+    SyncPolicy policy = SyncPolicy::TRIGGER_ID;
+    std::chrono::microseconds window{ 5000 };     // TIMESTAMP_WINDOW：同组帧到达时刻的最大跨度
+    std::chrono::milliseconds timeout{ 200 };     // 一组从第一帧到达起等这么久仍未凑齐，即判为残组
+    bool deliverIncomplete = false;               // 残组是否也交付 (缺失的相机位置为空帧)
+};
+
+// =========================================================
+// FrameSet：同一时刻 (同一次触发) 各相机的一组帧
+// =========================================================
+struct FrameSet {
+    uint64_t setId = 0;          // 交付序号 (从 1 开始，残组不交付时也占号，便于发现断层)
+    uint64_t triggerId = 0;      // TRIGGER_ID 模式下的触发计数
+    std::vector<Frame> frames;   // 按相机下标排列，缺失的位置为空帧
+    bool complete = false;
+    double skewMs = 0.0;         // 组内最早与最晚到达的帧之间的间隔
+
+    size_t missingCount() const {
+        size_t missing = 0;
+        for (const Frame& frame : frames) missing += frame.empty() ? 1 : 0;
+        return missing;
+    }
+};
+
+// 同步统计：判断是哪台相机在漏触发
+struct SyncStats {
+    uint64_t completeSets = 0;              // 凑齐交付的组数
+    uint64_t incompleteSets = 0;            // 超时未凑齐的组数
+    uint64_t lateFrames = 0;                // 所属组已超时判定后才到达、被丢弃的帧
+    uint64_t duplicateFrames = 0;           // 同一组内同一相机重复到达的帧
+    size_t pendingSets = 0;                 // 正在等待凑齐的组数
+    double maxSkewMs = 0.0;                 // 完整组的最大组内时差
+    std::vector<uint64_t> missingByCamera;  // 每台相机在残组中缺席的次数
+};
+
+using FrameSetCallback = std::function<void(const FrameSet&)>;
+
+// =========================================================
+// FrameSynchronizer：把 N 台相机各自回调上来的帧按触发号/时间窗拼成一组，凑齐后交付一次
+// 线程安全：各相机的回调线程直接调用 push()。
+// 交付回调在送来最后一帧的那个线程上、持锁执行，应尽快返回，且不能在回调里再调用 push()。
+// =========================================================
+class FrameSynchronizer {
+public:
+    FrameSynchronizer(size_t cameraCount, const SyncConfig& config = SyncConfig());
+
+    void setCallback(FrameSetCallback callback);
+
+    // 送入第 cameraIndex 台相机的一帧；顺带检查并结算已超时的组
+    void push(size_t cameraIndex, const Frame& frame);
+
+    // 结算所有未凑齐的组，并清空迟到判定 (停流时调用：避免最后几组永远挂起，重新取流后触发号会从头计)
+    void flush();
+
+    SyncStats getStats() const;
+    size_t cameraCount() const { return m_cameraCount; }
+
+private:
+    struct PendingSet {
+        uint64_t triggerId = 0;
+        std::chrono::steady_clock::time_point anchor;  // 第一帧的到达时刻
+        std::chrono::steady_clock::time_point created; // 建组时刻 (超时从这里算)
+        std::vector<Frame> frames;
+        size_t received = 0;
+    };
+
+    // 以下均需持有 m_mutex
+    std::deque<PendingSet>::iterator findSet(size_t cameraIndex, const Frame& frame);
+    void deliver(PendingSet& set, bool complete);
+    void expire(std::chrono::steady_clock::time_point now);
+
+private:
+    const size_t m_cameraCount;
+    const SyncConfig m_config;
+    FrameSetCallback m_callback;
+
+    mutable std::mutex m_mutex;
+    std::deque<PendingSet> m_pending;   // 按建组先后排列
+    uint64_t m_nextSetId;
+    uint64_t m_expiredTriggerId;        // 已超时结算的最大触发号，之后到达的同号帧视为迟到
+    bool m_hasExpired;
+    SyncStats m_stats;
+};
@@ -4,6 +4,11 @@
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include <functional>
+#include <algorithm>
+#include "FrameBufferPool.h"
+#include "Frame.h"
+#include "AsyncFrameDispatcher.h"
+#include "ClockCorrelator.h"
 
 // =========================================================
 // 相机状态枚举：规范化错误处理，避免只返回 true/false
@@ -18,6 +23,96 @@ enum class CameraStatus {
     UNKNOWN_ERROR       // 未知错误
 };
 
+// =========================================================
+// 取图模式：决定图像由谁、在哪个线程交到上层手里
+// =========================================================
+enum class AcquisitionMode {
+    PUSH,   // SDK 采集线程直接回调 (默认)
+    PULL    // 相机内部自有抓图线程主动拉取，上层可用 grabFrame() 同步等待指定帧
+};
+
+// =========================================================
+// 取流策略：决定 SDK 输出缓存里积压的图像按什么顺序交出来
+// =========================================================
+enum class GrabStrategy {
+    ONE_BY_ONE,          // 从旧到新逐帧交付，绝不主动丢帧 (录像)
+    LATEST_IMAGES_ONLY,  // 只交最新一帧，清空积压，延迟最低 (实时预览)
+    LATEST_IMAGES        // 只保留最新的 N 帧 (N 即输出队列深度)
+};
+
+// =========================================================
+// 触发模式：决定一帧何时开始曝光
+// =========================================================
+enum class TriggerMode {
+    FREE_RUN,   // 连续采集，按相机自身帧率出图 (默认)
+    SOFTWARE,   // 软触发：每调用一次 triggerSoftware() 采一帧
+    HARDWARE    // 硬触发：外部输入线 (Line0 ~ Line3) 上每个信号沿采一帧，多相机共用一根线即可严格同步
+};
+
+// =========================================================
+// 传感器读出区域 (ROI)：只传输、只转换需要的那一块
+// 坐标与尺寸均以传感器全幅、未合并 (binning/decimation 之前) 的像素为单位
+// =========================================================
+struct SensorRoi {
+    int offsetX = 0;
+    int offsetY = 0;
+    int width = 0;      // 0 表示一直到传感器右边缘
+    int height = 0;     // 0 表示一直到传感器下边缘
+
+    bool operator==(const SensorRoi& other) const {
+        return offsetX == other.offsetX && offsetY == other.offsetY && width == other.width && height == other.height;
+    }
+    bool operator!=(const SensorRoi& other) const { return !(*this == other); }
+};
+
+// 传感器几何约束：ROI 必须落在全幅之内并按步进对齐
+struct SensorGeometry {
+    int maxWidth = 0;           // 全幅尺寸
+    int maxHeight = 0;
+    int minWidth = 1;
+    int minHeight = 1;
+    int widthStep = 1;          // Width / Height 的步进
+    int heightStep = 1;
+    int offsetXStep = 1;        // OffsetX / OffsetY 的步进
+    int offsetYStep = 1;
+    bool liveOffset = false;    // true：取流中可直接平移 ROI (只改 OffsetX/OffsetY)，无需停流
+
+    // 把任意 ROI 规整为传感器可接受的值：偏移向下、尺寸向上对齐步进，超出边缘时整体往回挪
+    SensorRoi align(const SensorRoi& roi) const {
+        auto down = [](int v, int step) { return step > 1 ? v / step * step : v; };
+        auto up = [](int v, int step) { return step > 1 ? (v + step - 1) / step * step : v; };
+
+        SensorRoi result;
+        result.width = roi.width > 0 ? std::min(maxWidth, std::max(minWidth, up(roi.width, widthStep))) : maxWidth;
+        result.height = roi.height > 0 ? std::min(maxHeight, std::max(minHeight, up(roi.height, heightStep))) : maxHeight;
+        result.width = down(result.width, widthStep);
+        result.height = down(result.height, heightStep);
+        result.offsetX = down(std::max(0, std::min(roi.offsetX, maxWidth - result.width)), offsetXStep);
+        result.offsetY = down(std::max(0, std::min(roi.offsetY, maxHeight - result.height)), offsetYStep);
+        return result;
+    }
+};
+
+// =========================================================
+// 相机参数快照：一次批量读出各节点的当前值与范围，缓存起来供界面/服务层反复查询
+// =========================================================
+struct ParamRange {
+    double current = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double increment = 0.0;     // 0 表示连续取值 (浮点节点)
+    bool available = false;     // 设备没有该节点或读取失败时为 false
+};
+
+struct CameraParams {
+    ParamRange exposureTime;    // 曝光时间 (us)
+    ParamRange gain;            // 增益 (dB)
+    ParamRange width;           // 当前输出宽度 (像素，已计入 ROI/合并/抽样)
+    ParamRange height;
+    ParamRange frameRate;       // 采集帧率 (fps，AcquisitionFrameRate)
+    uint64_t revision = 0;      // 每次从设备重新读取后递增，可据此判断快照是否更新过
+};
+
 // =========================================================
 // 相机设备信息：用于在界面下拉框中展示可用的相机
 // =========================================================
@@ -32,9 +127,32 @@ struct CameraInfo {
     }
 };
 
+// =========================================================
+// 像素格式协商结果：输出格式由谁产出、主机转换花了多少时间
+// =========================================================
+struct FormatNegotiation {
+    PixelFormat requested = PixelFormat::UNKNOWN; // 上层要求的输出格式 (UNKNOWN 表示自动)
+    PixelFormat sensor = PixelFormat::UNKNOWN;    // 传感器当前的输出格式
+    bool nativeOutput = false;                    // true：传感器直出，主机零转换
+    bool inHouseDemosaic = false;                 // true：Bayer 由自研 SIMD 引擎转换，而非厂商 ISP
+    uint64_t convertedFrames = 0;                 // 经过主机转换的帧数
+    double avgConvertMs = 0.0;                    // 主机转换平均耗时 (毫秒/帧)
+    double lastConvertMs = 0.0;                   // 最近一帧的主机转换耗时
+};
+
 // 定义一个标准的纯 C++ 回调函数签名
-// 意思是：我需要一个函数，它接收一个 cv::Mat，并且没有返回值
-using FrameCallback = std::function<void(const cv::Mat&)>;
+// 意思是：我需要一个函数，它接收一帧 Frame (图像 + 帧号/时间戳/丢包信息)，并且没有返回值
+using FrameCallback = std::function<void(const Frame&)>;
+
+// 设备连接事件：USB 抖动、线缆松动时由驱动自动重连
+enum class DeviceEvent {
+    DISCONNECTED,       // 设备意外断开，驱动开始自动重连
+    RECONNECTED,        // 已重新打开设备、恢复断线前的参数并继续取流
+    RECONNECT_FAILED    // 超过重连时限仍未恢复，需要人工处理
+};
+
+// outageMs：从断线到此刻经过的毫秒数 (DISCONNECTED 时为 0)
+using DeviceEventCallback = std::function<void(DeviceEvent event, double outageMs)>;
 
 // =========================================================
 // ICamera 核心设备接口 (Business 层契约)
@@ -68,6 +186,15 @@ public:
      */
     virtual CameraStatus closeDevice() = 0;
 
+    /**
+     * @brief 注册设备连接事件回调 (断线 / 重连成功 / 重连失败)
+     * @note 回调运行在驱动内部的线程上，应尽快返回，且不能在回调里调用 closeDevice()
+     */
+    virtual void registerDeviceEventCallback(DeviceEventCallback callback) {}
+
+    // 设备当前是否在线 (断线重连期间为 false)
+    virtual bool isConnected() const { return true; }
+
     // ---------------------------------------------------------
     // 2. 视频流控制
     // ---------------------------------------------------------
@@ -110,14 +237,172 @@ public:
     // 获取当前相机支持的最大增益极限
     virtual float getMaxGain() = 0;
 
+    /**
+     * @brief 参数快照 (当前值/最小/最大/步进)
+     * @details 实现应一次批量读取并缓存，写参数或设备事件后失效、下次调用时重新读取；
+     *          界面与服务层应读快照，而不是逐个调用上面的 getter 去访问设备。
+     * @note 默认实现用上面的 getter 现拼一份，不缓存
+     */
+    virtual CameraParams getParams() {
+        CameraParams params;
+        params.exposureTime.current = getExposureTime();
+        params.exposureTime.available = true;
+        params.gain.current = getGain();
+        params.gain.max = getMaxGain();
+        params.gain.available = true;
+        return params;
+    }
+
+    // 丢弃缓存的快照 (设备事件、外部改动了参数时调用)，下一次 getParams() 重新从设备读取
+    virtual void invalidateParams() {}
+
+    /**
+     * @brief 设置连续采集时传感器的出图帧率 (AcquisitionFrameRate)
+     * @param fps 目标帧率；<= 0 表示取消限制，按曝光与带宽允许的最高帧率采集
+     * @note 实际帧率还受曝光时间与链路带宽约束，以 getParams().frameRate 回读为准
+     */
+    virtual CameraStatus setFrameRate(double fps) { return CameraStatus::PARAM_SET_FAILED; }
+
     // ---------------------------------------------------------
     // 4. 同步图像获取 (可选)
     // ---------------------------------------------------------
     /**
      * @brief 主动拉取一帧图像（适用于单线程或特定算法同步等待的场景）
-     * @param outFrame [out] 传出的 OpenCV 矩阵数据
+     * @param outFrame [out] 传出的 OpenCV 矩阵数据 (黑白或 RGB)，保证是调用之后才到达的新帧
      * @param timeoutMs 超时时间(毫秒)
      * @return 是否成功获取
      */
     virtual bool grabFrame(cv::Mat& outFrame, int timeoutMs = 1000) = 0;
+
+    /**
+     * @brief 同上，但连同帧号、时间戳、丢包数一起传出
+     * @note 默认实现只能填充图像与到达时刻，能拿到 SDK 帧信息的实现应当重写
+     */
+    virtual bool grabFrame(Frame& outFrame, int timeoutMs = 1000) {
+        outFrame = Frame{};
+        cv::Mat image;
+        bool ok = grabFrame(image, timeoutMs);
+        outFrame.setImage(image);
+        outFrame.hostArrival = std::chrono::steady_clock::now();
+        return ok;
+    }
+
+    /**
+     * @brief 切换取图模式 (回调推送 / 主动拉取)，取流过程中也可切换，无需重新打开设备
+     * @note 不支持拉取模式的实现保持默认即可
+     */
+    virtual CameraStatus setAcquisitionMode(AcquisitionMode mode) {
+        return mode == AcquisitionMode::PUSH ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual AcquisitionMode getAcquisitionMode() const { return AcquisitionMode::PUSH; }
+
+    /**
+     * @brief 设置取流策略与输出队列深度，取流过程中即可生效，无需重新打开设备
+     * @param strategy 取流策略
+     * @param queueSize 输出队列深度，仅 LATEST_IMAGES 策略使用 (范围 >= 1)
+     */
+    virtual CameraStatus setGrabStrategy(GrabStrategy strategy, unsigned int queueSize = 1) {
+        return strategy == GrabStrategy::ONE_BY_ONE ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual GrabStrategy getGrabStrategy() const { return GrabStrategy::ONE_BY_ONE; }
+
+    /**
+     * @brief 指定输出像素格式 (MONO8 / RGB8 / BGR8 / BAYER_xx8)
+     * @details 优先让传感器直接输出该格式 (零主机转换)，传感器做不到时才回退为主机转换；
+     *          要求 Bayer 原始数据而传感器不支持时返回 PARAM_SET_FAILED。
+     *          传入 UNKNOWN 恢复默认：按传感器原始格式交付 (零主机转换)，
+     *          各消费者再通过 Frame::toFormat() 按需转换。
+     */
+    virtual CameraStatus setOutputFormat(PixelFormat format) {
+        return format == PixelFormat::UNKNOWN ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual PixelFormat getOutputFormat() const { return PixelFormat::UNKNOWN; }
+
+    // 查询格式协商结果与主机转换开销
+    virtual FormatNegotiation getFormatNegotiation() const { return FormatNegotiation{}; }
+
+    /**
+     * @brief 选择主机端 Bayer 转换引擎 (仅在需要主机转换时生效，可在取流中切换)
+     * @param inHouse true：使用 CommonVision 的多线程 SIMD 引擎；false：交给相机厂商的转换函数
+     * @param quality 自研引擎的插值质量
+     * @note 没有厂商转换函数的实现 (如模拟相机) 应始终使用自研引擎
+     */
+    virtual CameraStatus setHostDemosaic(bool inHouse, DemosaicQuality quality = DemosaicQuality::BILINEAR) {
+        return inHouse ? CameraStatus::PARAM_SET_FAILED : CameraStatus::SUCCESS;
+    }
+
+    /**
+     * @brief 设置触发模式，可在打开设备前调用 (打开时下发)
+     * @param mode 连续采集 / 软触发 / 硬触发
+     * @param line 硬触发使用的输入线编号 (0 ~ 3)，其他模式忽略
+     * @note 触发模式下 Frame::triggerId 为设备的触发计数，多相机据此组帧 (见 FrameSynchronizer)
+     */
+    virtual CameraStatus setTriggerMode(TriggerMode mode, int line = 0) {
+        return mode == TriggerMode::FREE_RUN ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual TriggerMode getTriggerMode() const { return TriggerMode::FREE_RUN; }
+
+    /**
+     * @brief 发出一次软触发
+     * @return 非软触发模式返回 PARAM_SET_FAILED；未在取流返回 STREAM_FAILED (触发会被相机丢弃)
+     */
+    virtual CameraStatus triggerSoftware() { return CameraStatus::PARAM_SET_FAILED; }
+
+    // ---------------------------------------------------------
+    // 5. 传感器读出区域、合并与抽样 (可选)
+    // 缩小读出区域能同时减少 USB 带宽与主机转换量，并提高可达帧率
+    // ---------------------------------------------------------
+    /**
+     * @brief 设置传感器 ROI (会按 getSensorGeometry() 的步进自动对齐)
+     * @details 只平移且 liveOffset 为 true 时取流中直接生效；改变尺寸时，
+     *          实现只在 SDK 要求的情况下短暂停止取流，不重新打开设备。
+     */
+    virtual CameraStatus setRoi(const SensorRoi& roi) { return CameraStatus::PARAM_SET_FAILED; }
+
+    // 当前生效的 ROI (已对齐；不支持 ROI 的实现返回全 0)
+    virtual SensorRoi getRoi() const { return SensorRoi{}; }
+
+    virtual SensorGeometry getSensorGeometry() const { return SensorGeometry{}; }
+
+    /**
+     * @brief 像素合并 (binning)：相邻 factor x factor 个像素合成一个，提高灵敏度、缩小图像
+     * @note 合并与抽样都会改变输出尺寸，通常需要短暂停止取流
+     */
+    virtual CameraStatus setBinning(int factor) {
+        return factor == 1 ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual int getBinning() const { return 1; }
+
+    // 抽样 (decimation)：每 factor 行/列只读出一行/列
+    virtual CameraStatus setDecimation(int factor) {
+        return factor == 1 ? CameraStatus::SUCCESS : CameraStatus::PARAM_SET_FAILED;
+    }
+
+    virtual int getDecimation() const { return 1; }
+
+    // ---------------------------------------------------------
+    // 6. 运行诊断 (可选)
+    // ---------------------------------------------------------
+    /**
+     * @brief 查询帧缓冲池的使用情况 (池大小、占用数、耗尽次数)
+     * @note 没有使用缓冲池的实现保持默认空统计即可
+     */
+    virtual FramePoolStats getFramePoolStats() const { return FramePoolStats{}; }
+
+    /**
+     * @brief 查询转换队列的使用情况 (排队深度、溢出丢帧、交付数)
+     * @note 在采集线程上直接转换与回调的实现保持默认空统计即可
+     */
+    virtual DispatchStats getDispatchStats() const { return DispatchStats{}; }
+
+    /**
+     * @brief 查询设备时钟与主机时钟的拟合情况 (是否锁定、时钟频率、到达抖动)
+     * @note 拿不到设备时间戳的实现保持默认空统计即可，此时 Frame::hostExposure 始终为默认值
+     */
+    virtual ClockCorrelationStats getClockStats() const { return ClockCorrelationStats{}; }
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿// Business/CameraCore/include/LatestFrameMailbox.h
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <mutex>
+
+struct MailboxStats {
+    uint64_t posted = 0;        // 放进信箱的帧数
+    uint64_t taken = 0;         // 被取走 (真正显示) 的帧数
+    uint64_t overwritten = 0;   // 还没被取走就被新帧覆盖的帧数 (消费方忙不过来)
+};
+
+// =========================================================
+// LatestFrameMailbox：只有一个格子的信箱，生产方放、消费方取
+// 用来替代跨线程的排队信号：消费方 (UI 线程) 忙的时候，新帧直接覆盖旧帧，
+// 积压永远不超过一帧，内存不涨，画面也不会越落越远。
+//
+// 通知：post() 只在信箱由空变满时返回 true，生产方此时发一次通知即可；
+//      消费方被通知后 take() 取到的总是最新的一帧。这样事件队列里最多只有一个待处理的通知。
+// 线程：post() 与 take() 可在任意线程调用 (临界区只交换一个 cv::Mat 头)。
+// =========================================================
+class LatestFrameMailbox {
+public:
+    /**
+     * @brief 放入一帧，覆盖尚未取走的旧帧
+     * @return true 表示信箱原来是空的，生产方需要通知消费方
+     */
+    bool post(const cv::Mat& image);
+
+    // 取走最新的一帧；信箱为空时返回 false
+    bool take(cv::Mat& image);
+
+    MailboxStats getStats() const;
+
+private:
+    mutable std::mutex m_mutex;
+    cv::Mat m_slot;
+    bool m_full = false;
+    MailboxStats m_stats;
+};
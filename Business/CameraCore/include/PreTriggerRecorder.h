@@ -0,0 +1,126 @@
+﻿// Business/CameraCore/include/PreTriggerRecorder.h
+#pragma once
+
+#include "Frame.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PreTriggerConfig {
+    size_t capacityBytes = 256u << 20;               // 环形缓冲总字节数 (构造时一次性分配，之后不再分配)
+    std::chrono::milliseconds preTrigger{ 3000 };    // 事件发生前保留多久
+    std::chrono::milliseconds postTrigger{ 500 };    // 事件发生后再录多久才冻结
+    size_t handoffDepth = 8;                         // 交接队列深度：拷贝线程跟不上时最多压住这么多帧
+};
+
+struct PreTriggerStats {
+    size_t capacityBytes = 0;
+    size_t bufferedBytes = 0;     // 环形缓冲里的帧占用的字节数
+    size_t bufferedFrames = 0;
+    double bufferedSeconds = 0.0; // 缓冲里最早一帧到最新一帧的时间跨度
+    uint64_t pushed = 0;          // 送进来的帧数
+    uint64_t handoffDropped = 0;  // 交接队列满时丢掉的帧 (拷贝线程跟不上)
+    uint64_t overrunFrames = 0;   // 缓冲被待写盘的窗口占满、没能存下的帧 (磁盘跟不上)
+    uint64_t oversizeFrames = 0;  // 单帧比整个缓冲还大
+    uint64_t events = 0;          // 触发的事件数
+    uint64_t flushedFrames = 0;   // 已写盘的帧数
+    uint64_t flushedBytes = 0;
+    size_t pendingEvents = 0;     // 已触发、尚未写完的事件数
+};
+
+// 一个事件窗口写盘结束：文件路径、写入的帧数、是否成功
+using EventFlushedCallback = std::function<void(const std::string& path, uint64_t frames, bool ok)>;
+
+// =========================================================
+// PreTriggerRecorder：事件前后的原始帧“黑匣子”
+// 始终把最近 preTrigger 时长的原始帧拷进一块预分配的环形缓冲 (按字节而不是帧数限量，
+// 分辨率、格式、ROI 变了也不会超)；事件发生时冻结这一段，另起线程写成原始录像 (.ocvraw)，
+// 期间采集照常进行。
+//
+// 线程：push() 只把帧 (引用计数) 放进交接队列，由拷贝线程拷进环形缓冲，
+//      帧缓冲池的缓冲很快就能回到池里，调用方也不承担拷贝耗时；
+//      写盘线程边写边释放已写完的帧，新帧紧跟着就能复用这些空间。
+//      缓冲被尚未写完的窗口占满时，新帧只是进不了缓冲 (计入 overrunFrames)，不会阻塞任何线程。
+//      字节上限装不下整个窗口时，冻结前缓冲照常滚动，保留离冻结时刻最近的那部分。
+// =========================================================
+class PreTriggerRecorder {
+public:
+    explicit PreTriggerRecorder(const PreTriggerConfig& config = PreTriggerConfig());
+    // 等已触发的事件写完再退出
+    ~PreTriggerRecorder();
+
+    PreTriggerRecorder(const PreTriggerRecorder&) = delete;
+    PreTriggerRecorder& operator=(const PreTriggerRecorder&) = delete;
+
+    // 送入一帧 (任意线程，永不阻塞)；图像须为 8 位 (与 RawRecordingWriter 相同)
+    void push(const Frame& frame);
+
+    /**
+     * @brief 触发一个事件：postTrigger 之后冻结 [事件 - preTrigger, 事件 + postTrigger] 内的帧并写入 path
+     * @return false 表示缓冲里还没有任何帧
+     */
+    bool trigger(const std::string& path);
+
+    // 写盘结束的通知 (在写盘线程上调用)，需在 trigger() 之前设置
+    void setFlushCallback(EventFlushedCallback callback);
+
+    PreTriggerStats getStats() const;
+
+private:
+    // 环形缓冲里的一帧：像素在 m_arena[offset, offset + bytes)，其余是帧的“身世”
+    struct Record {
+        uint64_t seq;
+        size_t offset;
+        size_t bytes;
+        Frame meta;   // image 为空，只带元数据
+        int rows;
+        int cols;
+        int type;
+    };
+
+    // 一个待写盘的事件窗口
+    struct FlushJob {
+        std::string path;
+        std::chrono::steady_clock::time_point freezeAt; // 到这一时刻冻结窗口
+        uint64_t firstSeq;   // 窗口内第一帧
+        uint64_t lastSeq;    // 窗口末尾 (不含，冻结时确定)
+        uint64_t nextSeq;    // 下一帧要写的 (之前的已写完、可以释放)
+        bool frozen;
+    };
+
+    void copyLoop();
+    void flushLoop();
+
+    // 以下均需持有 m_mutex
+    bool allocateLocked(size_t bytes, size_t& offset);
+    uint64_t pinFloorLocked(bool frozenOnly) const;  // 序号不小于它的帧还没写盘，不能淘汰
+    void evictExpiredLocked(std::chrono::steady_clock::time_point now);
+    const Record* findLocked(uint64_t seq) const;
+
+private:
+    const PreTriggerConfig m_config;
+    std::vector<uchar> m_arena;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_copyCond;
+    std::condition_variable m_flushCond;
+    bool m_running;
+
+    std::deque<Frame> m_handoff;
+    std::deque<Record> m_records;        // 按序号排列，序号连续
+    uint64_t m_nextSeq;
+    size_t m_head;                       // 下一帧从这里开始写
+    size_t m_bufferedBytes;
+    std::deque<FlushJob> m_jobs;
+    EventFlushedCallback m_flushCallback;
+    PreTriggerStats m_stats;
+
+    std::thread m_copyThread;
+    std::thread m_flushThread;
+};
@@ -0,0 +1,105 @@
+﻿// Business/CameraCore/include/RawRecording.h
+#pragma once
+
+#include "Frame.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// =========================================================
+// 原始录像文件格式 (.ocvraw)：无损保存传感器原始帧及其“身世”，用于现场问题复现
+//
+//   文件头   RawFileHeader
+//   帧 0     RawFrameHeader + dataBytes 字节像素 (按行紧密排列，无填充)
+//   帧 1     ...
+//
+// 所有字段按小端序 (x86/ARM 本机序) 原样写入；帧头自带魔数，文件尾部残缺
+// (例如录制中途断电) 时读取端只会丢掉最后一个不完整的帧。
+// =========================================================
+#pragma pack(push, 1)
+struct RawFileHeader {
+    char magic[8];              // "OCVRAW01"
+    uint32_t version;           // 格式版本，当前为 1
+    uint32_t reserved;
+};
+
+struct RawFrameHeader {
+    uint32_t magic;             // kRawFrameMagic
+    uint32_t pixelFormat;       // PixelFormat 枚举值
+    uint32_t width;
+    uint32_t height;
+    uint64_t frameNumber;
+    uint64_t deviceTimestamp;
+    int64_t hostTimeNs;         // 到达主机的时刻，相对录像第一帧 (纳秒)
+    uint32_t lostPackets;
+    uint32_t dataBytes;
+};
+#pragma pack(pop)
+
+constexpr uint32_t kRawFrameMagic = 0x314D5246; // "FRM1"
+
+// =========================================================
+// RawRecordingWriter：顺序写入原始帧
+// =========================================================
+class RawRecordingWriter {
+public:
+    RawRecordingWriter() = default;
+    ~RawRecordingWriter();
+
+    RawRecordingWriter(const RawRecordingWriter&) = delete;
+    RawRecordingWriter& operator=(const RawRecordingWriter&) = delete;
+
+    // 创建 (覆盖) 录像文件并写入文件头
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    // 追加一帧；图像必须是 8 位 (MONO8/RGB8/BGR8/Bayer)，非连续内存会按行写出
+    bool write(const Frame& frame);
+
+    uint64_t framesWritten() const { return m_framesWritten; }
+    uint64_t bytesWritten() const { return m_bytesWritten; }
+
+private:
+    std::ofstream m_file;
+    bool m_hasOrigin = false;
+    std::chrono::steady_clock::time_point m_origin; // 第一帧的到达时刻
+    uint64_t m_framesWritten = 0;
+    uint64_t m_bytesWritten = 0;
+};
+
+// =========================================================
+// RawRecordingReader：打开时扫描一遍帧头建立索引，之后可随机读取任意一帧
+// 线程安全：多个预取线程可以同时调用 read()
+// =========================================================
+class RawRecordingReader {
+public:
+    // 一帧在文件里的位置与元数据
+    struct Entry {
+        RawFrameHeader header;
+        uint64_t offset;        // 像素数据在文件中的偏移
+    };
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t frameCount() const { return m_index.size(); }
+    const Entry& entry(size_t i) const { return m_index[i]; }
+
+    /**
+     * @brief 读取第 i 帧
+     * @param out [out] 图像与元数据 (hostArrival 不填，由回放方在交付时重新打点)
+     * @param image 可选：预先分配好的目标缓冲 (如帧缓冲池取出的 Mat)，尺寸类型匹配时直接写入
+     */
+    bool read(size_t i, Frame& out, cv::Mat image = cv::Mat());
+
+    // 快速判断文件是否为原始录像 (只看文件头)
+    static bool isRawRecording(const std::string& path);
+
+private:
+    std::ifstream m_file;
+    std::vector<Entry> m_index;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,53 @@
+﻿// Business/CameraCore/include/RoiFollower.h
+#pragma once
+
+#include "ICamera.h"
+#include <mutex>
+
+// ROI 跟随参数：全部以传感器全幅像素为单位
+struct RoiFollowConfig {
+    double marginRatio = 0.3;     // 目标四周留出的余量 (相对半径)，目标在余量内移动时 ROI 不动
+    int minMarginPx = 32;         // 余量下限：半径很小时也要留够移动空间
+    double shrinkRatio = 1.6;     // ROI 边长超过所需边长的这个倍数才收缩，避免在两个尺寸间来回跳
+    int lostFramesToReset = 15;   // 连续这么多帧没找到目标，恢复全幅重新搜索
+};
+
+struct RoiFollowStats {
+    uint64_t updates = 0;         // 送入的检测结果数
+    uint64_t moves = 0;           // 只平移 (取流中直接生效)
+    uint64_t resizes = 0;         // 改变尺寸 (可能短暂停流)
+    uint64_t resets = 0;          // 丢失目标后恢复全幅
+    SensorRoi current;            // 当前生效的 ROI
+};
+
+// =========================================================
+// RoiFollower：根据每帧的检测结果让传感器 ROI 跟着目标走
+// 只读出目标附近的一块，带宽与主机处理量随之下降。
+//
+// 策略：目标还在 ROI 的安全区内就不动；移出安全区时优先保持尺寸只平移
+//      (大多数传感器取流中即可生效)；只有装不下或明显过大时才改尺寸。
+// 线程：update() 应始终在同一条线程 (分析线程) 上调用，getStats() 可在任意线程调用。
+// =========================================================
+class RoiFollower {
+public:
+    explicit RoiFollower(ICamera* camera, const RoiFollowConfig& config = RoiFollowConfig());
+
+    // 送入一帧的检测结果 (圆心与半径为传感器全幅坐标，可用 Frame::toSensor 换算)；返回是否改动了 ROI
+    bool update(bool found, const cv::Point2f& center, float radius);
+
+    // 恢复全幅读出并清空丢失计数
+    void reset();
+
+    RoiFollowStats getStats() const;
+
+private:
+    bool apply(const SensorRoi& roi, uint64_t& counter);
+
+private:
+    ICamera* m_camera;
+    RoiFollowConfig m_config;
+    int m_lostFrames;
+
+    mutable std::mutex m_statsMutex;
+    RoiFollowStats m_stats;
+};
@@ -0,0 +1,134 @@
+﻿// Business/CameraCore/src/AsyncFrameDispatcher.cpp
+#include "AsyncFrameDispatcher.h"
+
+AsyncFrameDispatcher::AsyncFrameDispatcher(size_t capacity, unsigned int workers)
+    : m_capacity(capacity == 0 ? 1 : capacity),
+    m_workerCount(workers == 0 ? 1 : workers),
+    m_running(false),
+    m_nextTicket(0),
+    m_nextDelivery(0) {
+    m_stats.queueCapacity = m_capacity;
+    m_stats.workers = m_workerCount;
+}
+
+AsyncFrameDispatcher::~AsyncFrameDispatcher() {
+    stop();
+}
+
+void AsyncFrameDispatcher::start(Converter converter, Sink sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return;
+
+    m_converter = std::move(converter);
+    m_sink = std::move(sink);
+    m_queue.clear();
+    m_nextTicket = 0;
+    m_nextDelivery = 0;
+    m_running = true;
+
+    for (unsigned int i = 0; i < m_workerCount; i++) {
+        m_workers.emplace_back(&AsyncFrameDispatcher::workerLoop, this);
+    }
+}
+
+void AsyncFrameDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running && m_workers.empty()) return;
+        m_running = false;
+        m_queue.clear(); // 积压的原始帧直接丢弃，池化缓冲随之归还
+    }
+    m_notEmpty.notify_all();
+    m_turn.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+}
+
+bool AsyncFrameDispatcher::post(FrameJob job) {
+    bool overflow = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return false;
+
+        if (m_queue.size() >= m_capacity) {
+            m_queue.pop_front();
+            m_stats.dropped++;
+            overflow = true;
+        }
+        m_queue.push_back(std::move(job));
+        m_stats.posted++;
+        if (m_queue.size() > m_stats.peakDepth) m_stats.peakDepth = m_queue.size();
+    }
+    m_notEmpty.notify_one();
+    return !overflow;
+}
+
+bool AsyncFrameDispatcher::isWorkerThread() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::thread::id self = std::this_thread::get_id();
+    for (const auto& worker : m_workers) {
+        if (worker.get_id() == self) return true;
+    }
+    return false;
+}
+
+DispatchStats AsyncFrameDispatcher::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DispatchStats stats = m_stats;
+    stats.queueDepth = m_queue.size();
+    return stats;
+}
+
+void AsyncFrameDispatcher::workerLoop() {
+    while (true) {
+        FrameJob job;
+        uint64_t ticket = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return !m_running || !m_queue.empty(); });
+            if (!m_running) return;
+
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+            // 出队顺序即入队顺序：按出队发号，被挤掉的帧不会在序号里留下空洞
+            ticket = m_nextTicket++;
+        }
+
+        // 1. 转换：多个线程并行执行，互不等待；抛异常按转换失败处理
+        bool ok = false;
+        try {
+            ok = m_converter(job);
+        }
+        catch (...) {
+            ok = false;
+        }
+
+        // 2. 交付：等前面的序号都交付完，保证上层看到的帧序不乱
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_turn.wait(lock, [&] { return !m_running || m_nextDelivery == ticket; });
+            if (!m_running) return;
+        }
+
+        // 消费者抛异常同样只记这一帧失败：序号必须推进，否则后面的帧全部卡在 m_turn 上
+        if (ok) {
+            try {
+                m_sink(job.frame);
+            }
+            catch (...) {
+                ok = false;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nextDelivery++;
+            if (ok) m_stats.delivered++;
+            else m_stats.failed++;
+        }
+        m_turn.notify_all();
+    }
+}
@@ -0,0 +1,159 @@
+﻿// Business/CameraCore/src/ClockCorrelator.cpp
+#include "ClockCorrelator.h"
+#include <algorithm>
+#include <cmath>
+
+ClockCorrelator::ClockCorrelator(const ClockCorrelatorConfig& config)
+    : m_config(config),
+    m_fitValid(false),
+    m_slope(0.0),
+    m_intercept(0.0),
+    m_envelope(0.0) {
+}
+
+// ====================================================
+// 1. 采样
+// ====================================================
+void ClockCorrelator::addSample(uint64_t deviceTicks, std::chrono::steady_clock::time_point hostArrival) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.samples++;
+
+    if (!m_samples.empty()) {
+        // 设备时钟回退，或者与预测相差离谱：设备被重置过，之前的拟合作废
+        bool reset = deviceTicks <= m_samples.back().ticks;
+        if (!reset && m_fitValid) {
+            double deviationNs = std::abs(hostOffsetNs(hostArrival) - predictLocked(deviceTicks));
+            reset = deviationNs > std::chrono::duration<double, std::nano>(m_config.resyncThreshold).count();
+        }
+        if (reset) {
+            clearLocked();
+            m_stats.resyncs++;
+        }
+    }
+
+    // 调度卡顿造成的迟到样本会把拟合线往上拽：锁定后不再让它们参与拟合
+    if (m_fitValid && m_samples.size() >= m_config.minSamples) {
+        double residualNs = hostOffsetNs(hostArrival) - predictLocked(deviceTicks) - m_envelope;
+        if (residualNs > std::chrono::duration<double, std::nano>(m_config.outlierThreshold).count()) {
+            m_stats.rejected++;
+            return;
+        }
+    }
+
+    // 同一时间槽内只留延迟最小 (相对拟合线最早到达) 的一帧
+    if (!m_samples.empty() && hostArrival - m_samples.back().slotStart < m_config.slot) {
+        if (!m_fitValid) return;
+        Sample& current = m_samples.back();
+        double currentResidual = hostOffsetNs(current.host) - predictLocked(current.ticks);
+        double residual = hostOffsetNs(hostArrival) - predictLocked(deviceTicks);
+        if (residual >= currentResidual) return;
+        current.ticks = deviceTicks;
+        current.host = hostArrival;
+    }
+    else {
+        m_samples.push_back(Sample{ deviceTicks, hostArrival, hostArrival });
+        while (m_samples.size() > std::max<size_t>(m_config.window, 2)) m_samples.pop_front();
+    }
+    refitLocked();
+}
+
+void ClockCorrelator::correlate(Frame& frame) {
+    if (frame.deviceTimestamp == 0) return; // 设备没给时间戳
+    addSample(frame.deviceTimestamp, frame.hostArrival);
+    frame.hostExposure = toHost(frame.deviceTimestamp);
+}
+
+// ====================================================
+// 2. 拟合：以窗口首个样本为原点，避免大数相减丢精度
+// ====================================================
+void ClockCorrelator::refitLocked() {
+    const size_t n = m_samples.size();
+    m_fitValid = false;
+    if (n < 2) return;
+
+    const Sample& origin = m_samples.front();
+    double meanX = 0.0, meanY = 0.0;
+    for (const Sample& sample : m_samples) {
+        meanX += static_cast<double>(sample.ticks - origin.ticks);
+        meanY += hostOffsetNs(sample.host);
+    }
+    meanX /= n;
+    meanY /= n;
+
+    double sxx = 0.0, sxy = 0.0;
+    for (const Sample& sample : m_samples) {
+        double dx = static_cast<double>(sample.ticks - origin.ticks) - meanX;
+        sxx += dx * dx;
+        sxy += dx * (hostOffsetNs(sample.host) - meanY);
+    }
+    if (sxx <= 0.0) return;
+
+    m_slope = sxy / sxx;
+    m_intercept = meanY - m_slope * meanX;
+    m_fitValid = m_slope > 0.0;
+    if (!m_fitValid) return;
+
+    // 下包络与抖动
+    double minResidual = 0.0, sumSquares = 0.0;
+    for (const Sample& sample : m_samples) {
+        double residual = hostOffsetNs(sample.host) - predictLocked(sample.ticks);
+        minResidual = std::min(minResidual, residual);
+        sumSquares += residual * residual;
+    }
+    m_envelope = minResidual;
+
+    m_stats.ticksPerSecond = 1e9 / m_slope;
+    m_stats.residualRmsUs = std::sqrt(sumSquares / n) / 1000.0;
+    m_stats.envelopeOffsetUs = -minResidual / 1000.0;
+}
+
+double ClockCorrelator::predictLocked(uint64_t deviceTicks) const {
+    // 设备时刻可能早于窗口首个样本 (查询旧帧)：按有符号差值计算
+    int64_t dx = static_cast<int64_t>(deviceTicks - m_samples.front().ticks);
+    return m_intercept + m_slope * static_cast<double>(dx);
+}
+
+double ClockCorrelator::hostOffsetNs(std::chrono::steady_clock::time_point host) const {
+    return std::chrono::duration<double, std::nano>(host - m_samples.front().host).count();
+}
+
+// ====================================================
+// 3. 换算与查询
+// ====================================================
+std::chrono::steady_clock::time_point ClockCorrelator::toHost(uint64_t deviceTicks) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_fitValid || m_samples.size() < m_config.minSamples) return std::chrono::steady_clock::time_point{};
+
+    double offsetNs = predictLocked(deviceTicks) + m_envelope;
+    return m_samples.front().host + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::nano>(offsetNs));
+}
+
+bool ClockCorrelator::isLocked() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fitValid && m_samples.size() >= m_config.minSamples;
+}
+
+ClockCorrelationStats ClockCorrelator::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ClockCorrelationStats stats = m_stats;
+    stats.locked = m_fitValid && m_samples.size() >= m_config.minSamples;
+    return stats;
+}
+
+void ClockCorrelator::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    clearLocked();
+    m_stats = ClockCorrelationStats{};
+}
+
+void ClockCorrelator::clearLocked() {
+    m_samples.clear();
+    m_fitValid = false;
+    m_slope = 0.0;
+    m_intercept = 0.0;
+    m_envelope = 0.0;
+    m_stats.ticksPerSecond = 0.0;
+    m_stats.residualRmsUs = 0.0;
+    m_stats.envelopeOffsetUs = 0.0;
+}
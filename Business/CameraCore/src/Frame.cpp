@@ -0,0 +1,121 @@
+﻿// Business/CameraCore/src/Frame.cpp
+#include "Frame.h"
+#include <vector>
+
+namespace {
+    // 转换缓存块的回收站：每帧一块，取流稳定后在固定几块之间循环，不再走堆分配
+    class ConversionCacheRecycler {
+    public:
+        static ConversionCacheRecycler& instance() {
+            static ConversionCacheRecycler* recycler = new ConversionCacheRecycler(); // 故意不析构：静态析构期仍可能有帧在释放
+            return *recycler;
+        }
+
+        void* take(size_t bytes) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (bytes == m_blockSize && !m_free.empty()) {
+                    void* block = m_free.back();
+                    m_free.pop_back();
+                    return block;
+                }
+            }
+            return ::operator new(bytes);
+        }
+
+        void give(void* block, size_t bytes) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_blockSize == 0) m_blockSize = bytes;
+                if (bytes == m_blockSize && m_free.size() < kMaxFree) {
+                    m_free.push_back(block);
+                    return;
+                }
+            }
+            ::operator delete(block);
+        }
+
+    private:
+        static constexpr size_t kMaxFree = 64; // 与在途帧数同量级即可，多余的直接还给堆
+
+        ConversionCacheRecycler() { m_free.reserve(kMaxFree); }
+
+        std::mutex m_mutex;
+        std::vector<void*> m_free;
+        size_t m_blockSize = 0; // allocate_shared 的控制块与缓存一起分配，大小只有一种
+    };
+
+    template <typename T>
+    struct RecyclingAllocator {
+        using value_type = T;
+
+        RecyclingAllocator() = default;
+        template <typename U>
+        RecyclingAllocator(const RecyclingAllocator<U>&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(ConversionCacheRecycler::instance().take(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) { ConversionCacheRecycler::instance().give(p, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const RecyclingAllocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const RecyclingAllocator<U>&) const { return false; }
+    };
+
+    DemosaicOutput toDemosaicOutput(PixelFormat format) {
+        if (format == PixelFormat::MONO8) return DemosaicOutput::GRAY;
+        return format == PixelFormat::BGR8 ? DemosaicOutput::BGR : DemosaicOutput::RGB;
+    }
+
+    // 非 Bayer 源之间的转换：返回 cvtColor 的转换码，-1 表示不支持
+    int cvtCodeOf(PixelFormat from, PixelFormat to) {
+        switch (from) {
+        case PixelFormat::MONO8:
+            if (to == PixelFormat::RGB8) return cv::COLOR_GRAY2RGB;
+            if (to == PixelFormat::BGR8) return cv::COLOR_GRAY2BGR;
+            break;
+        case PixelFormat::RGB8:
+            if (to == PixelFormat::MONO8) return cv::COLOR_RGB2GRAY;
+            if (to == PixelFormat::BGR8) return cv::COLOR_RGB2BGR;
+            break;
+        case PixelFormat::BGR8:
+            if (to == PixelFormat::MONO8) return cv::COLOR_BGR2GRAY;
+            if (to == PixelFormat::RGB8) return cv::COLOR_BGR2RGB;
+            break;
+        default:
+            break;
+        }
+        return -1;
+    }
+
+    cv::Mat convertImage(const cv::Mat& src, PixelFormat from, PixelFormat to) {
+        cv::Mat dst;
+        if (src.empty() || isBayerFormat(to)) return dst; // Bayer 原始数据无法由其它格式合成
+
+        if (isBayerFormat(from)) {
+            BayerDemosaic::convert(src, dst, bayerPatternOf(from), toDemosaicOutput(to));
+            return dst;
+        }
+
+        int code = cvtCodeOf(from, to);
+        if (code >= 0) cv::cvtColor(src, dst, code);
+        return dst;
+    }
+}
+
+std::shared_ptr<FrameConversionCache> FrameConversionRef::get() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_cache) m_cache = std::allocate_shared<FrameConversionCache>(RecyclingAllocator<FrameConversionCache>());
+    return m_cache;
+}
+
+cv::Mat Frame::toFormat(PixelFormat format) const {
+    if (format == pixelFormat || format == PixelFormat::UNKNOWN) return m_image;
+
+    int index = static_cast<int>(format);
+    std::shared_ptr<FrameConversionCache> cache = m_conversions.get();
+    std::call_once(cache->once[index], [&] {
+        cache->images[index] = convertImage(m_image, pixelFormat, format);
+        });
+    return cache->images[index];
+}
@@ -0,0 +1,207 @@
+﻿// Business/CameraCore/src/FrameBufferPool.cpp
+#include "FrameBufferPool.h"
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+    // 按内存页对齐，方便 DMA / SIMD 访问，也避免不同帧共享同一 cache line
+    constexpr size_t kPageSize = 4096;
+
+    unsigned char* allocPage(size_t bytes) {
+        return static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(kPageSize)));
+    }
+
+    void freePage(unsigned char* p) {
+        if (p) ::operator delete(p, std::align_val_t(kPageSize));
+    }
+
+    size_t roundUpToPage(size_t bytes) {
+        return (bytes + kPageSize - 1) / kPageSize * kPageSize;
+    }
+}
+
+// ====================================================
+// 1. 内部分配器：挂在 cv::Mat 上，负责“借出”与“归还”
+// ====================================================
+class FrameBufferPool::Allocator : public cv::MatAllocator {
+public:
+    Allocator(size_t slotCount, size_t slotBytes) : m_slots(slotCount), m_retired(false) {
+        m_freeList.reserve(slotCount);
+        for (size_t i = 0; i < slotCount; i++) {
+            m_freeList.push_back(i);
+        }
+        m_stats.slotCount = slotCount;
+        growFreeSlots(slotBytes);
+    }
+
+    ~Allocator() override {
+        for (auto& slot : m_slots) freePage(slot.data);
+    }
+
+    void reserve(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        growFreeSlots(bytes);
+    }
+
+    cv::Mat acquire(int rows, int cols, int type) {
+        size_t step = static_cast<size_t>(cols) * CV_ELEM_SIZE(type);
+        cv::UMatData* u = takeSlot(step * rows);
+        if (u == nullptr) {
+            // 池子耗尽：宁可多一次堆分配，也绝不能卡住相机的取流线程
+            return cv::Mat(rows, cols, type);
+        }
+
+        cv::Mat mat(rows, cols, type, u->data, step);
+        // 把引用计数头挂到 Mat 上，最后一个持有者释放时 OpenCV 会调用 deallocate()
+        u->refcount = 1;
+        mat.allocator = this;
+        mat.u = u;
+        return mat;
+    }
+
+    FramePoolStats getStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FramePoolStats stats = m_stats;
+        stats.inUse = m_slots.size() - m_freeList.size();
+        return stats;
+    }
+
+    // 池子主人析构：没有帧在外流通就立即销毁，否则等最后一帧归还时再销毁
+    void retire() {
+        bool canDelete = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_retired = true;
+            canDelete = (m_freeList.size() == m_slots.size());
+        }
+        if (canDelete) delete this;
+    }
+
+    // ---------------------------------------------------------
+    // cv::MatAllocator 接口 (OpenCV 约定为 const，借还缓冲块时通过 const_cast 修改池状态)
+    // ---------------------------------------------------------
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+        cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const override {
+        // 只有池化的 Mat 被消费者再次 create() 成别的尺寸时才会走到这里
+        if (data0 != nullptr) {
+            CV_Error(cv::Error::StsBadArg, "FrameBufferPool does not wrap user data");
+        }
+
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) step[i] = total;
+            total *= static_cast<size_t>(sizes[i]);
+        }
+
+        cv::UMatData* u = const_cast<Allocator*>(this)->takeSlot(total);
+        if (u == nullptr) {
+            // 抛出后 cv::Mat::create 会自动回退到 OpenCV 默认分配器
+            CV_Error(cv::Error::StsNoMem, "FrameBufferPool exhausted");
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (u == nullptr) return;
+        const_cast<Allocator*>(this)->returnSlot(u);
+    }
+
+private:
+    struct Slot {
+        unsigned char* data = nullptr;
+        size_t capacity = 0;
+        // 引用计数头与缓冲块一起预分配，借出时原地构造，避免每帧 new UMatData
+        alignas(cv::UMatData) unsigned char header[sizeof(cv::UMatData)];
+    };
+
+    // 调用方需持有 m_mutex (构造函数除外)
+    void growFreeSlots(size_t bytes) {
+        if (bytes == 0) return;
+        size_t capacity = roundUpToPage(bytes);
+        for (size_t index : m_freeList) {
+            Slot& slot = m_slots[index];
+            if (slot.capacity >= capacity) continue;
+            freePage(slot.data);
+            slot.data = allocPage(capacity);
+            slot.capacity = capacity;
+        }
+        if (capacity > m_stats.slotBytes) m_stats.slotBytes = capacity;
+    }
+
+    cv::UMatData* takeSlot(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_freeList.empty()) {
+            m_stats.exhausted++;
+            return nullptr;
+        }
+
+        size_t index = m_freeList.back();
+        m_freeList.pop_back();
+        Slot& slot = m_slots[index];
+
+        // 分辨率变大 (例如切换 ROI) 时才会重新分配，稳态取流不会走到这里
+        if (slot.capacity < bytes) {
+            freePage(slot.data);
+            slot.capacity = roundUpToPage(bytes);
+            slot.data = allocPage(slot.capacity);
+            if (slot.capacity > m_stats.slotBytes) m_stats.slotBytes = slot.capacity;
+            m_stats.regrown++;
+        }
+        m_stats.acquired++;
+
+        cv::UMatData* u = new (slot.header) cv::UMatData(this);
+        u->data = u->origdata = slot.data;
+        u->size = bytes;
+        u->userdata = &slot; // 引用计数保持为 0，由 acquire() 或 cv::Mat::create 负责加一
+        return u;
+    }
+
+    void returnSlot(cv::UMatData* u) {
+        Slot* slot = static_cast<Slot*>(u->userdata);
+        u->~UMatData();
+
+        bool canDelete = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeList.push_back(static_cast<size_t>(slot - m_slots.data()));
+            canDelete = m_retired && (m_freeList.size() == m_slots.size());
+        }
+        if (canDelete) delete this;
+    }
+
+private:
+    std::vector<Slot> m_slots;        // 构造后大小不再变化，保证 Slot 地址稳定
+    std::vector<size_t> m_freeList;   // 空闲块下标 (容量预留为 slotCount，push_back 不会触发分配)
+    FramePoolStats m_stats;
+    bool m_retired;
+    mutable std::mutex m_mutex;
+};
+
+// ====================================================
+// 2. 对外接口：薄薄一层转发
+// ====================================================
+FrameBufferPool::FrameBufferPool(size_t slotCount, size_t slotBytes)
+    : m_allocator(new Allocator(slotCount, slotBytes)) {
+}
+
+FrameBufferPool::~FrameBufferPool() {
+    // 注意：UI 线程的事件队列里可能还攥着池化的 Mat，不能在这里直接 delete
+    m_allocator->retire();
+}
+
+void FrameBufferPool::reserve(size_t bytes) {
+    m_allocator->reserve(bytes);
+}
+
+cv::Mat FrameBufferPool::acquire(int rows, int cols, int type) {
+    return m_allocator->acquire(rows, cols, type);
+}
+
+FramePoolStats FrameBufferPool::getStats() const {
+    return m_allocator->getStats();
+}
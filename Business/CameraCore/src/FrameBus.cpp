@@ -0,0 +1,176 @@
+﻿// Business/CameraCore/src/FrameBus.cpp
+#include "FrameBus.h"
+#include <algorithm>
+
+FrameBus::FrameBus() : m_nextId(0) {
+}
+
+FrameBus::~FrameBus() {
+    unsubscribeAll();
+}
+
+// ==========================================
+// 1. 订阅与退订：一个订阅者一条交付线程
+// ==========================================
+int FrameBus::subscribe(const FrameSubscription& subscription, FrameBusCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto subscriber = std::make_shared<Subscriber>(++m_nextId, subscription, std::move(callback));
+    subscriber->stats.name = subscription.name;
+    subscriber->stats.policy = subscription.policy;
+    subscriber->stats.queueCapacity = std::max<size_t>(subscription.depth, 1);
+    subscriber->worker = std::thread(&FrameBus::deliverLoop, subscriber.get());
+    m_subscribers.push_back(std::move(subscriber));
+    return m_nextId;
+}
+
+void FrameBus::unsubscribe(int id) {
+    std::shared_ptr<Subscriber> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+            if ((*it)->id == id) {
+                removed = std::move(*it);
+                m_subscribers.erase(it);
+                break;
+            }
+        }
+    }
+    // 在总线锁外等交付线程结束：正在执行的回调不会挡住其他订阅者的发布
+    if (removed) stop(*removed);
+}
+
+void FrameBus::unsubscribeAll() {
+    std::list<std::shared_ptr<Subscriber>> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        removed.swap(m_subscribers);
+    }
+    for (auto& subscriber : removed) stop(*subscriber);
+}
+
+void FrameBus::stop(Subscriber& subscriber) {
+    {
+        std::lock_guard<std::mutex> lock(subscriber.mutex);
+        subscriber.running = false;
+        subscriber.queue.clear(); // 积压的帧直接丢弃，池化缓冲随之归还
+    }
+    subscriber.notEmpty.notify_all();
+    subscriber.notFull.notify_all();
+    if (subscriber.worker.joinable()) subscriber.worker.join();
+}
+
+void FrameBus::setTargetFps(int id, double targetFps) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& subscriber : m_subscribers) {
+        if (subscriber->id == id) subscriber->limiter.setTargetFps(targetFps);
+    }
+}
+
+// ==========================================
+// 2. 发布：各订阅者按自己的帧率与背压策略入队
+// ==========================================
+void FrameBus::publish(const Frame& frame) {
+    // 锁内只拷订阅者列表：BLOCK 订阅者的等待不能挡住其他发布方、订阅/退订与统计
+    std::vector<std::shared_ptr<Subscriber>> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        subscribers.assign(m_subscribers.begin(), m_subscribers.end());
+    }
+
+    // 不阻塞的订阅者先拿到这一帧，BLOCK 订阅者的等待只推迟发布方自己
+    for (auto& subscriber : subscribers) {
+        if (subscriber->subscription.policy != BackpressurePolicy::BLOCK) enqueue(*subscriber, frame);
+    }
+    for (auto& subscriber : subscribers) {
+        if (subscriber->subscription.policy == BackpressurePolicy::BLOCK) enqueue(*subscriber, frame);
+    }
+}
+
+void FrameBus::enqueue(Subscriber& subscriber, const Frame& frame) {
+    std::unique_lock<std::mutex> lock(subscriber.mutex);
+    if (!subscriber.running) return;
+    // 抽稀在入队之前：没轮到的帧不占队列，也不加引用计数
+    if (!subscriber.limiter.accept(frame.hostArrival)) return;
+
+    const size_t capacity = subscriber.stats.queueCapacity;
+    if (subscriber.queue.size() >= capacity) {
+        switch (subscriber.subscription.policy) {
+        case BackpressurePolicy::DROP_OLDEST:
+            subscriber.queue.pop_front();
+            subscriber.stats.droppedOldest++;
+            break;
+        case BackpressurePolicy::DROP_NEWEST:
+            subscriber.stats.droppedNewest++;
+            return;
+        case BackpressurePolicy::BLOCK: {
+            auto begin = std::chrono::steady_clock::now();
+            bool hasRoom = subscriber.notFull.wait_for(lock, subscriber.subscription.blockTimeout, [&] {
+                return !subscriber.running || subscriber.queue.size() < capacity;
+                });
+            subscriber.stats.blockedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            if (!subscriber.running) return;
+            if (!hasRoom) {
+                subscriber.stats.blockTimeouts++;
+                return;
+            }
+            break;
+        }
+        }
+    }
+
+    subscriber.queue.push_back(frame);
+    subscriber.stats.peakDepth = std::max(subscriber.stats.peakDepth, subscriber.queue.size());
+    lock.unlock();
+    subscriber.notEmpty.notify_one();
+}
+
+// ==========================================
+// 3. 交付：出队后放开锁再调用回调，慢回调不挡发布方入队
+// ==========================================
+void FrameBus::deliverLoop(Subscriber* subscriber) {
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(subscriber->mutex);
+            subscriber->notEmpty.wait(lock, [subscriber] { return !subscriber->running || !subscriber->queue.empty(); });
+            if (!subscriber->running) return;
+
+            frame = std::move(subscriber->queue.front());
+            subscriber->queue.pop_front();
+        }
+        subscriber->notFull.notify_one();
+
+        subscriber->callback(frame);
+
+        std::lock_guard<std::mutex> lock(subscriber->mutex);
+        subscriber->stats.delivered++;
+    }
+}
+
+// ==========================================
+// 4. 统计
+// ==========================================
+FrameBusSubscriberStats FrameBus::snapshot(Subscriber& subscriber) const {
+    FrameRateLimiterStats rate = subscriber.limiter.getStats();
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    FrameBusSubscriberStats stats = subscriber.stats;
+    stats.queueDepth = subscriber.queue.size();
+    stats.passed = rate.passed;
+    stats.skipped = rate.skipped;
+    return stats;
+}
+
+FrameBusSubscriberStats FrameBus::getStats(int id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& subscriber : m_subscribers) {
+        if (subscriber->id == id) return snapshot(*subscriber);
+    }
+    return FrameBusSubscriberStats{};
+}
+
+std::vector<FrameBusSubscriberStats> FrameBus::getAllStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<FrameBusSubscriberStats> all;
+    for (const auto& subscriber : m_subscribers) all.push_back(snapshot(*subscriber));
+    return all;
+}
@@ -0,0 +1,62 @@
+﻿// Business/CameraCore/src/FrameRateLimiter.cpp
+#include "FrameRateLimiter.h"
+#include <algorithm>
+
+FrameRateLimiter::FrameRateLimiter(double targetFps)
+    : m_targetFps(targetFps),
+    m_started(false),
+    m_sourceInterval(0),
+    m_passed(0),
+    m_skipped(0) {
+}
+
+void FrameRateLimiter::setTargetFps(double fps) {
+    m_targetFps = fps;
+}
+
+double FrameRateLimiter::targetFps() const {
+    return m_targetFps;
+}
+
+bool FrameRateLimiter::accept(std::chrono::steady_clock::time_point arrival) {
+    using Clock = std::chrono::steady_clock;
+
+    // 源帧间隔：每帧按 1/8 的权重更新，单帧抖动影响不大；源头停顿造成的超长间隔不计入
+    if (m_started && arrival > m_lastArrival) {
+        Clock::duration interval = arrival - m_lastArrival;
+        if (m_sourceInterval.count() == 0) m_sourceInterval = interval;
+        else if (interval < m_sourceInterval * 4) m_sourceInterval += (interval - m_sourceInterval) / 8;
+    }
+    m_lastArrival = arrival;
+
+    double fps = m_targetFps;
+    if (fps <= 0.0) {
+        m_started = true;
+        m_passed++;
+        return true;
+    }
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+
+    // 目标帧率刚被调高：按旧周期排好的时刻太远，立即放行一帧后按新周期走
+    if (m_started && m_nextDue > arrival + period) m_nextDue = arrival;
+
+    // 放宽量不超过半个目标周期，否则会把下一拍的帧提前放行
+    Clock::duration slack = std::min(m_sourceInterval, period) / 2;
+    if (m_started && arrival + slack < m_nextDue) {
+        m_skipped++;
+        return false;
+    }
+
+    // 第一帧或者源头停过一阵 (落后超过一个周期)：从这一帧重新对齐，不补发
+    m_nextDue = (!m_started || m_nextDue + period <= arrival) ? arrival + period : m_nextDue + period;
+    m_started = true;
+    m_passed++;
+    return true;
+}
+
+FrameRateLimiterStats FrameRateLimiter::getStats() const {
+    FrameRateLimiterStats stats;
+    stats.passed = m_passed;
+    stats.skipped = m_skipped;
+    return stats;
+}
@@ -0,0 +1,133 @@
+﻿// Business/CameraCore/src/FrameSynchronizer.cpp
+#include "FrameSynchronizer.h"
+#include <algorithm>
+
+FrameSynchronizer::FrameSynchronizer(size_t cameraCount, const SyncConfig& config)
+    : m_cameraCount(cameraCount),
+    m_config(config),
+    m_nextSetId(0),
+    m_expiredTriggerId(0),
+    m_hasExpired(false) {
+    m_stats.missingByCamera.assign(cameraCount, 0);
+}
+
+void FrameSynchronizer::setCallback(FrameSetCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_callback = std::move(callback);
+}
+
+// ====================================================
+// 1. 组帧
+// ====================================================
+void FrameSynchronizer::push(size_t cameraIndex, const Frame& frame) {
+    if (cameraIndex >= m_cameraCount) return;
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    expire(now);
+
+    auto it = findSet(cameraIndex, frame);
+    if (it == m_pending.end()) {
+        // 这一组已经按残组结算过了，再来的帧没有组可进
+        if (m_config.policy == SyncPolicy::TRIGGER_ID && m_hasExpired && frame.triggerId <= m_expiredTriggerId) {
+            m_stats.lateFrames++;
+            return;
+        }
+
+        PendingSet set;
+        set.triggerId = frame.triggerId;
+        set.anchor = frame.hostArrival;
+        set.created = now;
+        set.frames.resize(m_cameraCount);
+        m_pending.push_back(std::move(set));
+        it = std::prev(m_pending.end());
+    }
+
+    if (!it->frames[cameraIndex].empty()) {
+        m_stats.duplicateFrames++;
+        return;
+    }
+    it->frames[cameraIndex] = frame;
+    it->received++;
+
+    if (it->received == m_cameraCount) {
+        deliver(*it, true);
+        m_pending.erase(it);
+    }
+}
+
+std::deque<FrameSynchronizer::PendingSet>::iterator FrameSynchronizer::findSet(size_t cameraIndex, const Frame& frame) {
+    if (m_config.policy == SyncPolicy::TRIGGER_ID) {
+        return std::find_if(m_pending.begin(), m_pending.end(), [&](const PendingSet& set) {
+            return set.triggerId == frame.triggerId;
+            });
+    }
+
+    // 时间窗：找最早的一个“这台相机还空着、且到达时刻落在窗内”的组
+    return std::find_if(m_pending.begin(), m_pending.end(), [&](const PendingSet& set) {
+        auto distance = frame.hostArrival > set.anchor ? frame.hostArrival - set.anchor : set.anchor - frame.hostArrival;
+        return set.frames[cameraIndex].empty() && distance <= m_config.window;
+        });
+}
+
+// ====================================================
+// 2. 结算：凑齐的组交付，超时的组记为残组
+// ====================================================
+void FrameSynchronizer::expire(std::chrono::steady_clock::time_point now) {
+    // 组按建组先后排列，队首最老：只要队首没超时，后面的也都没超时
+    while (!m_pending.empty() && now - m_pending.front().created > m_config.timeout) {
+        deliver(m_pending.front(), false);
+        m_pending.pop_front();
+    }
+}
+
+void FrameSynchronizer::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_pending.empty()) {
+        deliver(m_pending.front(), false);
+        m_pending.pop_front();
+    }
+    m_hasExpired = false;
+}
+
+void FrameSynchronizer::deliver(PendingSet& set, bool complete) {
+    FrameSet result;
+    result.setId = ++m_nextSetId;
+    result.triggerId = set.triggerId;
+    result.complete = complete;
+
+    bool first = true;
+    std::chrono::steady_clock::time_point earliest, latest;
+    for (const Frame& frame : set.frames) {
+        if (frame.empty()) continue;
+        if (first || frame.hostArrival < earliest) earliest = frame.hostArrival;
+        if (first || frame.hostArrival > latest) latest = frame.hostArrival;
+        first = false;
+    }
+    result.skewMs = first ? 0.0 : std::chrono::duration<double, std::milli>(latest - earliest).count();
+
+    if (complete) {
+        m_stats.completeSets++;
+        m_stats.maxSkewMs = std::max(m_stats.maxSkewMs, result.skewMs);
+    }
+    else {
+        m_stats.incompleteSets++;
+        for (size_t i = 0; i < m_cameraCount; i++) {
+            if (set.frames[i].empty()) m_stats.missingByCamera[i]++;
+        }
+        if (m_config.policy == SyncPolicy::TRIGGER_ID) {
+            m_expiredTriggerId = m_hasExpired ? std::max(m_expiredTriggerId, set.triggerId) : set.triggerId;
+            m_hasExpired = true;
+        }
+    }
+
+    result.frames = std::move(set.frames);
+    if (m_callback && (complete || m_config.deliverIncomplete)) m_callback(result);
+}
+
+SyncStats FrameSynchronizer::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SyncStats stats = m_stats;
+    stats.pendingSets = m_pending.size();
+    return stats;
+}
@@ -0,0 +1,32 @@
+﻿// Business/CameraCore/src/LatestFrameMailbox.cpp
+#include "LatestFrameMailbox.h"
+
+bool LatestFrameMailbox::post(const cv::Mat& image) {
+    cv::Mat stale; // 被覆盖的旧帧在锁外释放
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.posted++;
+    if (m_full) {
+        m_stats.overwritten++;
+        stale = m_slot;
+        m_slot = image;
+        return false; // 上一次的通知还没被处理，它会取到这一帧
+    }
+    m_slot = image;
+    m_full = true;
+    return true;
+}
+
+bool LatestFrameMailbox::take(cv::Mat& image) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_full) return false;
+    image = m_slot;
+    m_slot.release();
+    m_full = false;
+    m_stats.taken++;
+    return true;
+}
+
+MailboxStats LatestFrameMailbox::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
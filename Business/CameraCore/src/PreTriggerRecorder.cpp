@@ -0,0 +1,279 @@
+﻿// Business/CameraCore/src/PreTriggerRecorder.cpp
+#include "PreTriggerRecorder.h"
+#include "RawRecording.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// 只取帧的“身世”：按值拷贝 Frame 会连同转换缓存一起留住 (预览用的 RGB 图等)，环形缓冲的字节上限就不作数了
+static Frame metadataOf(const Frame& frame) {
+    Frame meta;
+    meta.pixelFormat = frame.pixelFormat;
+    meta.sensorFormat = frame.sensorFormat;
+    meta.frameNumber = frame.frameNumber;
+    meta.deviceTimestamp = frame.deviceTimestamp;
+    meta.lostPackets = frame.lostPackets;
+    meta.triggerId = frame.triggerId;
+    meta.sensorRect = frame.sensorRect;
+    meta.pixelStep = frame.pixelStep;
+    meta.hostArrival = frame.hostArrival;
+    meta.hostExposure = frame.hostExposure;
+    return meta;
+}
+
+PreTriggerRecorder::PreTriggerRecorder(const PreTriggerConfig& config)
+    : m_config(config),
+    m_arena(config.capacityBytes), // 一次性分配并触碰每一页，取流中不再有缺页与分配
+    m_running(true),
+    m_nextSeq(0),
+    m_head(0),
+    m_bufferedBytes(0) {
+    m_stats.capacityBytes = m_arena.size();
+    m_copyThread = std::thread(&PreTriggerRecorder::copyLoop, this);
+    m_flushThread = std::thread(&PreTriggerRecorder::flushLoop, this);
+}
+
+PreTriggerRecorder::~PreTriggerRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_copyCond.notify_all();
+    m_flushCond.notify_all();
+    if (m_copyThread.joinable()) m_copyThread.join();
+    if (m_flushThread.joinable()) m_flushThread.join();
+}
+
+void PreTriggerRecorder::setFlushCallback(EventFlushedCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flushCallback = std::move(callback);
+}
+
+// ====================================================
+// 1. 进缓冲：调用方只交接引用，拷贝在拷贝线程上做
+// ====================================================
+void PreTriggerRecorder::push(const Frame& frame) {
+    if (frame.empty() || frame.image().depth() != CV_8U) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_stats.pushed++;
+        if (m_handoff.size() >= std::max<size_t>(m_config.handoffDepth, 1)) {
+            m_handoff.pop_front(); // 与转换队列一致：挤掉最旧的
+            m_stats.handoffDropped++;
+        }
+        m_handoff.push_back(frame);
+    }
+    m_copyCond.notify_one();
+}
+
+void PreTriggerRecorder::copyLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_copyCond.wait(lock, [this] { return !m_running || !m_handoff.empty(); });
+        if (m_handoff.empty()) break; // 停止时先把交接队列里的帧存完
+
+        Frame frame = std::move(m_handoff.front());
+        m_handoff.pop_front();
+
+        const cv::Mat& image = frame.image();
+        const size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+        const size_t bytes = rowBytes * image.rows;
+
+        size_t offset = 0;
+        if (bytes > m_arena.size()) {
+            m_stats.oversizeFrames++;
+            continue;
+        }
+        if (!allocateLocked(bytes, offset)) {
+            m_stats.overrunFrames++;
+            continue;
+        }
+
+        // 分到的这段空间不属于任何记录，写盘线程碰不到：放开锁再拷贝
+        lock.unlock();
+        uchar* dst = m_arena.data() + offset;
+        if (image.isContinuous()) {
+            memcpy(dst, image.data, bytes);
+        }
+        else {
+            for (int y = 0; y < image.rows; y++) memcpy(dst + y * rowBytes, image.ptr<uchar>(y), rowBytes);
+        }
+        lock.lock();
+
+        Record record;
+        record.seq = m_nextSeq++;
+        record.offset = offset;
+        record.bytes = bytes;
+        record.meta = metadataOf(frame);
+        record.rows = image.rows;
+        record.cols = image.cols;
+        record.type = image.type();
+        m_records.push_back(std::move(record));
+        m_head = offset + bytes;
+        m_bufferedBytes += bytes;
+
+        evictExpiredLocked(frame.hostArrival);
+        // frame 在下一轮等待前析构：池化缓冲就此归还
+    }
+}
+
+bool PreTriggerRecorder::allocateLocked(size_t bytes, size_t& offset) {
+    // 只有冻结的窗口才真正钉住；还在录事后段的窗口装不下时照常滚动，窗口起点跟着后移 (保留离事件最近的部分)
+    const uint64_t floor = pinFloorLocked(true);
+    auto evictFront = [&]() {
+        const uint64_t seq = m_records.front().seq;
+        if (seq >= floor) return false; // 还没写盘
+        for (FlushJob& job : m_jobs) {
+            if (!job.frozen && job.firstSeq <= seq) job.firstSeq = job.nextSeq = seq + 1;
+        }
+        m_bufferedBytes -= m_records.front().bytes;
+        m_records.pop_front();
+        return true;
+    };
+
+    offset = m_head;
+    if (offset + bytes > m_arena.size()) {
+        // 尾部放不下：尾部这段作废，从头开始写；尾部还留着的旧帧比头部的更老，先淘汰
+        while (!m_records.empty() && m_records.front().offset >= m_head) {
+            if (!evictFront()) return false;
+        }
+        offset = 0;
+    }
+
+    // 新帧总是紧跟在最新一帧后面，前方第一个遇到的就是最老的一帧
+    while (!m_records.empty()) {
+        const Record& oldest = m_records.front();
+        bool overlaps = oldest.offset < offset + bytes && offset < oldest.offset + oldest.bytes;
+        if (!overlaps) break;
+        if (!evictFront()) return false;
+    }
+    return true;
+}
+
+void PreTriggerRecorder::evictExpiredLocked(std::chrono::steady_clock::time_point now) {
+    const uint64_t floor = pinFloorLocked(false);
+    while (!m_records.empty() && m_records.front().seq < floor &&
+        now - m_records.front().meta.hostArrival > m_config.preTrigger) {
+        m_bufferedBytes -= m_records.front().bytes;
+        m_records.pop_front();
+    }
+}
+
+uint64_t PreTriggerRecorder::pinFloorLocked(bool frozenOnly) const {
+    uint64_t floor = std::numeric_limits<uint64_t>::max();
+    for (const FlushJob& job : m_jobs) {
+        if (job.frozen || !frozenOnly) floor = std::min(floor, job.nextSeq);
+    }
+    return floor;
+}
+
+const PreTriggerRecorder::Record* PreTriggerRecorder::findLocked(uint64_t seq) const {
+    if (m_records.empty() || seq < m_records.front().seq || seq > m_records.back().seq) return nullptr;
+    return &m_records[static_cast<size_t>(seq - m_records.front().seq)]; // 序号连续
+}
+
+// ====================================================
+// 2. 触发与写盘：冻结的窗口边写边释放
+// ====================================================
+bool PreTriggerRecorder::trigger(const std::string& path) {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || (m_records.empty() && m_handoff.empty())) return false;
+
+        // 窗口从事件前 preTrigger 处开始；从这一刻起这些帧被钉住，不会再被新帧覆盖
+        uint64_t first = m_nextSeq;
+        for (const Record& record : m_records) {
+            if (now - record.meta.hostArrival <= m_config.preTrigger) {
+                first = record.seq;
+                break;
+            }
+        }
+
+        FlushJob job;
+        job.path = path;
+        job.freezeAt = now + m_config.postTrigger;
+        job.firstSeq = first;
+        job.lastSeq = first;
+        job.nextSeq = first;
+        job.frozen = false;
+        m_jobs.push_back(job);
+        m_stats.events++;
+    }
+    m_flushCond.notify_all();
+    return true;
+}
+
+void PreTriggerRecorder::flushLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_flushCond.wait(lock, [this] { return !m_running || !m_jobs.empty(); });
+        if (m_jobs.empty()) break;
+
+        // A. 等事件后的 postTrigger 录完再冻结 (停止时立即冻结)
+        if (!m_jobs.front().frozen) {
+            if (m_running && std::chrono::steady_clock::now() < m_jobs.front().freezeAt) {
+                m_flushCond.wait_until(lock, m_jobs.front().freezeAt);
+                continue;
+            }
+            FlushJob& job = m_jobs.front();
+            job.frozen = true;
+            job.lastSeq = m_nextSeq; // 不含：[firstSeq, lastSeq)
+        }
+
+        const std::string path = m_jobs.front().path;
+        const uint64_t first = m_jobs.front().firstSeq;
+        const uint64_t last = m_jobs.front().lastSeq;
+        lock.unlock();
+
+        // B. 逐帧写盘：窗口内的帧被钉住，不持锁读取也不会被覆盖
+        RawRecordingWriter writer;
+        bool ok = writer.open(path);
+        uint64_t frames = 0;
+        for (uint64_t seq = first; seq < last && ok; seq++) {
+            Frame frame;
+            lock.lock();
+            const Record* record = findLocked(seq);
+            if (record) {
+                frame = record->meta;
+                frame.setImage(cv::Mat(record->rows, record->cols, record->type, m_arena.data() + record->offset));
+            }
+            lock.unlock();
+
+            if (record) {
+                ok = writer.write(frame);
+                frames += ok ? 1 : 0;
+            }
+
+            // 写完即释放：拷贝线程马上可以复用这块空间
+            lock.lock();
+            m_jobs.front().nextSeq = seq + 1;
+            if (record && ok) {
+                m_stats.flushedFrames++;
+                m_stats.flushedBytes += frame.image().total() * frame.image().elemSize();
+            }
+            lock.unlock();
+        }
+        writer.close();
+
+        lock.lock();
+        m_jobs.pop_front();
+        EventFlushedCallback callback = m_flushCallback;
+        lock.unlock();
+        if (callback) callback(path, frames, ok);
+        lock.lock();
+    }
+}
+
+PreTriggerStats PreTriggerRecorder::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PreTriggerStats stats = m_stats;
+    stats.bufferedBytes = m_bufferedBytes;
+    stats.bufferedFrames = m_records.size();
+    if (!m_records.empty()) {
+        stats.bufferedSeconds = std::chrono::duration<double>(m_records.back().meta.hostArrival - m_records.front().meta.hostArrival).count();
+    }
+    stats.pendingEvents = m_jobs.size();
+    return stats;
+}
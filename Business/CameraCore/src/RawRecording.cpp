@@ -0,0 +1,169 @@
+﻿// Business/CameraCore/src/RawRecording.cpp
+#include "RawRecording.h"
+#include <cstring>
+
+namespace {
+    constexpr char kFileMagic[8] = { 'O', 'C', 'V', 'R', 'A', 'W', '0', '1' };
+    constexpr uint32_t kFileVersion = 1;
+
+    size_t rowBytesOf(const RawFrameHeader& header) {
+        return static_cast<size_t>(header.width) * CV_ELEM_SIZE(cvTypeOf(static_cast<PixelFormat>(header.pixelFormat)));
+    }
+}
+
+// ====================================================
+// 1. 写入端
+// ====================================================
+RawRecordingWriter::~RawRecordingWriter() {
+    close();
+}
+
+bool RawRecordingWriter::open(const std::string& path) {
+    close();
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) return false;
+
+    RawFileHeader header;
+    memcpy(header.magic, kFileMagic, sizeof(header.magic));
+    header.version = kFileVersion;
+    header.reserved = 0;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_hasOrigin = false;
+    m_framesWritten = 0;
+    m_bytesWritten = sizeof(header);
+    return m_file.good();
+}
+
+void RawRecordingWriter::close() {
+    if (m_file.is_open()) m_file.close();
+}
+
+bool RawRecordingWriter::isOpen() const {
+    return m_file.is_open();
+}
+
+bool RawRecordingWriter::write(const Frame& frame) {
+    if (!m_file.is_open() || frame.empty() || frame.image().depth() != CV_8U) return false;
+
+    if (!m_hasOrigin) {
+        m_origin = frame.hostArrival;
+        m_hasOrigin = true;
+    }
+
+    const cv::Mat& image = frame.image();
+    size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+
+    RawFrameHeader header;
+    header.magic = kRawFrameMagic;
+    header.pixelFormat = static_cast<uint32_t>(frame.pixelFormat);
+    header.width = static_cast<uint32_t>(image.cols);
+    header.height = static_cast<uint32_t>(image.rows);
+    header.frameNumber = frame.frameNumber;
+    header.deviceTimestamp = frame.deviceTimestamp;
+    header.hostTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(frame.hostArrival - m_origin).count();
+    header.lostPackets = frame.lostPackets;
+    header.dataBytes = static_cast<uint32_t>(rowBytes * image.rows);
+
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (image.isContinuous()) {
+        m_file.write(reinterpret_cast<const char*>(image.data), header.dataBytes);
+    }
+    else {
+        // ROI 等非连续内存：逐行写出，文件里始终是紧密排列
+        for (int y = 0; y < image.rows; y++) {
+            m_file.write(reinterpret_cast<const char*>(image.ptr<uchar>(y)), rowBytes);
+        }
+    }
+    if (!m_file.good()) return false;
+
+    m_framesWritten++;
+    m_bytesWritten += sizeof(header) + header.dataBytes;
+    return true;
+}
+
+// ====================================================
+// 2. 读取端
+// ====================================================
+bool RawRecordingReader::isRawRecording(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    RawFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    return memcmp(header.magic, kFileMagic, sizeof(header.magic)) == 0;
+}
+
+bool RawRecordingReader::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    if (m_file.is_open()) m_file.close();
+
+    m_file.open(path, std::ios::binary);
+    if (!m_file.is_open()) return false;
+
+    RawFileHeader fileHeader;
+    if (!m_file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) ||
+        memcmp(fileHeader.magic, kFileMagic, sizeof(fileHeader.magic)) != 0 ||
+        fileHeader.version != kFileVersion) {
+        m_file.close();
+        return false;
+    }
+
+    // 只读帧头、跳过像素数据，建立索引的代价与帧数成正比，与文件大小无关
+    m_file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+    uint64_t offset = sizeof(fileHeader);
+
+    while (offset + sizeof(RawFrameHeader) <= fileSize) {
+        Entry entry;
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        if (!m_file.read(reinterpret_cast<char*>(&entry.header), sizeof(entry.header))) break;
+        if (entry.header.magic != kRawFrameMagic) break;
+        if (entry.header.dataBytes != rowBytesOf(entry.header) * entry.header.height) break;
+
+        entry.offset = offset + sizeof(RawFrameHeader);
+        if (entry.offset + entry.header.dataBytes > fileSize) break; // 最后一帧不完整
+
+        m_index.push_back(entry);
+        offset = entry.offset + entry.header.dataBytes;
+    }
+
+    m_file.clear();
+    return true;
+}
+
+void RawRecordingReader::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    if (m_file.is_open()) m_file.close();
+}
+
+bool RawRecordingReader::read(size_t i, Frame& out, cv::Mat image) {
+    if (i >= m_index.size()) return false;
+    const Entry& entry = m_index[i];
+    const RawFrameHeader& header = entry.header;
+
+    PixelFormat format = static_cast<PixelFormat>(header.pixelFormat);
+    int rows = static_cast<int>(header.height);
+    int cols = static_cast<int>(header.width);
+    if (image.rows != rows || image.cols != cols || image.type() != cvTypeOf(format) || !image.isContinuous()) {
+        image.create(rows, cols, cvTypeOf(format));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.seekg(static_cast<std::streamoff>(entry.offset));
+        if (!m_file.read(reinterpret_cast<char*>(image.data), header.dataBytes)) {
+            m_file.clear();
+            return false;
+        }
+    }
+
+    out = Frame{};
+    out.setImage(image);
+    out.pixelFormat = format;
+    out.sensorFormat = format;
+    out.frameNumber = header.frameNumber;
+    out.deviceTimestamp = header.deviceTimestamp;
+    out.lostPackets = header.lostPackets;
+    return true;
+}
@@ -0,0 +1,83 @@
+﻿// Business/CameraCore/src/RoiFollower.cpp
+#include "RoiFollower.h"
+#include <cmath>
+
+RoiFollower::RoiFollower(ICamera* camera, const RoiFollowConfig& config)
+    : m_camera(camera), m_config(config), m_lostFrames(0) {
+}
+
+// ====================================================
+// 1. 跟随：安全区内不动 -> 平移 -> 改尺寸
+// ====================================================
+bool RoiFollower::update(bool found, const cv::Point2f& center, float radius) {
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.updates++;
+    }
+    if (!m_camera) return false;
+
+    SensorRoi current = m_camera->getRoi();
+    SensorGeometry geometry = m_camera->getSensorGeometry();
+    if (geometry.maxWidth == 0) return false; // 不支持 ROI 的相机
+
+    if (!found) {
+        // 目标可能已经移出 ROI：丢得够久就放开到全幅，让检测重新在整幅画面里找
+        if (++m_lostFrames < m_config.lostFramesToReset) return false;
+        m_lostFrames = 0;
+        SensorRoi full = geometry.align(SensorRoi{});
+        if (current == full) return false;
+        return apply(full, m_stats.resets);
+    }
+    m_lostFrames = 0;
+
+    // 目标连同余量需要的正方形
+    double margin = std::max(radius * m_config.marginRatio, static_cast<double>(m_config.minMarginPx));
+    int half = static_cast<int>(std::ceil(radius + margin));
+    cv::Rect needed(static_cast<int>(center.x) - half, static_cast<int>(center.y) - half, 2 * half, 2 * half);
+    needed &= cv::Rect(0, 0, geometry.maxWidth, geometry.maxHeight);
+
+    cv::Rect roiRect(current.offsetX, current.offsetY, current.width, current.height);
+    bool contains = (roiRect & needed) == needed;
+    bool tooLarge = current.width > needed.width * m_config.shrinkRatio && current.height > needed.height * m_config.shrinkRatio;
+    if (contains && !tooLarge) return false;
+
+    // 以目标为中心摆放
+    auto centered = [&](int width, int height) {
+        SensorRoi roi;
+        roi.width = width;
+        roi.height = height;
+        roi.offsetX = static_cast<int>(center.x) - width / 2;
+        roi.offsetY = static_cast<int>(center.y) - height / 2;
+        return geometry.align(roi);
+    };
+
+    // A. 尺寸够用：保持尺寸只平移
+    if (!tooLarge && needed.width <= current.width && needed.height <= current.height) {
+        return apply(centered(current.width, current.height), m_stats.moves);
+    }
+
+    // B. 装不下或明显过大：按所需大小重新设定
+    return apply(centered(needed.width, needed.height), m_stats.resizes);
+}
+
+void RoiFollower::reset() {
+    m_lostFrames = 0;
+    if (!m_camera) return;
+    SensorRoi full = m_camera->getSensorGeometry().align(SensorRoi{});
+    if (m_camera->getRoi() != full) apply(full, m_stats.resets);
+}
+
+bool RoiFollower::apply(const SensorRoi& roi, uint64_t& counter) {
+    if (roi == m_camera->getRoi()) return false; // 对齐之后与当前一致
+    if (m_camera->setRoi(roi) != CameraStatus::SUCCESS) return false;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    counter++;
+    m_stats.current = m_camera->getRoi();
+    return true;
+}
+
+RoiFollowStats RoiFollower::getStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
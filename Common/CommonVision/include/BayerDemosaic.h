@@ -0,0 +1,52 @@
+﻿// Common/CommonVision/include/BayerDemosaic.h
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+// =========================================================
+// Bayer 排列：按传感器手册的叫法，取图像左上角 2x2 的第一行
+// 注意：OpenCV 的 COLOR_BayerXX 命名是按第二行第二、三列算的，
+//       RG 对应 OpenCV 的 BayerBG，GB 对应 BayerGR，依此类推，不要直接套用。
+// =========================================================
+enum class BayerPattern {
+    RG,
+    GB,
+    GR,
+    BG
+};
+
+// 插值质量：越往下越慢，但边缘处的伪彩 (拉链纹) 越少
+enum class DemosaicQuality {
+    NEAREST,     // 最近邻复制，速度最快，适合缩略图/对焦预览
+    BILINEAR,    // 双线性插值，通用默认
+    EDGE_AWARE   // 绿色通道沿梯度较小的方向插值，抑制边缘拉链纹
+};
+
+// 输出通道排列
+enum class DemosaicOutput {
+    RGB,
+    BGR,
+    GRAY
+};
+
+// =========================================================
+// BayerDemosaic：自研多线程 SIMD 去马赛克引擎
+// 作用：取代闭源、不可调优的 MV_CC_ConvertPixelType。
+//
+// 原理：图像按行切成若干条带交给 cv::parallel_for_ 分摊到各核心；
+// 每条带内部用 OpenCV 通用 SIMD 指令 (universal intrinsics) 一次处理 16 个像素，
+// 图像四周与不足 16 像素的尾巴走标量路径，两条路径的插值公式逐位一致。
+// 边界按 BORDER_REFLECT_101 处理，保证边缘像素也能取到同色邻居。
+// =========================================================
+class BayerDemosaic {
+public:
+    /**
+     * @brief 把 8 位 Bayer 原始图像转换为 RGB / BGR / 灰度图
+     * @param bayer 输入，CV_8UC1，宽高均不小于 2
+     * @param dst [out] 输出，RGB/BGR 为 CV_8UC3，GRAY 为 CV_8UC1；尺寸类型已匹配时直接复用其内存
+     * @param bands 行条带数，0 表示按 OpenCV 线程数自动切分
+     * @return 输入不合法时返回 false，dst 保持不变
+     */
+    static bool convert(const cv::Mat& bayer, cv::Mat& dst, BayerPattern pattern,
+        DemosaicOutput output, DemosaicQuality quality = DemosaicQuality::BILINEAR, int bands = 0);
+};
@@ -0,0 +1,58 @@
+﻿// Common/CommonVision/include/RingDetector.h
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+// 负压环检测参数 (缺省值即 AlgorithmTester 里调好的那一套)
+struct RingDetectorConfig {
+    int targetWidth = 800;          // 先缩放到这个宽度再分析，稳定分析尺度
+    double claheClipLimit = 3.0;    // 对比度拉伸
+    int claheTileSize = 8;
+    int medianKsize = 9;            // 强力平滑，抹杀背景纹理
+    double minDist = 15.0;          // 霍夫圆参数 (缩放后的像素)
+    double cannyThreshold = 100;    // Canny 高阈值稍微提高，屏蔽杂音
+    double voteThreshold = 30;      // 投票阈值，拒绝牵强的假圆
+    int minRadius = 15;
+    double concentricMaxDist = 15.0; // 同心判定：圆心相距小于它
+    double concentricMinRadiusDiff = 10.0; // 且半径相差大于它
+};
+
+// 一次检测的结果 (坐标已还原到输入图像)
+struct RingDetection {
+    bool found = false;
+    cv::Point2f center;             // 外圈
+    float radius = 0.0f;
+    cv::Point2f innerCenter;        // 内圈
+    float innerRadius = 0.0f;
+};
+
+// =========================================================
+// RingDetector：负压环检测 (严格同心圆模式，拒绝任何误判)
+// 缩放 -> 灰度 -> CLAHE -> 中值滤波 -> 霍夫圆 -> 同心判定。
+// 每一步单独开放出来，处理流水线可以把它们拆到不同的线程上；detect() 是一口气做完的版本。
+// =========================================================
+class RingDetector {
+public:
+    // 1. 缩放到 targetWidth 宽，返回缩放倍率 (输入 / 输出)，坐标还原时乘回去
+    static float resize(const cv::Mat& src, cv::Mat& dst, int targetWidth);
+
+    // 2. 灰度化；单通道输入直接共享 (不拷贝)。code 为三通道输入的转换码 (imread 的图是 BGR，相机预览是 RGB)
+    static void toGray(const cv::Mat& src, cv::Mat& gray, int code = cv::COLOR_BGR2GRAY);
+
+    // 3. 对比度极限拉伸 (CLAHE 对象可复用，避免每帧重新创建)
+    static cv::Ptr<cv::CLAHE> createClahe(const RingDetectorConfig& config);
+    static void enhanceContrast(const cv::Mat& gray, cv::Mat& dst, cv::CLAHE& clahe);
+
+    // 4. 中值滤波
+    static void smooth(const cv::Mat& gray, cv::Mat& dst, int ksize);
+
+    // 5. 霍夫圆 + 同心判定：必须找到同心兄弟，否则统统不算；scale 为第 1 步返回的倍率
+    static RingDetection findConcentric(const cv::Mat& gray, float scale, const RingDetectorConfig& config);
+
+    // 6. 标注：外圈绿，内圈黄，圆心红；rgb 表示 image 的通道顺序是 RGB (否则按 BGR)
+    static void annotate(cv::Mat& image, const RingDetection& detection, bool rgb = false);
+
+    // 一口气做完 1-5
+    static RingDetection detect(const cv::Mat& src, const RingDetectorConfig& config = RingDetectorConfig(),
+        int grayCode = cv::COLOR_BGR2GRAY);
+};
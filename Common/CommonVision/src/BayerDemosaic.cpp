@@ -0,0 +1,244 @@
+﻿// Common/CommonVision/src/BayerDemosaic.cpp
+#include "BayerDemosaic.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <cstdlib>
+
+namespace {
+    enum Channel { CH_R, CH_G, CH_B };
+
+    // 各排列左上角 2x2 的颜色：[行奇偶][列奇偶]
+    constexpr Channel kPatternTable[4][2][2] = {
+        { { CH_R, CH_G }, { CH_G, CH_B } }, // RG
+        { { CH_G, CH_B }, { CH_R, CH_G } }, // GB
+        { { CH_G, CH_R }, { CH_B, CH_G } }, // GR
+        { { CH_B, CH_G }, { CH_G, CH_R } }  // BG
+    };
+
+    // 灰度权重 (BT.601，放大 256 倍取整，三者之和恰为 256)
+    constexpr int kWeightR = 77;
+    constexpr int kWeightG = 150;
+    constexpr int kWeightB = 29;
+
+    // 一行的上下文：每行只有“绿 + 另一种颜色 K”两种像素，K 出现在固定的列奇偶上
+    struct RowContext {
+        const uchar* up;
+        const uchar* cur;
+        const uchar* down;
+        int kParity;   // K 像素所在列的奇偶
+        bool kIsRed;   // K 是红色 (否则是蓝色)
+    };
+
+    // BORDER_REFLECT_101：-1 -> 1, n -> n-2，反射后的邻居与原位置颜色相同
+    inline int reflect101(int i, int n) {
+        if (i < 0) return -i;
+        if (i >= n) return 2 * n - i - 2;
+        return i;
+    }
+
+    // 与 v_avg 完全一致的舍入，保证标量与 SIMD 路径结果逐位相同
+    inline uchar avg2(uchar a, uchar b) {
+        return static_cast<uchar>((a + b + 1) >> 1);
+    }
+
+    inline uchar toGray(uchar r, uchar g, uchar b) {
+        return static_cast<uchar>((r * kWeightR + g * kWeightG + b * kWeightB + 128) >> 8);
+    }
+
+    // ====================================================
+    // 1. 标量路径：处理图像左右边界与行尾不足 16 像素的部分
+    // ====================================================
+    inline void demosaicPixel(const RowContext& row, int x, int cols, DemosaicQuality quality,
+        uchar& r, uchar& g, uchar& b) {
+        int xl = reflect101(x - 1, cols);
+        int xr = reflect101(x + 1, cols);
+
+        uchar c = row.cur[x];
+        uchar h, v, cross, diag;
+        if (quality == DemosaicQuality::NEAREST) {
+            // 左边、上边、左上角恰好分别是本行另一色、邻行同列色、邻行对角色
+            h = row.cur[xl];
+            v = row.up[x];
+            cross = h;
+            diag = row.up[xl];
+        }
+        else {
+            h = avg2(row.cur[xl], row.cur[xr]);
+            v = avg2(row.up[x], row.down[x]);
+            cross = avg2(h, v);
+            diag = avg2(avg2(row.up[xl], row.up[xr]), avg2(row.down[xl], row.down[xr]));
+
+            if (quality == DemosaicQuality::EDGE_AWARE) {
+                int gradH = std::abs(row.cur[xl] - row.cur[xr]);
+                int gradV = std::abs(row.up[x] - row.down[x]);
+                if (gradH < gradV) cross = h;
+                else if (gradV < gradH) cross = v;
+            }
+        }
+
+        // K 像素：K 取自身，绿取十字邻居，另一色取对角；绿像素：K 在左右，另一色在上下
+        bool kSite = (x & 1) == row.kParity;
+        uchar k = kSite ? c : h;
+        uchar other = kSite ? diag : v;
+        g = kSite ? cross : c;
+        r = row.kIsRed ? k : other;
+        b = row.kIsRed ? other : k;
+    }
+
+    inline void storePixel(uchar* dst, int x, DemosaicOutput output, uchar r, uchar g, uchar b) {
+        switch (output) {
+        case DemosaicOutput::RGB:
+            dst[3 * x] = r; dst[3 * x + 1] = g; dst[3 * x + 2] = b;
+            break;
+        case DemosaicOutput::BGR:
+            dst[3 * x] = b; dst[3 * x + 1] = g; dst[3 * x + 2] = r;
+            break;
+        default:
+            dst[x] = toGray(r, g, b);
+            break;
+        }
+    }
+
+    inline void scalarSpan(const RowContext& row, uchar* dst, int begin, int end, int cols,
+        DemosaicOutput output, DemosaicQuality quality) {
+        for (int x = begin; x < end; x++) {
+            uchar r, g, b;
+            demosaicPixel(row, x, cols, quality, r, g, b);
+            storePixel(dst, x, output, r, g, b);
+        }
+    }
+
+#if CV_SIMD128
+    // ====================================================
+    // 2. SIMD 路径：一次 16 个像素，x 必须为偶数，且 [x-1, x+16] 均在行内
+    // ====================================================
+    constexpr int kLanes = 16;
+    alignas(16) const uchar kEvenLanes[kLanes] = { 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0 };
+    alignas(16) const uchar kOddLanes[kLanes] = { 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255 };
+
+    inline cv::v_uint8x16 grayOf(const cv::v_uint8x16& r, const cv::v_uint8x16& g, const cv::v_uint8x16& b) {
+        cv::v_uint16x8 rLo, rHi, gLo, gHi, bLo, bHi;
+        cv::v_expand(r, rLo, rHi);
+        cv::v_expand(g, gLo, gHi);
+        cv::v_expand(b, bLo, bHi);
+
+        const cv::v_uint16x8 wr = cv::v_setall_u16(kWeightR);
+        const cv::v_uint16x8 wg = cv::v_setall_u16(kWeightG);
+        const cv::v_uint16x8 wb = cv::v_setall_u16(kWeightB);
+        const cv::v_uint16x8 half = cv::v_setall_u16(128);
+
+        // 最大值 255 * 256 + 128 < 65536，16 位累加不会溢出
+        cv::v_uint16x8 yLo = cv::v_shr<8>(rLo * wr + gLo * wg + bLo * wb + half);
+        cv::v_uint16x8 yHi = cv::v_shr<8>(rHi * wr + gHi * wg + bHi * wb + half);
+        return cv::v_pack(yLo, yHi);
+    }
+
+    inline void simdSpan(const RowContext& row, uchar* dst, int x, DemosaicOutput output, DemosaicQuality quality) {
+        cv::v_uint8x16 c = cv::v_load(row.cur + x);
+        cv::v_uint8x16 left = cv::v_load(row.cur + x - 1);
+        cv::v_uint8x16 up = cv::v_load(row.up + x);
+
+        cv::v_uint8x16 h, v, cross, diag;
+        if (quality == DemosaicQuality::NEAREST) {
+            h = left;
+            v = up;
+            cross = left;
+            diag = cv::v_load(row.up + x - 1);
+        }
+        else {
+            cv::v_uint8x16 right = cv::v_load(row.cur + x + 1);
+            cv::v_uint8x16 down = cv::v_load(row.down + x);
+            h = cv::v_avg(left, right);
+            v = cv::v_avg(up, down);
+            cross = cv::v_avg(h, v);
+            diag = cv::v_avg(cv::v_avg(cv::v_load(row.up + x - 1), cv::v_load(row.up + x + 1)),
+                cv::v_avg(cv::v_load(row.down + x - 1), cv::v_load(row.down + x + 1)));
+
+            if (quality == DemosaicQuality::EDGE_AWARE) {
+                cv::v_uint8x16 gradH = cv::v_absdiff(left, right);
+                cv::v_uint8x16 gradV = cv::v_absdiff(up, down);
+                cross = cv::v_select(gradH < gradV, h, cv::v_select(gradV < gradH, v, cross));
+            }
+        }
+
+        cv::v_uint8x16 kMask = cv::v_load(row.kParity == 0 ? kEvenLanes : kOddLanes);
+        cv::v_uint8x16 k = cv::v_select(kMask, c, h);
+        cv::v_uint8x16 other = cv::v_select(kMask, diag, v);
+        cv::v_uint8x16 g = cv::v_select(kMask, cross, c);
+        cv::v_uint8x16 r = row.kIsRed ? k : other;
+        cv::v_uint8x16 b = row.kIsRed ? other : k;
+
+        switch (output) {
+        case DemosaicOutput::RGB:
+            cv::v_store_interleave(dst + 3 * x, r, g, b);
+            break;
+        case DemosaicOutput::BGR:
+            cv::v_store_interleave(dst + 3 * x, b, g, r);
+            break;
+        default:
+            cv::v_store(dst + x, grayOf(r, g, b));
+            break;
+        }
+    }
+#endif
+
+    // ====================================================
+    // 3. 行条带：每个线程负责 [begin, end) 行
+    // ====================================================
+    class DemosaicBand : public cv::ParallelLoopBody {
+    public:
+        DemosaicBand(const cv::Mat& src, cv::Mat& dst, BayerPattern pattern, DemosaicOutput output, DemosaicQuality quality)
+            : m_src(src), m_dst(dst), m_pattern(static_cast<int>(pattern)), m_output(output), m_quality(quality) {
+        }
+
+        void operator()(const cv::Range& range) const override {
+            const int rows = m_src.rows;
+            const int cols = m_src.cols;
+
+            for (int y = range.start; y < range.end; y++) {
+                const Channel (&colors)[2] = kPatternTable[m_pattern][y & 1];
+                RowContext row;
+                row.up = m_src.ptr<uchar>(reflect101(y - 1, rows));
+                row.cur = m_src.ptr<uchar>(y);
+                row.down = m_src.ptr<uchar>(reflect101(y + 1, rows));
+                row.kParity = (colors[0] != CH_G) ? 0 : 1;
+                row.kIsRed = (colors[row.kParity] == CH_R);
+
+                uchar* dst = m_dst.ptr<uchar>(y);
+                int x = 0;
+#if CV_SIMD128
+                // 第 0、1 列需要反射取左邻居，交给标量；之后从偶数列开始整块推进
+                scalarSpan(row, dst, 0, 2, cols, m_output, m_quality);
+                for (x = 2; x + kLanes + 1 <= cols; x += kLanes) {
+                    simdSpan(row, dst, x, m_output, m_quality);
+                }
+#endif
+                scalarSpan(row, dst, x, cols, cols, m_output, m_quality);
+            }
+        }
+
+    private:
+        const cv::Mat& m_src;
+        cv::Mat& m_dst;
+        int m_pattern;
+        DemosaicOutput m_output;
+        DemosaicQuality m_quality;
+    };
+}
+
+// ====================================================
+// 4. 对外接口
+// ====================================================
+bool BayerDemosaic::convert(const cv::Mat& bayer, cv::Mat& dst, BayerPattern pattern,
+    DemosaicOutput output, DemosaicQuality quality, int bands) {
+    if (bayer.empty() || bayer.type() != CV_8UC1 || bayer.rows < 2 || bayer.cols < 2) return false;
+
+    int dstType = (output == DemosaicOutput::GRAY) ? CV_8UC1 : CV_8UC3;
+    // 原地转换会在读邻居之前覆盖掉它们
+    if (dst.data == bayer.data && dst.type() == dstType) return false;
+    dst.create(bayer.rows, bayer.cols, dstType);
+
+    if (bands <= 0) bands = cv::getNumThreads();
+    DemosaicBand body(bayer, dst, pattern, output, quality);
+    cv::parallel_for_(cv::Range(0, bayer.rows), body, static_cast<double>(bands));
+    return true;
+}
@@ -0,0 +1,84 @@
+﻿// Common/CommonVision/src/RingDetector.cpp
+#include "RingDetector.h"
+#include <cmath>
+#include <vector>
+
+float RingDetector::resize(const cv::Mat& src, cv::Mat& dst, int targetWidth) {
+    float scaleRate = (float)src.cols / targetWidth;
+    cv::resize(src, dst, cv::Size(targetWidth, src.rows / scaleRate));
+    return scaleRate;
+}
+
+void RingDetector::toGray(const cv::Mat& src, cv::Mat& gray, int code) {
+    if (src.channels() == 3) cv::cvtColor(src, gray, code);
+    else gray = src;
+}
+
+cv::Ptr<cv::CLAHE> RingDetector::createClahe(const RingDetectorConfig& config) {
+    return cv::createCLAHE(config.claheClipLimit, cv::Size(config.claheTileSize, config.claheTileSize));
+}
+
+void RingDetector::enhanceContrast(const cv::Mat& gray, cv::Mat& dst, cv::CLAHE& clahe) {
+    clahe.apply(gray, dst);
+}
+
+void RingDetector::smooth(const cv::Mat& gray, cv::Mat& dst, int ksize) {
+    cv::medianBlur(gray, dst, ksize);
+}
+
+RingDetection RingDetector::findConcentric(const cv::Mat& gray, float scale, const RingDetectorConfig& config) {
+    RingDetection result;
+    std::vector<cv::Vec3f> circles;
+    int maxRadius = gray.cols / 2; // 不超过画面一半
+    cv::HoughCircles(gray, circles, cv::HOUGH_GRADIENT, 1, config.minDist, config.cannyThreshold, config.voteThreshold,
+        config.minRadius, maxRadius);
+
+    // 【铁血判定】：必须找到同心兄弟，否则统统不算！
+    if (circles.size() < 2) return result;
+    for (size_t i = 0; i < circles.size(); i++) {
+        for (size_t j = i + 1; j < circles.size(); j++) {
+            cv::Vec3f c1 = circles[i];
+            cv::Vec3f c2 = circles[j];
+
+            // 计算圆心距离与半径差
+            double dist = cv::norm(cv::Point2f(c1[0], c1[1]) - cv::Point2f(c2[0], c2[1]));
+            double radDiff = std::abs(c1[2] - c2[2]);
+            if (dist >= config.concentricMaxDist || radDiff <= config.concentricMinRadiusDiff) continue;
+
+            // 找出哪个是外圈(大圆)，哪个是内圈(小圆)，还原到原图坐标
+            cv::Vec3f outerCircle = (c1[2] > c2[2]) ? c1 : c2;
+            cv::Vec3f innerCircle = (c1[2] > c2[2]) ? c2 : c1;
+            result.found = true;
+            result.center = cv::Point2f(outerCircle[0] * scale, outerCircle[1] * scale);
+            result.radius = outerCircle[2] * scale;
+            result.innerCenter = cv::Point2f(innerCircle[0] * scale, innerCircle[1] * scale);
+            result.innerRadius = innerCircle[2] * scale;
+            return result; // 找到一对就收工
+        }
+    }
+    return result;
+}
+
+void RingDetector::annotate(cv::Mat& image, const RingDetection& detection, bool rgb) {
+    // 【极其绝情】：没有找到同心圆，绝不瞎画圈！
+    if (!detection.found) return;
+    cv::Scalar yellow = rgb ? cv::Scalar(255, 255, 0) : cv::Scalar(0, 255, 255);
+    cv::Scalar red = rgb ? cv::Scalar(255, 0, 0) : cv::Scalar(0, 0, 255);
+    cv::circle(image, detection.center, detection.radius, cv::Scalar(0, 255, 0), 4, cv::LINE_AA);
+    cv::circle(image, detection.innerCenter, detection.innerRadius, yellow, 2, cv::LINE_AA);
+    cv::circle(image, detection.center, 6, red, -1, cv::LINE_AA);
+}
+
+RingDetection RingDetector::detect(const cv::Mat& src, const RingDetectorConfig& config, int grayCode) {
+    if (src.empty()) return RingDetection();
+
+    cv::Mat workingImg, gray;
+    float scale = resize(src, workingImg, config.targetWidth);
+    toGray(workingImg, gray, grayCode);
+
+    cv::Ptr<cv::CLAHE> clahe = createClahe(config);
+    cv::Mat enhanced, smoothed;
+    enhanceContrast(gray, enhanced, *clahe);
+    smooth(enhanced, smoothed, config.medianKsize);
+    return findConcentric(smoothed, scale, config);
+}
@@ -0,0 +1,148 @@
+﻿// Common/TaskScheduler/include/TaskScheduler.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 任务的优先级类别：工作线程总是先找高优先级的任务 (不抢占正在执行的任务)
+enum class TaskPriority {
+    DISPLAY = 0,    // 显示：预览转换、标注图 ... 晚了用户就看得见
+    ANALYSIS = 1,   // 分析：负压环检测等实时算法
+    ARCHIVAL = 2    // 归档：录像、落盘、统计汇总，晚一点没关系
+};
+constexpr size_t kTaskPriorityCount = 3;
+
+struct TaskSchedulerConfig {
+    size_t workers = 0;   // 工作线程数，0 = 硬件线程数
+    // 每个类别同时最多占用几条工作线程，0 = 不限
+    // 例如分析设为 workers - 1：霍夫圆再慢也总留一条线程给显示任务
+    std::array<size_t, kTaskPriorityCount> maxConcurrent{ 0, 0, 0 };
+    bool pinWorkers = false;  // 亲和性：第 i 条工作线程绑到 cpus[i % cpus.size()] 号核 (cpus 为空时绑到 i % 核数)
+    std::vector<int> cpus;
+};
+
+struct TaskClassStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    size_t queued = 0;         // 当前排队的任务数
+    size_t running = 0;        // 当前正在执行的任务数
+    size_t peakRunning = 0;
+    uint64_t deferred = 0;     // 有任务排队、却因并发上限被跳过的次数
+    double avgWaitMs = 0.0;    // 从提交到开始执行的平均等待
+    double maxWaitMs = 0.0;
+};
+
+struct TaskWorkerStats {
+    size_t queueDepth = 0;     // 本地队列里排队的任务数
+    uint64_t executed = 0;
+    uint64_t steals = 0;       // 从别的工作线程偷来执行的任务数
+    int cpu = -1;              // 绑定的核，-1 = 未绑定
+};
+
+struct TaskSchedulerStats {
+    size_t workers = 0;
+    uint64_t localPops = 0;     // 从自己的本地队列取到的任务数
+    uint64_t injectedPops = 0;  // 从外部提交队列取到的任务数
+    uint64_t steals = 0;        // 偷到的任务数
+    uint64_t failedSteals = 0;  // 有任务排队却一个都没偷到的次数
+    uint64_t parks = 0;         // 工作线程找不到任务、睡下的次数
+    std::array<TaskClassStats, kTaskPriorityCount> classes;
+    std::vector<TaskWorkerStats> perWorker;
+};
+
+// =========================================================
+// TaskScheduler：全进程共享的工作窃取线程池
+// 每条工作线程有自己的本地队列 (按优先级分开)：任务里再提交的后续任务进本地队列，
+// 由本线程后进先出地执行 (数据还热在缓存里)；外部线程提交的任务进提交队列。
+// 闲下来的工作线程按优先级依次找：自己的本地队列 -> 提交队列 -> 从别的线程队首偷。
+// 先找遍所有来源的高优先级任务，才轮到低优先级。
+//
+// 并发上限：每个类别同时占用的工作线程数可以封顶，达到上限时该类任务只排队不执行，
+//          避免一种任务占满所有线程，把别的类别饿死。
+// 线程：submit() 可在任意线程调用 (包括任务内部)；任务抛出的异常写日志后吞掉。
+// =========================================================
+class TaskScheduler {
+public:
+    explicit TaskScheduler(const TaskSchedulerConfig& config = TaskSchedulerConfig());
+    // 执行完所有已提交的任务 (含其中再提交的) 再退出
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // 全进程共享的调度器：第一次调用时按 configureShared() 的配置创建 (未配置则用默认配置)
+    static TaskScheduler& shared();
+    // 须在第一次 shared() 之前调用，之后调用返回 false
+    static bool configureShared(const TaskSchedulerConfig& config);
+
+    void submit(TaskPriority priority, std::function<void()> task);
+
+    size_t workerCount() const;
+    TaskSchedulerStats getStats() const;
+
+private:
+    struct Task {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Worker {
+        std::mutex mutex;   // 只保护 local：本线程取队尾、窃取方取队首
+        std::array<std::deque<Task>, kTaskPriorityCount> local;
+        std::thread thread;
+        int cpu = -1;
+        std::atomic<uint64_t> executed{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+    };
+
+    // 每个类别一份，全部是原子量：统计不引入额外的锁
+    struct ClassCounters {
+        size_t cap = 0;
+        std::atomic<size_t> queued{ 0 };
+        std::atomic<size_t> running{ 0 };
+        std::atomic<size_t> peakRunning{ 0 };
+        std::atomic<uint64_t> submitted{ 0 };
+        std::atomic<uint64_t> completed{ 0 };
+        std::atomic<uint64_t> deferred{ 0 };
+        std::atomic<double> totalWaitMs{ 0.0 };
+        std::atomic<double> maxWaitMs{ 0.0 };
+    };
+
+    void workerLoop(size_t index);
+    bool findTask(size_t index, Task& task, size_t& priority);
+    bool acquireSlot(size_t priority);
+    bool popLocal(size_t index, size_t priority, Task& task);
+    bool popInjected(size_t priority, Task& task);
+    bool steal(size_t index, size_t priority, Task& task);
+    void execute(size_t index, Task& task, size_t priority);
+    void wake();
+    size_t totalQueued() const;
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::array<ClassCounters, kTaskPriorityCount> m_classes;
+
+    std::mutex m_injectMutex;
+    std::array<std::deque<Task>, kTaskPriorityCount> m_injected;
+
+    // 睡眠与唤醒：有新任务或空出并发名额时 m_epoch 加一
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCond;
+    uint64_t m_epoch;
+    bool m_stopping;
+
+    std::atomic<uint64_t> m_localPops;
+    std::atomic<uint64_t> m_injectedPops;
+    std::atomic<uint64_t> m_steals;
+    std::atomic<uint64_t> m_failedSteals;
+    std::atomic<uint64_t> m_parks;
+};
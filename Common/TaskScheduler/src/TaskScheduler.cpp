@@ -0,0 +1,317 @@
+﻿// Common/TaskScheduler/src/TaskScheduler.cpp
+#include "TaskScheduler.h"
+#include "CommonLogger.h"
+#include <algorithm>
+#include <exception>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI   // wingdi.h 的 ERROR 宏会与 LogLevel::ERROR 冲突
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    // 当前线程是哪个调度器的第几条工作线程 (任务内部提交时据此放进本地队列)
+    struct CurrentWorker {
+        const void* scheduler = nullptr;
+        size_t index = 0;
+    };
+    thread_local CurrentWorker t_current;
+
+    bool pinCurrentThread(int cpu) {
+#if defined(_WIN32)
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    void updateMax(std::atomic<double>& target, double value) {
+        double current = target.load();
+        while (value > current && !target.compare_exchange_weak(current, value)) {}
+    }
+
+    void updateMax(std::atomic<size_t>& target, size_t value) {
+        size_t current = target.load();
+        while (value > current && !target.compare_exchange_weak(current, value)) {}
+    }
+
+    std::mutex g_sharedMutex;
+    TaskSchedulerConfig g_sharedConfig;
+    bool g_sharedCreated = false;
+}
+
+// ==========================================
+// 1. 构造与析构
+// ==========================================
+TaskScheduler::TaskScheduler(const TaskSchedulerConfig& config)
+    : m_epoch(0),
+    m_stopping(false),
+    m_localPops(0),
+    m_injectedPops(0),
+    m_steals(0),
+    m_failedSteals(0),
+    m_parks(0) {
+    const unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t workers = config.workers > 0 ? config.workers : hardware;
+    for (size_t p = 0; p < kTaskPriorityCount; p++) m_classes[p].cap = config.maxConcurrent[p];
+
+    for (size_t i = 0; i < workers; i++) {
+        auto worker = std::make_unique<Worker>();
+        if (config.pinWorkers) {
+            worker->cpu = config.cpus.empty() ? static_cast<int>(i % hardware) : config.cpus[i % config.cpus.size()];
+        }
+        m_workers.push_back(std::move(worker));
+    }
+    // 先把所有 Worker 建好再起线程：窃取方会遍历 m_workers
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_stopping = true;
+        m_epoch++;
+    }
+    m_parkCond.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+TaskScheduler& TaskScheduler::shared() {
+    // 函数内静态对象：首次调用时创建 (线程安全)，进程退出时析构，析构前跑完剩余任务
+    static TaskScheduler instance([] {
+        std::lock_guard<std::mutex> lock(g_sharedMutex);
+        g_sharedCreated = true;
+        return g_sharedConfig;
+    }());
+    return instance;
+}
+
+bool TaskScheduler::configureShared(const TaskSchedulerConfig& config) {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    if (g_sharedCreated) return false;
+    g_sharedConfig = config;
+    return true;
+}
+
+// ==========================================
+// 2. 提交：工作线程内提交进本地队列，其余进提交队列
+// ==========================================
+void TaskScheduler::submit(TaskPriority priority, std::function<void()> task) {
+    if (!task) return;
+    const size_t p = static_cast<size_t>(priority);
+
+    Task item{ std::move(task), std::chrono::steady_clock::now() };
+    m_classes[p].submitted++;
+    m_classes[p].queued++;
+    if (t_current.scheduler == this) {
+        Worker& self = *m_workers[t_current.index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        self.local[p].push_back(std::move(item));
+    }
+    else {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        m_injected[p].push_back(std::move(item));
+    }
+    wake();
+}
+
+void TaskScheduler::wake() {
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_epoch++;
+    }
+    m_parkCond.notify_one();
+}
+
+// ==========================================
+// 3. 工作线程：按优先级找任务，找不到就睡
+// ==========================================
+void TaskScheduler::workerLoop(size_t index) {
+    t_current.scheduler = this;
+    t_current.index = index;
+    Worker& self = *m_workers[index];
+    if (self.cpu >= 0 && !pinCurrentThread(self.cpu)) {
+        LOG_WARNING("工作线程 {} 绑定到核 {} 失败", index, self.cpu);
+        self.cpu = -1;
+    }
+
+    while (true) {
+        // 先记下唤醒计数再找：找的过程中新来的任务一定会让计数变化，不会睡过头
+        uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+            seen = m_epoch;
+        }
+
+        Task task;
+        size_t priority = 0;
+        if (findTask(index, task, priority)) {
+            execute(index, task, priority);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_parkMutex);
+        // 停止时跑完所有任务才退出 (任务里可能还会提交后续任务)；退出前叫醒还在睡的线程，它们也该走了
+        if (m_stopping && totalQueued() == 0) {
+            m_parkCond.notify_all();
+            return;
+        }
+        if (m_epoch != seen) continue;
+        m_parks++;
+        m_parkCond.wait(lock, [&] { return m_epoch != seen || (m_stopping && totalQueued() == 0); });
+    }
+}
+
+bool TaskScheduler::findTask(size_t index, Task& task, size_t& priority) {
+    for (size_t p = 0; p < kTaskPriorityCount; p++) {
+        if (m_classes[p].queued == 0) continue;
+        if (!acquireSlot(p)) {
+            m_classes[p].deferred++;
+            continue;
+        }
+        if (popLocal(index, p, task) || popInjected(p, task) || steal(index, p, task)) {
+            m_classes[p].queued--;
+            priority = p;
+            return true;
+        }
+        m_classes[p].running--; // 没拿到任务，名额还回去
+    }
+    return false;
+}
+
+bool TaskScheduler::acquireSlot(size_t priority) {
+    ClassCounters& counters = m_classes[priority];
+    size_t running = counters.running.load();
+    do {
+        if (counters.cap > 0 && running >= counters.cap) return false;
+    } while (!counters.running.compare_exchange_weak(running, running + 1));
+    updateMax(counters.peakRunning, running + 1);
+    return true;
+}
+
+bool TaskScheduler::popLocal(size_t index, size_t priority, Task& task) {
+    Worker& self = *m_workers[index];
+    std::lock_guard<std::mutex> lock(self.mutex);
+    std::deque<Task>& queue = self.local[priority];
+    if (queue.empty()) return false;
+    task = std::move(queue.back()); // 自己取队尾：刚提交的后续任务，数据还在缓存里
+    queue.pop_back();
+    m_localPops++;
+    return true;
+}
+
+bool TaskScheduler::popInjected(size_t priority, Task& task) {
+    std::lock_guard<std::mutex> lock(m_injectMutex);
+    std::deque<Task>& queue = m_injected[priority];
+    if (queue.empty()) return false;
+    task = std::move(queue.front());
+    queue.pop_front();
+    m_injectedPops++;
+    return true;
+}
+
+bool TaskScheduler::steal(size_t index, size_t priority, Task& task) {
+    const size_t count = m_workers.size();
+    for (size_t offset = 1; offset < count; offset++) {
+        Worker& victim = *m_workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        std::deque<Task>& queue = victim.local[priority];
+        if (queue.empty()) continue;
+        task = std::move(queue.front()); // 偷队首：最老的任务，与主人取队尾的一端错开
+        queue.pop_front();
+        m_steals++;
+        m_workers[index]->steals++;
+        return true;
+    }
+    m_failedSteals++;
+    return false;
+}
+
+void TaskScheduler::execute(size_t index, Task& task, size_t priority) {
+    ClassCounters& counters = m_classes[priority];
+    double waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - task.queuedAt).count();
+    counters.totalWaitMs.fetch_add(waitMs);
+    updateMax(counters.maxWaitMs, waitMs);
+
+    try {
+        task.run();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("任务抛出异常: {}", e.what());
+    }
+    catch (...) {
+        LOG_ERROR("任务抛出未知异常");
+    }
+    task.run = nullptr; // 尽快释放任务捕获的资源 (帧缓冲等)
+
+    counters.running--;
+    counters.completed++;
+    m_workers[index]->executed++;
+    // 空出一个封顶类别的名额：叫醒一条线程来接排队的任务
+    if (counters.cap > 0 && counters.queued > 0) wake();
+}
+
+size_t TaskScheduler::totalQueued() const {
+    size_t queued = 0;
+    for (const ClassCounters& counters : m_classes) queued += counters.queued;
+    return queued;
+}
+
+// ==========================================
+// 4. 统计
+// ==========================================
+size_t TaskScheduler::workerCount() const {
+    return m_workers.size();
+}
+
+TaskSchedulerStats TaskScheduler::getStats() const {
+    TaskSchedulerStats stats;
+    stats.workers = m_workers.size();
+    stats.localPops = m_localPops;
+    stats.injectedPops = m_injectedPops;
+    stats.steals = m_steals;
+    stats.failedSteals = m_failedSteals;
+    stats.parks = m_parks;
+
+    for (size_t p = 0; p < kTaskPriorityCount; p++) {
+        const ClassCounters& counters = m_classes[p];
+        TaskClassStats& s = stats.classes[p];
+        s.submitted = counters.submitted;
+        s.completed = counters.completed;
+        s.queued = counters.queued;
+        s.running = counters.running;
+        s.peakRunning = counters.peakRunning;
+        s.deferred = counters.deferred;
+        s.maxWaitMs = counters.maxWaitMs;
+        uint64_t started = s.completed + s.running;
+        s.avgWaitMs = started > 0 ? counters.totalWaitMs / static_cast<double>(started) : 0.0;
+    }
+
+    for (const auto& worker : m_workers) {
+        TaskWorkerStats w;
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            for (const auto& queue : worker->local) w.queueDepth += queue.size();
+        }
+        w.executed = worker->executed;
+        w.steals = worker->steals;
+        w.cpu = worker->cpu;
+        stats.perWorker.push_back(w);
+    }
+    return stats;
+}
@@ -2,10 +2,19 @@
 #pragma once
 
 #include "ICamera.h" // 纯 C++ 契约
+#include "FrameBufferPool.h"
+#include "AsyncFrameDispatcher.h"
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+struct HikSdkShim; // SDK 函数指针表，定义见 HikSdkShim.h
 
 class HikCamera : public ICamera {
 public:
-    HikCamera();
+    // sdk 为空时直连真实海康 SDK；测试时可传入替换过部分入口的 shim
+    explicit HikCamera(const HikSdkShim* sdk = nullptr);
     ~HikCamera() override;
 
     // ---------------------------------------------------------
@@ -15,6 +24,11 @@ public:
     CameraStatus openDevice(const std::string& serialNumber = "") override;
     CameraStatus closeDevice() override;
 
+    // 断线自动重连：注册 SDK 异常回调，断线后在内部线程上重开设备、恢复参数并续流
+    // 访问句柄的接口与重连线程互斥 (m_handleMutex)；帧回调里不要调用它们，停流时会等帧回调返回
+    void registerDeviceEventCallback(DeviceEventCallback callback) override;
+    bool isConnected() const override;
+
     CameraStatus startStream() override;
     CameraStatus stopStream() override;
 
@@ -24,8 +38,54 @@ public:
     CameraStatus setGain(float gain) override;
     float getGain() override;
     float getMaxGain() override;
+    // AcquisitionFrameRate：<= 0 时关闭 AcquisitionFrameRateEnable，按最高帧率采集
+    CameraStatus setFrameRate(double fps) override;
+
+    // 参数快照：曝光/增益/尺寸一次批量读出后缓存，上面三个 getter 也只读缓存
+    CameraParams getParams() override;
+    void invalidateParams() override;
 
     bool grabFrame(cv::Mat& outFrame, int timeoutMs = 1000) override;
+    bool grabFrame(Frame& outFrame, int timeoutMs = 1000) override;
+
+    CameraStatus setAcquisitionMode(AcquisitionMode mode) override;
+    AcquisitionMode getAcquisitionMode() const override;
+
+    CameraStatus setGrabStrategy(GrabStrategy strategy, unsigned int queueSize = 1) override;
+    GrabStrategy getGrabStrategy() const override;
+
+    CameraStatus setOutputFormat(PixelFormat format) override;
+    PixelFormat getOutputFormat() const override;
+    FormatNegotiation getFormatNegotiation() const override;
+    CameraStatus setHostDemosaic(bool inHouse, DemosaicQuality quality = DemosaicQuality::BILINEAR) override;
+
+    CameraStatus setTriggerMode(TriggerMode mode, int line = 0) override;
+    TriggerMode getTriggerMode() const override;
+    CameraStatus triggerSoftware() override;
+
+    CameraStatus setRoi(const SensorRoi& roi) override;
+    SensorRoi getRoi() const override;
+    SensorGeometry getSensorGeometry() const override;
+    CameraStatus setBinning(int factor) override;
+    int getBinning() const override;
+    CameraStatus setDecimation(int factor) override;
+    int getDecimation() const override;
+
+    FramePoolStats getFramePoolStats() const override;
+    DispatchStats getDispatchStats() const override;
+    ClockCorrelationStats getClockStats() const override;
+
+    // ---------------------------------------------------------
+    // 拉取模式专属配置
+    // ---------------------------------------------------------
+    /**
+     * @brief 设置 SDK 内部缓存节点数 (MV_CC_SetImageNodeNum)，下次开始取流时生效 (回调与拉取模式都适用)
+     * @note setGrabStrategy(LATEST_IMAGES, N) 需要更深的缓存时会自行加深并立即下发，取流中则短暂停流
+     */
+    void setImageNodeNum(unsigned int num);
+
+    // 丢弃进程内缓存的 USB 枚举结果 (设备插拔后调用)，下次枚举/打开时重新向 SDK 查询
+    static void invalidateDeviceCache();
 
     // ---------------------------------------------------------
     // 异步回调机制
@@ -33,16 +93,119 @@ public:
     void registerFrameCallback(FrameCallback callback) override;
 
     // 给底层的全局 C 函数用的公开触发接口 (解决 C2039 报错)
-    void triggerCallback(const cv::Mat& frame);
+    void triggerCallback(const Frame& frame);
 
+    // 运行在 SDK 采集线程上：只拷出原始数据并投递到转换队列，微秒级返回
     void processAndTrigger(unsigned char* pData, void* pFrameInfo);
 
+    // 运行在 SDK 异常回调线程上：断线时只通知重连线程，不在回调里操作句柄
+    void onDeviceException(unsigned int msgType);
+
+private:
+    // 拉取模式：独立抓图线程的主循环
+    void grabLoop();
+    // 把最新一帧挂到信箱里，唤醒 grabFrame() 的等待者
+    void publishLatest(const Frame& frame);
+    // 把当前保存的取流策略下发到 SDK
+    CameraStatus applyGrabStrategy();
+    // 把当前保存的触发模式下发到 SDK
+    CameraStatus applyTriggerMode();
+    // 从 Width/Height/OffsetX/OffsetY 节点读回当前 ROI (换算成全幅像素)
+    void refreshRoi();
+    // 写入成功后只重读这一个浮点节点，更新快照中的对应项 (设备可能对写入值做了钳位)
+    void refreshFloatParam(const char* key, ParamRange CameraParams::* field);
+    // 合并/抽样共用：同时设置水平与垂直两个方向的倍数
+    CameraStatus setReadoutStep(const char* horizontalKey, const char* verticalKey, int factor, std::atomic<int>& value);
+    // 重连线程主循环：等待断线通知
+    void reconnectLoop();
+    // 断线处理：收回取流线程 (不持句柄锁) -> 释放句柄 -> 限时重试打开 -> 恢复参数 -> 续流
+    void recoverDevice();
+    // 停流本体 (调用者持有 m_handleMutex)：不改 m_streamRequested，内部短暂停流再重启都走它
+    CameraStatus stopStreamLocked();
+    // 释放一个已失效的句柄 (设备已经不在，SDK 调用失败也继续)：先收回用到句柄的线程，再销毁句柄
+    void releaseHandle();
+    // 当前线程是否在取流链路上 (抓图线程，或转换线程即帧回调内)：在这里停流/关闭会等待自己
+    bool onStreamThread() const;
+    void notifyDeviceEvent(DeviceEvent event, double outageMs);
+    // 按 m_outputFormat 尝试修改传感器 PixelFormat 节点 (需在停止取流时调用)
+    CameraStatus negotiatePixelFormat();
+    // 运行在转换线程上：把原始帧转为输出格式 (ISP / 自研去马赛克)
+    bool convertFrame(FrameJob& job);
+
 private:
+    const HikSdkShim* m_sdk;    // 海康 SDK 入口表
     void* m_handle;             // 海康相机句柄
-    bool m_isStreaming;         // 取流标志位
-    FrameCallback m_callback;   // 保存上层传进来的业务逻辑
+    std::atomic<bool> m_isStreaming; // 取流标志位
+    std::mutex m_callbackMutex; // 只护住 m_callback 指针：注册回调与转换线程取回调互不干扰
+    std::shared_ptr<const FrameCallback> m_callback; // 保存上层传进来的业务逻辑 (整体替换，执行中的旧回调不受影响)
 
     // 【新增】：复刻 Demo 的核心优化
-    std::mutex m_mutex;                      // C++ 标准锁，取代 QMutex
-    std::vector<unsigned char> m_convertBuf; // 转换缓存池，取代 malloc
-};
\ No newline at end of file
+    std::mutex m_convertMutex;               // 专用转换锁：只串行化同一句柄上的 SDK 像素转换调用，不与相机状态共用
+    FrameBufferPool m_framePool;             // 页对齐帧缓冲池，取代每帧 clone()
+    AsyncFrameDispatcher m_dispatcher;       // 有界转换队列 + 转换线程池，按帧序交付回调
+    ClockCorrelator m_clock;                 // 设备时间戳 -> 主机时刻 (采集线程上按帧序喂样本)
+
+    // 像素格式协商与主机转换开销统计
+    std::atomic<PixelFormat> m_outputFormat; // 上层要求的输出格式 (UNKNOWN = 自动)
+    std::atomic<PixelFormat> m_sensorFormat; // 传感器当前输出格式
+    std::atomic<bool> m_nativeOutput;        // 最近一帧是否由传感器直出
+    std::atomic<uint64_t> m_convertedFrames; // 主机转换帧数
+    std::atomic<uint64_t> m_convertTotalUs;  // 主机转换累计耗时
+    std::atomic<uint64_t> m_lastConvertUs;   // 最近一帧主机转换耗时
+    std::atomic<uint64_t> m_incompleteDropped; // 采集线程上就地丢弃的残帧数
+    std::atomic<bool> m_inHouseDemosaic;     // Bayer 走自研引擎还是海康 ISP
+    std::atomic<DemosaicQuality> m_demosaicQuality;
+
+    // 拉取模式
+    AcquisitionMode m_mode;                  // 当前取图模式
+    unsigned int m_imageNodeNum;             // SDK 内部缓存节点数
+    GrabStrategy m_grabStrategy;             // 取流策略
+    unsigned int m_outputQueueSize;          // LATEST_IMAGES 策略下的输出队列深度
+    std::thread m_grabThread;                // 独立抓图线程
+    std::atomic<std::thread::id> m_grabThreadId; // 抓图线程的 id (不加锁判断“是否在抓图线程上”)
+    std::atomic<bool> m_grabRunning;         // 抓图线程运行标志
+
+    // 触发
+    std::atomic<TriggerMode> m_triggerMode;  // 当前触发模式
+    int m_triggerLine;                       // 硬触发输入线
+
+    // 传感器读出区域 (全幅像素)，给每帧打上 sensorRect
+    std::atomic<int> m_roiOffsetX;
+    std::atomic<int> m_roiOffsetY;
+    std::atomic<int> m_roiWidth;
+    std::atomic<int> m_roiHeight;
+    std::atomic<int> m_binning;
+    std::atomic<int> m_decimation;
+
+    // 参数快照缓存 (m_paramsValid 为 false 时下次 getParams() 批量重读)
+    std::mutex m_paramsMutex;
+    CameraParams m_params;
+    bool m_paramsValid;
+
+    // 句柄生命周期：访问句柄的公开接口与重连线程都先拿这把锁 (可重入：接口之间会互相调用)
+    // 抓图线程与转换线程不拿它，句柄总是在它们被收回之后才关闭、替换
+    mutable std::recursive_mutex m_handleMutex;
+    std::atomic<bool> m_streamRequested;      // 上层要求取流 (startStream 成功置位，stopStream 清除)，重连后据此续流
+    // 启停抓图线程与转换线程 (m_grabThread / m_dispatcher) 时持有，拿它时若还要拿 m_handleMutex 必须先拿后者；
+    // 重连线程只拿这一把来收回线程：此时帧回调里调用相机接口不会与它互等
+    std::mutex m_streamThreadMutex;
+
+    // 断线重连
+    std::string m_serialNumber;               // 打开的设备序列号，重连时按它找回同一台
+    DeviceEventCallback m_deviceEventCallback;
+    std::atomic<bool> m_connected;
+    std::atomic<float> m_lastExposureUs;      // 断线前生效的曝光/增益 (< 0 表示未知)，重连后恢复
+    std::atomic<float> m_lastGainDb;
+    std::atomic<float> m_lastFrameRate;       // 上层设置过的采集帧率 (< 0 表示从未设置，0 表示不限)
+    std::thread m_reconnectThread;
+    std::mutex m_reconnectMutex;
+    std::condition_variable m_reconnectCond;
+    bool m_reconnectPending;                  // 收到断线通知，等待重连线程处理
+    bool m_reconnectStop;                     // 关闭设备时让重连线程退出
+
+    // 最新帧信箱 (grabFrame 同步等待用)
+    std::mutex m_latestMutex;
+    std::condition_variable m_latestCond;
+    Frame m_latestFrame;
+    uint64_t m_latestSeq;
+};
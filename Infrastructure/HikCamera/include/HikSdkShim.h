@@ -0,0 +1,42 @@
+﻿// Infrastructure/HikCamera/include/HikSdkShim.h
+#pragma once
+
+#include "MvCameraControl.h"
+
+// =========================================================
+// HikSdkShim：HikCamera 用到的全部海康 SDK 入口 (函数指针表)
+// 作用：默认直连真实的 MvCameraControl，测试时可以替换其中任意几项，
+//       在没有相机、没有驱动的机器上也能驱动 HikCamera 的取流逻辑。
+// =========================================================
+struct HikSdkShim {
+    // 设备发现与生命周期
+    decltype(&MV_CC_EnumDevices) enumDevices = &MV_CC_EnumDevices;
+    decltype(&MV_CC_CreateHandle) createHandle = &MV_CC_CreateHandle;
+    decltype(&MV_CC_DestroyHandle) destroyHandle = &MV_CC_DestroyHandle;
+    decltype(&MV_CC_OpenDevice) openDevice = &MV_CC_OpenDevice;
+    decltype(&MV_CC_CloseDevice) closeDevice = &MV_CC_CloseDevice;
+    decltype(&MV_CC_RegisterExceptionCallBack) registerExceptionCallBack = &MV_CC_RegisterExceptionCallBack;
+
+    // 取流 (回调模式 / 主动拉取模式)
+    decltype(&MV_CC_StartGrabbing) startGrabbing = &MV_CC_StartGrabbing;
+    decltype(&MV_CC_StopGrabbing) stopGrabbing = &MV_CC_StopGrabbing;
+    decltype(&MV_CC_RegisterImageCallBackEx) registerImageCallBackEx = &MV_CC_RegisterImageCallBackEx;
+    decltype(&MV_CC_SetImageNodeNum) setImageNodeNum = &MV_CC_SetImageNodeNum;
+    decltype(&MV_CC_GetImageBuffer) getImageBuffer = &MV_CC_GetImageBuffer;
+    decltype(&MV_CC_FreeImageBuffer) freeImageBuffer = &MV_CC_FreeImageBuffer;
+    decltype(&MV_CC_SetGrabStrategy) setGrabStrategy = &MV_CC_SetGrabStrategy;
+    decltype(&MV_CC_SetOutputQueueSize) setOutputQueueSize = &MV_CC_SetOutputQueueSize;
+
+    // 图像处理
+    decltype(&MV_CC_ConvertPixelType) convertPixelType = &MV_CC_ConvertPixelType;
+
+    // GenICam 节点读写
+    decltype(&MV_CC_GetEnumValue) getEnumValue = &MV_CC_GetEnumValue;
+    decltype(&MV_CC_SetEnumValue) setEnumValue = &MV_CC_SetEnumValue;
+    decltype(&MV_CC_GetIntValueEx) getIntValueEx = &MV_CC_GetIntValueEx;
+    decltype(&MV_CC_SetIntValueEx) setIntValueEx = &MV_CC_SetIntValueEx;
+    decltype(&MV_CC_SetFloatValue) setFloatValue = &MV_CC_SetFloatValue;
+    decltype(&MV_CC_GetFloatValue) getFloatValue = &MV_CC_GetFloatValue;
+    decltype(&MV_CC_SetBoolValue) setBoolValue = &MV_CC_SetBoolValue;
+    decltype(&MV_CC_SetCommandValue) setCommandValue = &MV_CC_SetCommandValue;
+};
@@ -1,6 +1,10 @@
 ﻿#include "HikCamera.h"
-#include "MvCameraControl.h" 
+#include "HikSdkShim.h"
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
 // ====================================================
 // 1. 全局回调函数：极简瘦身！只做一件事：转发给类的内部函数
@@ -12,157 +16,1096 @@ static void __stdcall GlobalImageCallback(unsigned char* pData, MV_FRAME_OUT_INF
     }
 }
 
+static void __stdcall GlobalExceptionCallback(unsigned int nMsgType, void* pUser) {
+    if (pUser) {
+        static_cast<HikCamera*>(pUser)->onDeviceException(nMsgType);
+    }
+}
+
 // ====================================================
 // 2. 构造、析构与流控制
 // ====================================================
-HikCamera::HikCamera() : m_handle(nullptr), m_isStreaming(false) {}
+// 同时在路上的帧 (转换队列里的原始帧 + UI 队列 + 存图 + 算法) 一般不超过这个数，耗尽时会回退到堆内存并计数
+static constexpr size_t kFramePoolSlots = 16;
+
+// 转换队列最多积压的原始帧数：再多说明转换跟不上采集，继续排队只会让延迟越来越大
+static constexpr size_t kDispatchQueueCapacity = 4;
+
+// 转换线程数：Bayer 转换本身已按行条带多线程并行，两条线程足以让转换与交付流水起来
+static constexpr unsigned int kConvertWorkers = 2;
+
+// 拉取模式下单次 MV_CC_GetImageBuffer 的等待上限，同时决定了停止抓图线程的最长等待时间
+static constexpr unsigned int kGrabPollMs = 100;
+
+// 海康双 U 相机默认只有 3 个节点，拉取模式下适当加深，给抓图线程留出抖动余量
+static constexpr unsigned int kDefaultImageNodeNum = 5;
+
+// 断线重连：每隔 kReconnectInterval 尝试重开一次，超过 kReconnectTimeout 仍未恢复则放弃并上报
+// (USB 设备重新上电后一般 1~3 秒内可以再次枚举到)
+static constexpr auto kReconnectInterval = std::chrono::milliseconds(500);
+static constexpr auto kReconnectTimeout = std::chrono::seconds(10);
+
+static const HikSdkShim& defaultSdk() {
+    static const HikSdkShim sdk;
+    return sdk;
+}
+
+HikCamera::HikCamera(const HikSdkShim* sdk)
+    : m_sdk(sdk ? sdk : &defaultSdk()),
+    m_handle(nullptr),
+    m_isStreaming(false),
+    m_framePool(kFramePoolSlots),
+    m_dispatcher(kDispatchQueueCapacity, kConvertWorkers),
+    m_outputFormat(PixelFormat::UNKNOWN),
+    m_sensorFormat(PixelFormat::UNKNOWN),
+    m_nativeOutput(false),
+    m_convertedFrames(0),
+    m_convertTotalUs(0),
+    m_lastConvertUs(0),
+    m_incompleteDropped(0),
+    m_inHouseDemosaic(false),
+    m_demosaicQuality(DemosaicQuality::BILINEAR),
+    m_mode(AcquisitionMode::PUSH),
+    m_imageNodeNum(kDefaultImageNodeNum),
+    m_grabStrategy(GrabStrategy::ONE_BY_ONE),
+    m_outputQueueSize(1),
+    m_grabRunning(false),
+    m_grabThreadId(),
+    m_triggerMode(TriggerMode::FREE_RUN),
+    m_triggerLine(0),
+    m_roiOffsetX(0),
+    m_roiOffsetY(0),
+    m_roiWidth(0),
+    m_roiHeight(0),
+    m_binning(1),
+    m_decimation(1),
+    m_paramsValid(false),
+    m_streamRequested(false),
+    m_connected(false),
+    m_lastExposureUs(-1.0f),
+    m_lastGainDb(-1.0f),
+    m_lastFrameRate(-1.0f),
+    m_reconnectPending(false),
+    m_reconnectStop(false),
+    m_latestSeq(0) {
+}
 
 HikCamera::~HikCamera() {
     closeDevice();
 }
 
 void HikCamera::registerFrameCallback(FrameCallback callback) {
-    m_callback = callback;
+    // 转换线程随时可能在调用回调：整体换成新的一份，正在执行旧回调的线程持有旧的直到返回
+    std::shared_ptr<const FrameCallback> holder;
+    if (callback) holder = std::make_shared<const FrameCallback>(std::move(callback));
+
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_callback.swap(holder);
 }
 
-void HikCamera::triggerCallback(const cv::Mat& frame) {
-    if (m_callback) m_callback(frame);
+void HikCamera::triggerCallback(const Frame& frame) {
+    std::shared_ptr<const FrameCallback> callback;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        callback = m_callback;
+    }
+    if (callback) (*callback)(frame);
 }
 
 CameraStatus HikCamera::startStream() {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
     if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+    if (m_isStreaming) {
+        m_streamRequested = true;
+        return CameraStatus::SUCCESS;
+    }
 
-    MV_CC_RegisterImageCallBackEx(m_handle, GlobalImageCallback, this);
+    std::lock_guard<std::mutex> threadLock(m_streamThreadMutex);
+    if (m_mode == AcquisitionMode::PUSH) {
+        m_sdk->registerImageCallBackEx(m_handle, GlobalImageCallback, this);
+    }
+    else {
+        // 回调与 MV_CC_GetImageBuffer 互斥：拉取模式必须先拔掉回调
+        m_sdk->registerImageCallBackEx(m_handle, nullptr, nullptr);
+    }
 
-    if (MV_CC_StartGrabbing(m_handle) == MV_OK) {
-        m_isStreaming = true;
-        return CameraStatus::SUCCESS;
+    // 缓存节点在开始取流时分配：两种模式都要下发，LATEST_IMAGES 的输出队列深度不能超过它
+    m_sdk->setImageNodeNum(m_handle, m_imageNodeNum);
+
+    // 打开设备后 SDK 默认是 OneByOne，这里把上层选好的策略补下发一次
+    applyGrabStrategy();
+
+    // 转换线程池必须先于第一帧就位
+    m_dispatcher.start(
+        [this](FrameJob& job) { return convertFrame(job); },
+        [this](const Frame& frame) {
+            // 引用计数发送：最后一个消费者用完后缓冲自动回到池中
+            publishLatest(frame);
+            triggerCallback(frame);
+        });
+
+    if (m_sdk->startGrabbing(m_handle) != MV_OK) {
+        m_dispatcher.stop();
+        return CameraStatus::STREAM_FAILED;
+    }
+    m_isStreaming = true;
+    m_streamRequested = true;
+
+    if (m_mode == AcquisitionMode::PULL) {
+        m_grabRunning = true;
+        m_grabThread = std::thread(&HikCamera::grabLoop, this);
     }
-    return CameraStatus::STREAM_FAILED;
+    return CameraStatus::SUCCESS;
 }
 
 CameraStatus HikCamera::stopStream() {
+    // 在抓图线程或转换线程 (帧回调) 自己身上 join 只会死锁：拒绝，由调用者换个线程再停
+    // (必须在拿锁之前判断：持锁的停流正等着这些线程退出)
+    if (onStreamThread()) {
+        std::cerr << "[HikCamera] 不能在抓图线程或帧回调里停止取流" << std::endl;
+        return CameraStatus::STREAM_FAILED;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    // 断线期间停流也要记住：重连成功后不再自动续流
+    m_streamRequested = false;
+    return stopStreamLocked();
+}
+
+CameraStatus HikCamera::stopStreamLocked() {
+    // 内部调用者 (setRoi 等) 可能就在帧回调里：同样拒绝
+    if (onStreamThread()) {
+        std::cerr << "[HikCamera] 不能在抓图线程或帧回调里停止取流" << std::endl;
+        return CameraStatus::STREAM_FAILED;
+    }
     if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
 
+    std::lock_guard<std::mutex> threadLock(m_streamThreadMutex);
+    // 先收回抓图线程 (最多等一个 kGrabPollMs)，它手里可能还攥着 SDK 的缓存节点
+    m_grabRunning = false;
+    if (m_grabThread.joinable()) m_grabThread.join();
+    m_grabThreadId = std::thread::id();
+
     // 拔掉回调水管，防止退出时崩溃
-    MV_CC_RegisterImageCallBackEx(m_handle, nullptr, nullptr);
+    m_sdk->registerImageCallBackEx(m_handle, nullptr, nullptr);
+
+    int nRet = m_sdk->stopGrabbing(m_handle);
+
+    // 采集已停，积压的原始帧不再有意义：丢弃并等正在交付的那一帧结束
+    m_dispatcher.stop();
+
+    // 抓图线程与转换线程都已收回，不论 SDK 停流成功与否都不会再有帧交付，状态如实置为未取流
+    m_isStreaming = false;
+    m_latestCond.notify_all(); // 让还在 grabFrame() 里等待的调用者立即返回
+
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 停止取流失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::STREAM_FAILED;
+    }
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 2.1 取图模式切换 (取流中切换只重启取流，不重新打开设备)
+// ====================================================
+CameraStatus HikCamera::setAcquisitionMode(AcquisitionMode mode) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    if (mode == m_mode) return CameraStatus::SUCCESS;
+
+    bool wasStreaming = m_isStreaming;
+    if (wasStreaming) {
+        CameraStatus status = stopStreamLocked();
+        if (status != CameraStatus::SUCCESS) return status;
+    }
+
+    m_mode = mode;
+
+    if (wasStreaming) return startStream();
+    return CameraStatus::SUCCESS;
+}
+
+AcquisitionMode HikCamera::getAcquisitionMode() const {
+    return m_mode;
+}
+
+void HikCamera::setImageNodeNum(unsigned int num) {
+    m_imageNodeNum = (num == 0) ? 1 : num;
+}
+
+// ====================================================
+// 2.2 取流策略 (SDK 允许取流中途调整，不需要重启取流)
+// ====================================================
+CameraStatus HikCamera::setGrabStrategy(GrabStrategy strategy, unsigned int queueSize) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    GrabStrategy prevStrategy = m_grabStrategy;
+    unsigned int prevQueueSize = m_outputQueueSize;
+    unsigned int prevNodeNum = m_imageNodeNum;
+
+    m_grabStrategy = strategy;
+    m_outputQueueSize = (queueSize == 0) ? 1 : queueSize;
+
+    // SDK 要求 OutputQueueSize 不超过 ImageNodeNum，不够深就顺带加深
+    if (m_grabStrategy == GrabStrategy::LATEST_IMAGES && m_outputQueueSize > m_imageNodeNum) {
+        m_imageNodeNum = m_outputQueueSize;
+    }
+
+    if (m_handle == nullptr) return CameraStatus::SUCCESS; // 先记下，openDevice 后开始取流时再下发
+
+    // 缓存节点只在开始取流时分配：取流中加深需要短暂停流 (不重新打开设备)，startStream 会按新深度重新下发
+    CameraStatus status = CameraStatus::SUCCESS;
+    bool restart = false;
+    if (m_imageNodeNum != prevNodeNum) {
+        restart = m_isStreaming;
+        if (restart) status = stopStreamLocked();
+        if (status == CameraStatus::SUCCESS) {
+            int nRet = m_sdk->setImageNodeNum(m_handle, m_imageNodeNum);
+            if (nRet != MV_OK) {
+                std::cerr << "[HikCamera] 设置缓存节点数失败! 错误码: " << std::hex << nRet << std::endl;
+                status = CameraStatus::PARAM_SET_FAILED;
+            }
+        }
+    }
+    if (status == CameraStatus::SUCCESS) status = applyGrabStrategy();
+
+    if (status != CameraStatus::SUCCESS) {
+        // 设备上的配置没有全部生效：驱动侧回到调用前的状态，并把旧策略重新下发一次
+        m_grabStrategy = prevStrategy;
+        m_outputQueueSize = prevQueueSize;
+        m_imageNodeNum = prevNodeNum;
+        applyGrabStrategy();
+    }
+
+    if (restart) {
+        CameraStatus restartStatus = startStream();
+        if (status == CameraStatus::SUCCESS) status = restartStatus;
+    }
+    return status;
+}
+
+GrabStrategy HikCamera::getGrabStrategy() const {
+    return m_grabStrategy;
+}
+
+CameraStatus HikCamera::applyGrabStrategy() {
+    MV_GRAB_STRATEGY enStrategy = MV_GrabStrategy_OneByOne;
+    switch (m_grabStrategy) {
+    case GrabStrategy::ONE_BY_ONE:         enStrategy = MV_GrabStrategy_OneByOne; break;
+    case GrabStrategy::LATEST_IMAGES_ONLY: enStrategy = MV_GrabStrategy_LatestImagesOnly; break;
+    case GrabStrategy::LATEST_IMAGES:      enStrategy = MV_GrabStrategy_LatestImages; break;
+    }
+
+    int nRet = m_sdk->setGrabStrategy(m_handle, enStrategy);
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 设置取流策略失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+
+    if (m_grabStrategy == GrabStrategy::LATEST_IMAGES) {
+        nRet = m_sdk->setOutputQueueSize(m_handle, m_outputQueueSize);
+        if (nRet != MV_OK) {
+            std::cerr << "[HikCamera] 设置输出队列深度失败! 错误码: " << std::hex << nRet << std::endl;
+            return CameraStatus::PARAM_SET_FAILED;
+        }
+    }
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 2.3 拉取模式：独立抓图线程
+// ====================================================
+void HikCamera::grabLoop() {
+    m_grabThreadId = std::this_thread::get_id();
+    while (m_grabRunning) {
+        MV_FRAME_OUT stFrame;
+        memset(&stFrame, 0, sizeof(MV_FRAME_OUT));
+
+        // 超时返回属于正常现象 (例如触发模式下没有触发信号)，继续轮询即可
+        if (m_sdk->getImageBuffer(m_handle, &stFrame, kGrabPollMs) != MV_OK) continue;
+
+        processAndTrigger(stFrame.pBufAddr, &stFrame.stFrameInfo);
 
-    if (MV_CC_StopGrabbing(m_handle) == MV_OK) {
-        m_isStreaming = false;
+        // 数据已经拷进帧缓冲池，立刻把节点还给 SDK
+        m_sdk->freeImageBuffer(m_handle, &stFrame);
+    }
+}
+
+void HikCamera::publishLatest(const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_latestMutex);
+        m_latestFrame = frame; // 仅增加引用计数
+        m_latestSeq++;
+    }
+    m_latestCond.notify_all();
+}
+
+// ====================================================
+// 2.4 触发模式 (触发模式下帧信息里的 nTriggerIndex 即触发计数)
+// ====================================================
+CameraStatus HikCamera::setTriggerMode(TriggerMode mode, int line) {
+    if (mode == TriggerMode::HARDWARE && (line < 0 || line > 3)) return CameraStatus::PARAM_SET_FAILED;
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    TriggerMode prevMode = m_triggerMode;
+    int prevLine = m_triggerLine;
+    m_triggerMode = mode;
+    m_triggerLine = line;
+
+    if (m_handle == nullptr) return CameraStatus::SUCCESS; // 先记下，openDevice 时再下发
+
+    CameraStatus status = applyTriggerMode();
+    if (status != CameraStatus::SUCCESS) {
+        // 设备拒绝：驱动侧回到调用前的模式 (triggerSoftware 等据此判断)，并尽量把设备也恢复过去
+        m_triggerMode = prevMode;
+        m_triggerLine = prevLine;
+        applyTriggerMode();
+    }
+    return status;
+}
+
+TriggerMode HikCamera::getTriggerMode() const {
+    return m_triggerMode;
+}
+
+CameraStatus HikCamera::applyTriggerMode() {
+    if (m_triggerMode == TriggerMode::FREE_RUN) {
+        int nRet = m_sdk->setEnumValue(m_handle, "TriggerMode", MV_TRIGGER_MODE_OFF);
+        if (nRet != MV_OK) {
+            std::cerr << "[HikCamera] 关闭触发模式失败! 错误码: " << std::hex << nRet << std::endl;
+            return CameraStatus::PARAM_SET_FAILED;
+        }
         return CameraStatus::SUCCESS;
     }
-    return CameraStatus::STREAM_FAILED;
+
+    unsigned int source = (m_triggerMode == TriggerMode::SOFTWARE) ?
+        MV_TRIGGER_SOURCE_SOFTWARE : MV_TRIGGER_SOURCE_LINE0 + static_cast<unsigned int>(m_triggerLine);
+    int nRet = m_sdk->setEnumValue(m_handle, "TriggerMode", MV_TRIGGER_MODE_ON);
+    if (nRet == MV_OK) nRet = m_sdk->setEnumValue(m_handle, "TriggerSource", source);
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 设置触发模式失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus HikCamera::triggerSoftware() {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+    if (m_triggerMode != TriggerMode::SOFTWARE) return CameraStatus::PARAM_SET_FAILED;
+    if (!m_isStreaming) return CameraStatus::STREAM_FAILED;
+
+    int nRet = m_sdk->setCommandValue(m_handle, "TriggerSoftware");
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 软触发失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 2.5 传感器 ROI、合并与抽样
+// 海康的 Width/Height/OffsetX/OffsetY 节点以合并后的像素为单位，对外统一换算成全幅像素
+// ====================================================
+SensorGeometry HikCamera::getSensorGeometry() const {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    SensorGeometry geometry;
+    if (m_handle == nullptr) return geometry;
+
+    MVCC_INTVALUE_EX stWidth = { 0 }, stHeight = { 0 }, stOffsetX = { 0 }, stOffsetY = { 0 };
+    MVCC_INTVALUE_EX stWidthMax = { 0 }, stHeightMax = { 0 };
+    if (m_sdk->getIntValueEx(m_handle, "Width", &stWidth) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "Height", &stHeight) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "OffsetX", &stOffsetX) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "OffsetY", &stOffsetY) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "WidthMax", &stWidthMax) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "HeightMax", &stHeightMax) != MV_OK) {
+        return geometry;
+    }
+
+    const int step = m_binning * m_decimation;
+    geometry.maxWidth = static_cast<int>(stWidthMax.nCurValue) * step;
+    geometry.maxHeight = static_cast<int>(stHeightMax.nCurValue) * step;
+    geometry.minWidth = static_cast<int>(std::max<int64_t>(stWidth.nMin, 1)) * step;
+    geometry.minHeight = static_cast<int>(std::max<int64_t>(stHeight.nMin, 1)) * step;
+    geometry.widthStep = static_cast<int>(std::max<int64_t>(stWidth.nInc, 1)) * step;
+    geometry.heightStep = static_cast<int>(std::max<int64_t>(stHeight.nInc, 1)) * step;
+    geometry.offsetXStep = static_cast<int>(std::max<int64_t>(stOffsetX.nInc, 1)) * step;
+    geometry.offsetYStep = static_cast<int>(std::max<int64_t>(stOffsetY.nInc, 1)) * step;
+    geometry.liveOffset = true; // 取流中 Width/Height 被锁定，但 OffsetX/OffsetY 可以直接改
+    return geometry;
+}
+
+SensorRoi HikCamera::getRoi() const {
+    SensorRoi roi;
+    roi.offsetX = m_roiOffsetX;
+    roi.offsetY = m_roiOffsetY;
+    roi.width = m_roiWidth;
+    roi.height = m_roiHeight;
+    return roi;
+}
+
+void HikCamera::refreshRoi() {
+    MVCC_INTVALUE_EX stWidth = { 0 }, stHeight = { 0 }, stOffsetX = { 0 }, stOffsetY = { 0 };
+    if (m_sdk->getIntValueEx(m_handle, "Width", &stWidth) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "Height", &stHeight) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "OffsetX", &stOffsetX) != MV_OK ||
+        m_sdk->getIntValueEx(m_handle, "OffsetY", &stOffsetY) != MV_OK) {
+        return;
+    }
+
+    const int step = m_binning * m_decimation;
+    m_roiOffsetX = static_cast<int>(stOffsetX.nCurValue) * step;
+    m_roiOffsetY = static_cast<int>(stOffsetY.nCurValue) * step;
+    m_roiWidth = static_cast<int>(stWidth.nCurValue) * step;
+    m_roiHeight = static_cast<int>(stHeight.nCurValue) * step;
+    invalidateParams(); // 输出尺寸变了
+}
+
+CameraStatus HikCamera::setRoi(const SensorRoi& roi) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+
+    SensorGeometry geometry = getSensorGeometry();
+    if (geometry.maxWidth == 0) return CameraStatus::PARAM_SET_FAILED;
+
+    SensorRoi target = geometry.align(roi);
+    SensorRoi current = getRoi();
+    if (target == current) return CameraStatus::SUCCESS;
+    const int step = m_binning * m_decimation;
+
+    // A. 尺寸不变：取流中直接平移，不打断取流
+    if (target.width == current.width && target.height == current.height) {
+        if (m_sdk->setIntValueEx(m_handle, "OffsetX", target.offsetX / step) == MV_OK &&
+            m_sdk->setIntValueEx(m_handle, "OffsetY", target.offsetY / step) == MV_OK) {
+            refreshRoi();
+            return CameraStatus::SUCCESS;
+        }
+        // 个别型号取流中也不允许改偏移：退回下面的停流修改
+    }
+
+    // B. 尺寸改变：Width/Height 在取流期间被 SDK 锁定，只能短暂停止取流 (不关闭设备)
+    //    停不下来 (如在帧回调里调用) 就一个节点也不写：偏移归零在取流中也会生效，ROI 会跳到原点
+    bool wasStreaming = m_isStreaming;
+    if (wasStreaming) {
+        CameraStatus status = stopStreamLocked();
+        if (status != CameraStatus::SUCCESS) return status;
+    }
+
+    // 先把偏移归零，保证新尺寸在任何位置都合法；再设尺寸，最后设偏移
+    int nRet = m_sdk->setIntValueEx(m_handle, "OffsetX", 0);
+    if (nRet == MV_OK) nRet = m_sdk->setIntValueEx(m_handle, "OffsetY", 0);
+    if (nRet == MV_OK) nRet = m_sdk->setIntValueEx(m_handle, "Width", target.width / step);
+    if (nRet == MV_OK) nRet = m_sdk->setIntValueEx(m_handle, "Height", target.height / step);
+    if (nRet == MV_OK) nRet = m_sdk->setIntValueEx(m_handle, "OffsetX", target.offsetX / step);
+    if (nRet == MV_OK) nRet = m_sdk->setIntValueEx(m_handle, "OffsetY", target.offsetY / step);
+    refreshRoi();
+
+    if (wasStreaming && startStream() != CameraStatus::SUCCESS) return CameraStatus::STREAM_FAILED;
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 设置 ROI 失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus HikCamera::setBinning(int factor) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    return setReadoutStep("BinningHorizontal", "BinningVertical", factor, m_binning);
+}
+
+int HikCamera::getBinning() const {
+    return m_binning;
+}
+
+CameraStatus HikCamera::setDecimation(int factor) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    return setReadoutStep("DecimationHorizontal", "DecimationVertical", factor, m_decimation);
+}
+
+int HikCamera::getDecimation() const {
+    return m_decimation;
+}
+
+CameraStatus HikCamera::setReadoutStep(const char* horizontalKey, const char* verticalKey, int factor, std::atomic<int>& value) {
+    if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+    if (factor != 1 && factor != 2 && factor != 4) return CameraStatus::PARAM_SET_FAILED;
+    if (factor == value) return CameraStatus::SUCCESS;
+
+    // 输出尺寸随之改变，同样需要短暂停止取流 (停不下来就不动节点)
+    bool wasStreaming = m_isStreaming;
+    if (wasStreaming) {
+        CameraStatus status = stopStreamLocked();
+        if (status != CameraStatus::SUCCESS) return status;
+    }
+
+    int nRet = m_sdk->setEnumValue(m_handle, horizontalKey, static_cast<unsigned int>(factor));
+    if (nRet == MV_OK) nRet = m_sdk->setEnumValue(m_handle, verticalKey, static_cast<unsigned int>(factor));
+    if (nRet == MV_OK) value = factor;
+    refreshRoi();
+
+    if (wasStreaming && startStream() != CameraStatus::SUCCESS) return CameraStatus::STREAM_FAILED;
+    if (nRet != MV_OK) {
+        std::cerr << "[HikCamera] 设置 " << horizontalKey << " 失败! 错误码: " << std::hex << nRet << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+    return CameraStatus::SUCCESS;
 }
 
 // ====================================================
 // 3. 设备连接与初始化 (纯 USB 极速版)
 // ====================================================
+// USB 枚举要几十到几百毫秒，而 CameraManager 会先用临时实例枚举一遍、紧接着逐台打开：
+// 短时间内的重复枚举直接复用上一次的结果。设备信息按值拷贝，不依赖 SDK 内部的内存。
+static constexpr auto kEnumCacheTtl = std::chrono::seconds(2);
+
+namespace {
+    struct DeviceCache {
+        std::mutex mutex;
+        const HikSdkShim* sdk = nullptr;  // 哪一套 SDK 入口枚举出来的 (测试的假 SDK 与真实 SDK 互不串用)
+        std::chrono::steady_clock::time_point updated;
+        std::vector<MV_CC_DEVICE_INFO> devices;
+    };
+
+    DeviceCache& deviceCache() {
+        static DeviceCache cache;
+        return cache;
+    }
+
+    // 取 USB 设备列表：缓存未过期且来自同一套 SDK 时直接返回，否则重新枚举
+    bool listUsbDevices(const HikSdkShim* sdk, bool forceRefresh, std::vector<MV_CC_DEVICE_INFO>& devices) {
+        DeviceCache& cache = deviceCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (!forceRefresh && cache.sdk == sdk && now - cache.updated < kEnumCacheTtl) {
+            devices = cache.devices;
+            return true;
+        }
+
+        MV_CC_DEVICE_INFO_LIST stDeviceList;
+        memset(&stDeviceList, 0, sizeof(MV_CC_DEVICE_INFO_LIST));
+        if (sdk->enumDevices(MV_USB_DEVICE, &stDeviceList) != MV_OK) {
+            cache.sdk = nullptr;
+            return false;
+        }
+
+        cache.devices.clear();
+        for (unsigned int i = 0; i < stDeviceList.nDeviceNum; i++) {
+            if (stDeviceList.pDeviceInfo[i]->nTLayerType == MV_USB_DEVICE) {
+                cache.devices.push_back(*stDeviceList.pDeviceInfo[i]);
+            }
+        }
+        cache.sdk = sdk;
+        cache.updated = now;
+        devices = cache.devices;
+        return true;
+    }
+
+    std::string serialOf(const MV_CC_DEVICE_INFO& info) {
+        return reinterpret_cast<const char*>(info.SpecialInfo.stUsb3VInfo.chSerialNumber);
+    }
+}
+
+void HikCamera::invalidateDeviceCache() {
+    DeviceCache& cache = deviceCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.sdk = nullptr;
+}
+
 std::vector<CameraInfo> HikCamera::enumDevices() {
     std::vector<CameraInfo> cameraList;
-    MV_CC_DEVICE_INFO_LIST stDeviceList;
-    memset(&stDeviceList, 0, sizeof(MV_CC_DEVICE_INFO_LIST));
-
-    if (MV_CC_EnumDevices(MV_USB_DEVICE, &stDeviceList) != MV_OK) return cameraList;
-
-    for (unsigned int i = 0; i < stDeviceList.nDeviceNum; i++) {
-        MV_CC_DEVICE_INFO* pInfo = stDeviceList.pDeviceInfo[i];
-        if (pInfo->nTLayerType == MV_USB_DEVICE) {
-            CameraInfo info;
-            info.serialNumber = reinterpret_cast<char*>(pInfo->SpecialInfo.stUsb3VInfo.chSerialNumber);
-            info.modelName = reinterpret_cast<char*>(pInfo->SpecialInfo.stUsb3VInfo.chModelName);
-            info.ipAddress = "USB3.0 Direct Connection";
-            cameraList.push_back(info);
-        }
+    std::vector<MV_CC_DEVICE_INFO> devices;
+    if (!listUsbDevices(m_sdk, false, devices)) return cameraList;
+
+    for (const MV_CC_DEVICE_INFO& device : devices) {
+        CameraInfo info;
+        info.serialNumber = serialOf(device);
+        info.modelName = reinterpret_cast<const char*>(device.SpecialInfo.stUsb3VInfo.chModelName);
+        info.ipAddress = "USB3.0 Direct Connection";
+        cameraList.push_back(info);
     }
     return cameraList;
 }
 
 CameraStatus HikCamera::openDevice(const std::string& serialNumber) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
     if (m_handle != nullptr) return CameraStatus::SUCCESS;
 
-    MV_CC_DEVICE_INFO_LIST stDeviceList;
-    if (MV_CC_EnumDevices(MV_USB_DEVICE, &stDeviceList) != MV_OK || stDeviceList.nDeviceNum == 0) {
-        return CameraStatus::DEVICE_NOT_FOUND;
-    }
-
-    int targetIndex = 0; // 默认第一台
-    if (!serialNumber.empty()) {
-        targetIndex = -1;
-        for (unsigned int i = 0; i < stDeviceList.nDeviceNum; i++) {
-            if (stDeviceList.pDeviceInfo[i]->nTLayerType == MV_USB_DEVICE) {
-                if (std::string(reinterpret_cast<char*>(stDeviceList.pDeviceInfo[i]->SpecialInfo.stUsb3VInfo.chSerialNumber)) == serialNumber) {
-                    targetIndex = i;
-                    break;
-                }
+    // 先查缓存；缓存里没有这台 (可能是刚插上的) 再强制重新枚举一次
+    MV_CC_DEVICE_INFO target;
+    bool found = false;
+    for (bool refresh : { false, true }) {
+        std::vector<MV_CC_DEVICE_INFO> devices;
+        if (!listUsbDevices(m_sdk, refresh, devices)) continue;
+        for (const MV_CC_DEVICE_INFO& device : devices) {
+            if (serialNumber.empty() || serialOf(device) == serialNumber) { // 未指定时默认第一台
+                target = device;
+                found = true;
+                break;
             }
         }
-        if (targetIndex == -1) return CameraStatus::DEVICE_NOT_FOUND;
+        if (found) break;
     }
+    if (!found) return CameraStatus::DEVICE_NOT_FOUND;
 
     // A. 创建句柄
-    if (MV_CC_CreateHandle(&m_handle, stDeviceList.pDeviceInfo[targetIndex]) != MV_OK) return CameraStatus::OPEN_FAILED;
+    if (m_sdk->createHandle(&m_handle, &target) != MV_OK) {
+        m_handle = nullptr;
+        invalidateDeviceCache(); // 缓存的设备信息可能已经过时 (设备被拔掉或重新插上)
+        return CameraStatus::OPEN_FAILED;
+    }
 
     // B. 【Bug修复】：必须先打开设备，才能设置参数！
-    if (MV_CC_OpenDevice(m_handle) != MV_OK) {
-        MV_CC_DestroyHandle(m_handle);
+    if (m_sdk->openDevice(m_handle, MV_ACCESS_Exclusive, 0) != MV_OK) {
+        m_sdk->destroyHandle(m_handle);
         m_handle = nullptr;
+        invalidateDeviceCache();
         return CameraStatus::OPEN_FAILED;
     }
 
-    // C. 强设核心参数 (连续曝光、自动白平衡、关闭触发)
-    MV_CC_SetEnumValue(m_handle, "ExposureAuto", 0);
-    MV_CC_SetEnumValue(m_handle, "BalanceWhiteAuto", 2);
-    MV_CC_SetEnumValue(m_handle, "TriggerMode", 0);
+    // 断线时 SDK 从异常回调通知我们 (重连线程在首次打开时启动，重连时复用)
+    m_serialNumber = serialOf(target);
+    m_sdk->registerExceptionCallBack(m_handle, GlobalExceptionCallback, this);
+    m_connected = true;
+    if (!m_reconnectThread.joinable()) {
+        m_reconnectStop = false;
+        m_reconnectPending = false;
+        m_reconnectThread = std::thread(&HikCamera::reconnectLoop, this);
+    }
+
+    // C. 强设核心参数 (关闭自动曝光、自动白平衡)，触发模式按上层设置下发 (默认关闭触发)
+    m_sdk->setEnumValue(m_handle, "ExposureAuto", 0);
+    m_sdk->setEnumValue(m_handle, "BalanceWhiteAuto", 2);
+    applyTriggerMode();
+
+    // 上层在打开设备之前就指定了输出格式，这里补做一次协商
+    negotiatePixelFormat();
+
+    // D. 按当前分辨率一次性预分配帧缓冲池 (按 RGB8 最坏情况计算)，稳态取流不再分配内存
+    MVCC_INTVALUE_EX stWidth = { 0 };
+    MVCC_INTVALUE_EX stHeight = { 0 };
+    if (m_sdk->getIntValueEx(m_handle, "Width", &stWidth) == MV_OK &&
+        m_sdk->getIntValueEx(m_handle, "Height", &stHeight) == MV_OK) {
+        m_framePool.reserve(static_cast<size_t>(stWidth.nCurValue) * static_cast<size_t>(stHeight.nCurValue) * 3);
+    }
+    refreshRoi();
 
     return CameraStatus::SUCCESS;
 }
 
 CameraStatus HikCamera::closeDevice() {
+    if (onStreamThread()) {
+        std::cerr << "[HikCamera] 不能在抓图线程或帧回调里关闭设备" << std::endl;
+        return CameraStatus::STREAM_FAILED;
+    }
+
+    // 先让重连线程退出，它随时可能重新打开句柄
+    {
+        std::lock_guard<std::mutex> lock(m_reconnectMutex);
+        m_reconnectStop = true;
+    }
+    m_reconnectCond.notify_all();
+    if (m_reconnectThread.joinable()) m_reconnectThread.join();
+    m_connected = false;
+
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    m_streamRequested = false;
+    releaseHandle();
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 3.1 断线自动重连
+// SDK 的异常回调里不能操作句柄，只负责叫醒重连线程；重连线程释放旧句柄后限时重试，
+// 打开成功即按断线前的状态恢复合并/抽样、ROI、曝光、增益、帧率，再续上取流。
+// 触发模式、像素格式与取流策略保存在成员里，openDevice/startStream 本来就会重新下发。
+// ====================================================
+void HikCamera::registerDeviceEventCallback(DeviceEventCallback callback) {
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    m_deviceEventCallback = callback;
+}
+
+bool HikCamera::isConnected() const {
+    return m_connected;
+}
+
+void HikCamera::onDeviceException(unsigned int msgType) {
+    if (msgType != MV_EXCEPTION_DEV_DISCONNECT) return;
+    {
+        std::lock_guard<std::mutex> lock(m_reconnectMutex);
+        m_reconnectPending = true;
+    }
+    m_connected = false;
+    m_reconnectCond.notify_all();
+}
+
+void HikCamera::notifyDeviceEvent(DeviceEvent event, double outageMs) {
+    DeviceEventCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_reconnectMutex);
+        callback = m_deviceEventCallback;
+    }
+    if (callback) callback(event, outageMs);
+}
+
+void HikCamera::reconnectLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_reconnectMutex);
+            m_reconnectCond.wait(lock, [this] { return m_reconnectStop || m_reconnectPending; });
+            if (m_reconnectStop) return;
+            m_reconnectPending = false;
+        }
+        recoverDevice();
+    }
+}
+
+void HikCamera::releaseHandle() {
+    // 与 stopStream 同样的顺序：先收回抓图线程、停掉 SDK 取流，再收回转换线程 (它们还会用句柄做像素转换)
+    {
+        std::lock_guard<std::mutex> threadLock(m_streamThreadMutex);
+        m_grabRunning = false;
+        if (m_grabThread.joinable()) m_grabThread.join();
+        m_grabThreadId = std::thread::id();
+
+        if (m_handle != nullptr) {
+            m_sdk->registerImageCallBackEx(m_handle, nullptr, nullptr);
+            m_sdk->stopGrabbing(m_handle);
+        }
+        m_dispatcher.stop();
+    }
+
+    // 已经没有线程在用句柄，才能关闭并销毁它
     if (m_handle != nullptr) {
-        if (m_isStreaming) stopStream();
-        MV_CC_CloseDevice(m_handle);
-        MV_CC_DestroyHandle(m_handle);
+        m_sdk->closeDevice(m_handle);
+        m_sdk->destroyHandle(m_handle);
         m_handle = nullptr;
     }
-    return CameraStatus::SUCCESS;
+    m_isStreaming = false;
+    m_latestCond.notify_all();
+    invalidateParams();
+}
+
+bool HikCamera::onStreamThread() const {
+    return std::this_thread::get_id() == m_grabThreadId.load() || m_dispatcher.isWorkerThread();
+}
+
+void HikCamera::recoverDevice() {
+    const auto begin = std::chrono::steady_clock::now();
+    auto outageMs = [&]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(); };
+
+    std::cerr << "[HikCamera] 设备 " << m_serialNumber << " 断开连接，开始自动重连" << std::endl;
+    notifyDeviceEvent(DeviceEvent::DISCONNECTED, 0.0);
+
+    // A. 先不拿句柄锁收回抓图线程与转换线程：正在交付的帧回调可能正调用 getParams/setRoi 等接口，
+    //    持句柄锁等它返回就是互等 (这次停流不是上层发起的，回调无从回避)。设备已经不在，不会再有新帧进来
+    {
+        std::lock_guard<std::mutex> threadLock(m_streamThreadMutex);
+        m_grabRunning = false;
+        if (m_grabThread.joinable()) m_grabThread.join();
+        m_grabThreadId = std::thread::id();
+        m_dispatcher.stop();
+    }
+
+    // B. 记下断线前的状态，然后丢掉已经失效的句柄 (持锁：上层此刻调用的接口要么在前、要么在后，不会用到半关的句柄)
+    //    是否续流不在这里记：断线期间上层可能调用了 stopStream，以 m_streamRequested 的最新值为准
+    SensorRoi roi;
+    int binning = 1;
+    int decimation = 1;
+    float exposureUs = -1.0f;
+    float gainDb = -1.0f;
+    float frameRate = -1.0f;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+        roi = getRoi();
+        binning = m_binning;
+        decimation = m_decimation;
+        exposureUs = m_lastExposureUs;
+        gainDb = m_lastGainDb;
+        frameRate = m_lastFrameRate;
+        releaseHandle();
+    }
+
+    // C. 限时重试
+    while (std::chrono::steady_clock::now() - begin < kReconnectTimeout) {
+        {
+            std::unique_lock<std::mutex> lock(m_reconnectMutex);
+            if (m_reconnectCond.wait_for(lock, kReconnectInterval, [this] { return m_reconnectStop; })) return;
+            m_reconnectPending = false; // 重连期间 SDK 可能重复上报断线
+        }
+
+        {
+            // 每次尝试都持锁完成：替换句柄、恢复参数、续流，上层调用只会看到重连前或重连后的状态
+            std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+            HikCamera::invalidateDeviceCache(); // 设备重新上电后的枚举信息与之前不同
+            m_binning = 1;                      // 重新上电的设备回到缺省读出方式
+            m_decimation = 1;
+            if (openDevice(m_serialNumber) != CameraStatus::SUCCESS) continue;
+
+            // D. 恢复断线前的状态 (先合并/抽样，ROI 的步进依赖它们)
+            setBinning(binning);
+            setDecimation(decimation);
+            if (roi.width > 0) setRoi(roi);
+            if (exposureUs >= 0.0f) setExposureTime(exposureUs);
+            if (gainDb >= 0.0f) setGain(gainDb);
+            if (frameRate >= 0.0f) setFrameRate(frameRate);
+
+            if (m_streamRequested && startStream() != CameraStatus::SUCCESS) {
+                releaseHandle();
+                continue;
+            }
+        }
+
+        std::cerr << "[HikCamera] 设备 " << m_serialNumber << " 已重连，中断 " << outageMs() << " ms" << std::endl;
+        notifyDeviceEvent(DeviceEvent::RECONNECTED, outageMs());
+        return;
+    }
+
+    std::cerr << "[HikCamera] 设备 " << m_serialNumber << " 重连超时，放弃" << std::endl;
+    notifyDeviceEvent(DeviceEvent::RECONNECT_FAILED, outageMs());
 }
 
 // ====================================================
-// 4. 核心图像转码引擎 (带锁与动态内存池)
+// 4. 核心图像转码引擎 (带锁与帧缓冲池)
 // ====================================================
+// 海康像素格式 -> 业务层统一像素格式
+static PixelFormat toPixelFormat(MvGvspPixelType enPixelType) {
+    switch (enPixelType) {
+    case PixelType_Gvsp_Mono8:        return PixelFormat::MONO8;
+    case PixelType_Gvsp_RGB8_Packed:  return PixelFormat::RGB8;
+    case PixelType_Gvsp_BGR8_Packed:  return PixelFormat::BGR8;
+    case PixelType_Gvsp_BayerRG8:     return PixelFormat::BAYER_RG8;
+    case PixelType_Gvsp_BayerGB8:     return PixelFormat::BAYER_GB8;
+    case PixelType_Gvsp_BayerGR8:     return PixelFormat::BAYER_GR8;
+    case PixelType_Gvsp_BayerBG8:     return PixelFormat::BAYER_BG8;
+    default:                          return PixelFormat::UNKNOWN;
+    }
+}
+
+// 业务层统一像素格式 -> 海康像素格式
+static MvGvspPixelType toHikPixelType(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::MONO8:      return PixelType_Gvsp_Mono8;
+    case PixelFormat::RGB8:       return PixelType_Gvsp_RGB8_Packed;
+    case PixelFormat::BGR8:       return PixelType_Gvsp_BGR8_Packed;
+    case PixelFormat::BAYER_RG8:  return PixelType_Gvsp_BayerRG8;
+    case PixelFormat::BAYER_GB8:  return PixelType_Gvsp_BayerGB8;
+    case PixelFormat::BAYER_GR8:  return PixelType_Gvsp_BayerGR8;
+    case PixelFormat::BAYER_BG8:  return PixelType_Gvsp_BayerBG8;
+    default:                      return PixelType_Gvsp_Undefined;
+    }
+}
+
+// 本帧最终要交付的格式：未指定时按传感器原始格式交付，由消费者通过 Frame::toFormat() 按需转换；
+// 只有业务层不认识的传感器格式 (如 10/12 位、YUV) 才在这里统一转为 RGB8
+static PixelFormat resolveOutputFormat(PixelFormat requested, PixelFormat sensor) {
+    if (requested != PixelFormat::UNKNOWN) return requested;
+    return (sensor != PixelFormat::UNKNOWN) ? sensor : PixelFormat::RGB8;
+}
+
+CameraStatus HikCamera::negotiatePixelFormat() {
+    if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+
+    MVCC_ENUMVALUE stFormat;
+    memset(&stFormat, 0, sizeof(MVCC_ENUMVALUE));
+    if (m_sdk->getEnumValue(m_handle, "PixelFormat", &stFormat) != MV_OK) {
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+    m_sensorFormat = toPixelFormat(static_cast<MvGvspPixelType>(stFormat.nCurValue));
+
+    PixelFormat requested = m_outputFormat;
+    if (requested == PixelFormat::UNKNOWN) return CameraStatus::SUCCESS;
+
+    // A. 首选：让传感器直接输出目标格式，主机端零转换
+    unsigned int target = static_cast<unsigned int>(toHikPixelType(requested));
+    bool supported = false;
+    for (unsigned int i = 0; i < stFormat.nSupportedNum && i < MV_MAX_XML_SYMBOLIC_NUM; i++) {
+        if (stFormat.nSupportValue[i] == target) {
+            supported = true;
+            break;
+        }
+    }
+    if (supported && (stFormat.nCurValue == target || m_sdk->setEnumValue(m_handle, "PixelFormat", target) == MV_OK)) {
+        m_sensorFormat = requested;
+        std::cout << "[HikCamera] 像素格式协商: 传感器直出 " << static_cast<int>(requested) << "，主机零转换" << std::endl;
+        return CameraStatus::SUCCESS;
+    }
+
+    // B. 传感器做不到：Bayer 原始数据无法由主机“反向”合成，只能报错
+    if (isBayerFormat(requested)) {
+        std::cerr << "[HikCamera] 像素格式协商失败: 传感器不支持请求的 Bayer 格式" << std::endl;
+        return CameraStatus::PARAM_SET_FAILED;
+    }
+
+    // C. 回退：保持传感器现有格式，每帧在主机端转换
+    std::cout << "[HikCamera] 像素格式协商: 传感器不支持 " << static_cast<int>(requested)
+        << "，回退为主机转换 (源格式 " << static_cast<int>(m_sensorFormat.load()) << ")" << std::endl;
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus HikCamera::setOutputFormat(PixelFormat format) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    PixelFormat previous = m_outputFormat;
+    m_outputFormat = format;
+
+    if (m_handle == nullptr) { // 先记下，openDevice 时协商
+        m_convertedFrames = 0;
+        m_convertTotalUs = 0;
+        m_lastConvertUs = 0;
+        return CameraStatus::SUCCESS;
+    }
+
+    // PixelFormat 节点只允许在停止取流时修改：短暂停流，不需要重新打开设备
+    // 停不下来 (如在帧回调里调用) 就保持原格式，不去协商
+    bool wasStreaming = m_isStreaming;
+    if (wasStreaming) {
+        CameraStatus status = stopStreamLocked();
+        if (status != CameraStatus::SUCCESS) {
+            m_outputFormat = previous;
+            return status;
+        }
+    }
+
+    CameraStatus status = negotiatePixelFormat();
+    if (status == CameraStatus::SUCCESS && wasStreaming) status = startStream();
+
+    if (status != CameraStatus::SUCCESS) {
+        // 失败时回到调用前的格式，否则转换线程会按一个协商失败的格式 (如 Bayer) 丢掉之后的每一帧
+        m_outputFormat = previous;
+        negotiatePixelFormat();
+        if (wasStreaming && !m_isStreaming) startStream();
+        return status;
+    }
+
+    m_convertedFrames = 0;
+    m_convertTotalUs = 0;
+    m_lastConvertUs = 0;
+    return status;
+}
+
+CameraStatus HikCamera::setHostDemosaic(bool inHouse, DemosaicQuality quality) {
+    // 两个原子量分别生效即可：回调线程最多有一帧用到“旧引擎 + 新质量”，不影响正确性
+    m_demosaicQuality = quality;
+    m_inHouseDemosaic = inHouse;
+    m_convertedFrames = 0;
+    m_convertTotalUs = 0;
+    return CameraStatus::SUCCESS;
+}
+
+PixelFormat HikCamera::getOutputFormat() const {
+    return m_outputFormat;
+}
+
+FormatNegotiation HikCamera::getFormatNegotiation() const {
+    FormatNegotiation result;
+    result.requested = m_outputFormat;
+    result.sensor = m_sensorFormat;
+    result.nativeOutput = m_nativeOutput;
+    result.convertedFrames = m_convertedFrames;
+    result.inHouseDemosaic = m_inHouseDemosaic;
+    result.lastConvertMs = m_lastConvertUs / 1000.0;
+    if (result.convertedFrames > 0) {
+        result.avgConvertMs = static_cast<double>(m_convertTotalUs) / result.convertedFrames / 1000.0;
+    }
+    return result;
+}
+
 void HikCamera::processAndTrigger(unsigned char* pData, void* pInfo) {
-    MV_FRAME_OUT_INFO_EX* pFrameInfo = static_cast<MV_FRAME_OUT_INFO_EX*>(pInfo);
+    // 第一时间打点：这是整条链路端到端延迟的起点
+    auto hostArrival = std::chrono::steady_clock::now();
 
-    // 互斥锁：防止多线程导致画面撕裂
-    std::lock_guard<std::mutex> lock(m_mutex);
+    MV_FRAME_OUT_INFO_EX* pFrameInfo = static_cast<MV_FRAME_OUT_INFO_EX*>(pInfo);
 
-    if (pFrameInfo->enPixelType == PixelType_Gvsp_Mono8) {
-        cv::Mat monoMat(pFrameInfo->nHeight, pFrameInfo->nWidth, CV_8UC1, pData);
-        triggerCallback(monoMat.clone());
+    // 残帧 (传输丢包) 上层反正要丢：在这里就地丢弃，不占池化缓冲、不拷贝、不排队转换
+    if (pFrameInfo->nLostPacket > 0) {
+        m_incompleteDropped++;
         return;
     }
 
-    // 动态维护复用缓存池
-    unsigned int requiredSize = pFrameInfo->nWidth * pFrameInfo->nHeight * 3;
-    if (m_convertBuf.size() < requiredSize) {
-        m_convertBuf.resize(requiredSize);
+    // 把 SDK 帧信息原样搬进 Frame，不再丢弃
+    FrameJob job;
+    Frame& frame = job.frame;
+    frame.sensorFormat = toPixelFormat(pFrameInfo->enPixelType);
+    frame.pixelFormat = frame.sensorFormat;
+    frame.frameNumber = pFrameInfo->nFrameNum;
+    frame.deviceTimestamp = (static_cast<uint64_t>(pFrameInfo->nDevTimeStampHigh) << 32) | pFrameInfo->nDevTimeStampLow;
+    frame.lostPackets = pFrameInfo->nLostPacket;
+    frame.triggerId = pFrameInfo->nTriggerIndex;
+    frame.pixelStep = m_binning * m_decimation;
+    frame.sensorRect = cv::Rect(m_roiOffsetX, m_roiOffsetY, pFrameInfo->nWidth * frame.pixelStep, pFrameInfo->nHeight * frame.pixelStep);
+    frame.hostArrival = hostArrival;
+    m_clock.correlate(frame); // 回调按帧序串行到达，正好给时钟拟合喂样本
+    job.nativeType = static_cast<uint32_t>(pFrameInfo->enPixelType);
+    job.width = pFrameInfo->nWidth;
+    job.height = pFrameInfo->nHeight;
+
+    m_sensorFormat = frame.sensorFormat;
+
+    // 采集线程上只做这一次省不掉的拷贝 (SDK 的缓冲在回调返回后就会被回收)，转换全部交给转换线程
+    if (frame.sensorFormat != PixelFormat::UNKNOWN) {
+        cv::Mat raw = m_framePool.acquire(pFrameInfo->nHeight, pFrameInfo->nWidth, cvTypeOf(frame.sensorFormat));
+        cv::Mat(pFrameInfo->nHeight, pFrameInfo->nWidth, raw.type(), pData).copyTo(raw);
+        frame.setImage(raw);
+    }
+    else {
+        // 业务层不认识的格式 (10/12 位、YUV 等)：按字节原样保存，稍后交给海康 ISP 解读
+        cv::Mat raw = m_framePool.acquire(1, static_cast<int>(pFrameInfo->nFrameLen), CV_8UC1);
+        memcpy(raw.data, pData, pFrameInfo->nFrameLen);
+        frame.setImage(raw);
     }
 
-    // 调用海康官方 ISP 无损还原真彩色
-    MV_CC_PIXEL_CONVERT_PARAM stConvertParam = { 0 };
-    stConvertParam.nWidth = pFrameInfo->nWidth;
-    stConvertParam.nHeight = pFrameInfo->nHeight;
-    stConvertParam.pSrcData = pData;
-    stConvertParam.nSrcDataLen = pFrameInfo->nFrameLen;
-    stConvertParam.enSrcPixelType = pFrameInfo->enPixelType;
-    stConvertParam.enDstPixelType = PixelType_Gvsp_RGB8_Packed;
-    stConvertParam.pDstBuffer = m_convertBuf.data();
-    stConvertParam.nDstBufferSize = m_convertBuf.size();
+    // 队列满时挤掉最旧的积压帧 (计入 DispatchStats::dropped)，绝不阻塞采集线程
+    m_dispatcher.post(std::move(job));
+}
 
-    if (MV_CC_ConvertPixelType(m_handle, &stConvertParam) == MV_OK) {
-        cv::Mat rgbMat(pFrameInfo->nHeight, pFrameInfo->nWidth, CV_8UC3, m_convertBuf.data());
-        triggerCallback(rgbMat.clone()); // 深拷贝发送，保命机制
+bool HikCamera::convertFrame(FrameJob& job) {
+    Frame& frame = job.frame;
+    PixelFormat target = resolveOutputFormat(m_outputFormat, frame.sensorFormat);
+
+    if (target == frame.sensorFormat) {
+        // A. 传感器直出：原始帧本身就是要发出去的帧，零转换
+        m_nativeOutput = true;
+        return true;
+    }
+
+    // B. 主机转换：Bayer 原始数据无法由其它格式合成 (协商阶段已拦截，这里兜底)
+    if (isBayerFormat(target)) return false;
+
+    auto convertBegin = std::chrono::steady_clock::now();
+
+    // 结果写进池化缓冲，发出去的就是这块内存，无需再 clone
+    cv::Mat output = m_framePool.acquire(job.height, job.width, cvTypeOf(target));
+
+    if (m_inHouseDemosaic && isBayerFormat(frame.sensorFormat)) {
+        // B1. 自研多线程 SIMD 引擎
+        DemosaicOutput demosaicOutput = (target == PixelFormat::MONO8) ? DemosaicOutput::GRAY :
+            (target == PixelFormat::BGR8 ? DemosaicOutput::BGR : DemosaicOutput::RGB);
+        if (!BayerDemosaic::convert(frame.image(), output, bayerPatternOf(frame.sensorFormat), demosaicOutput, m_demosaicQuality)) return false;
+    }
+    else {
+        // B2. 调用海康官方 ISP 无损还原
+        MV_CC_PIXEL_CONVERT_PARAM stConvertParam = { 0 };
+        stConvertParam.nWidth = static_cast<unsigned short>(job.width);
+        stConvertParam.nHeight = static_cast<unsigned short>(job.height);
+        stConvertParam.pSrcData = frame.image().data;
+        stConvertParam.nSrcDataLen = static_cast<unsigned int>(frame.image().total() * frame.image().elemSize());
+        stConvertParam.enSrcPixelType = static_cast<MvGvspPixelType>(job.nativeType);
+        stConvertParam.enDstPixelType = toHikPixelType(target);
+        stConvertParam.pDstBuffer = output.data;
+        stConvertParam.nDstBufferSize = static_cast<unsigned int>(output.total() * output.elemSize());
+
+        // 同一句柄上的 SDK 转换调用不保证可重入，只在这一次调用上排队 (自研引擎路径完全并行)
+        std::lock_guard<std::mutex> lock(m_convertMutex);
+        if (m_sdk->convertPixelType(m_handle, &stConvertParam) != MV_OK) return false;
     }
+
+    auto costUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - convertBegin).count();
+    m_lastConvertUs = static_cast<uint64_t>(costUs);
+    m_convertTotalUs += static_cast<uint64_t>(costUs);
+    m_convertedFrames++;
+    m_nativeOutput = false;
+
+    // 换上转换结果，原始帧的池化缓冲随之归还
+    frame.setImage(output);
+    frame.pixelFormat = target;
+    return true;
 }
 
 // ====================================================
@@ -170,11 +1113,14 @@ void HikCamera::processAndTrigger(unsigned char* pData, void* pInfo) {
 // ====================================================
 
 CameraStatus HikCamera::setExposureTime(float timeUs) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
     if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
 
     // 调用海康 SDK 写入曝光时间
-    int nRet = MV_CC_SetFloatValue(m_handle, "ExposureTime", timeUs);
+    int nRet = m_sdk->setFloatValue(m_handle, "ExposureTime", timeUs);
     if (nRet == MV_OK) {
+        m_lastExposureUs = timeUs;
+        refreshFloatParam("ExposureTime", &CameraParams::exposureTime);
         return CameraStatus::SUCCESS;
     }
     std::cerr << "[HikCamera] 设置曝光时间失败! 错误码: " << std::hex << nRet << std::endl;
@@ -182,22 +1128,18 @@ CameraStatus HikCamera::setExposureTime(float timeUs) {
 }
 
 float HikCamera::getExposureTime() {
-    if (m_handle == nullptr) return 0.0f;
-
-    MVCC_FLOATVALUE stParam = { 0 };
-    int nRet = MV_CC_GetFloatValue(m_handle, "ExposureTime", &stParam);
-    if (nRet == MV_OK) {
-        return stParam.fCurValue;
-    }
-    return 0.0f;
+    return static_cast<float>(getParams().exposureTime.current);
 }
 
 CameraStatus HikCamera::setGain(float gain) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
     if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
 
     // 调用海康 SDK 写入增益
-    int nRet = MV_CC_SetFloatValue(m_handle, "Gain", gain);
+    int nRet = m_sdk->setFloatValue(m_handle, "Gain", gain);
     if (nRet == MV_OK) {
+        m_lastGainDb = gain;
+        refreshFloatParam("Gain", &CameraParams::gain);
         return CameraStatus::SUCCESS;
     }
     std::cerr << "[HikCamera] 设置增益失败! 错误码: " << std::hex << nRet << std::endl;
@@ -205,28 +1147,130 @@ CameraStatus HikCamera::setGain(float gain) {
 }
 
 float HikCamera::getGain() {
-    if (m_handle == nullptr) return 0.0f;
+    return static_cast<float>(getParams().gain.current);
+}
 
-    MVCC_FLOATVALUE stParam = { 0 };
-    int nRet = MV_CC_GetFloatValue(m_handle, "Gain", &stParam);
+float HikCamera::getMaxGain() {
+    ParamRange gain = getParams().gain;
+    return gain.available ? static_cast<float>(gain.max) : 12.0f; // 如果获取失败，给个保守的保底值
+}
+
+CameraStatus HikCamera::setFrameRate(double fps) {
+    std::lock_guard<std::recursive_mutex> lock(m_handleMutex);
+    if (m_handle == nullptr) return CameraStatus::OPEN_FAILED;
+
+    // 帧率节点只在 AcquisitionFrameRateEnable 打开时生效；关闭即不限帧率
+    int nRet = m_sdk->setBoolValue(m_handle, "AcquisitionFrameRateEnable", fps > 0.0);
+    if (nRet == MV_OK && fps > 0.0) nRet = m_sdk->setFloatValue(m_handle, "AcquisitionFrameRate", static_cast<float>(fps));
     if (nRet == MV_OK) {
-        return stParam.fCurValue;
+        m_lastFrameRate = static_cast<float>(std::max(fps, 0.0));
+        refreshFloatParam("AcquisitionFrameRate", &CameraParams::frameRate);
+        return CameraStatus::SUCCESS;
     }
-    return 0.0f;
+    std::cerr << "[HikCamera] 设置采集帧率失败! 错误码: " << std::hex << nRet << std::endl;
+    return CameraStatus::PARAM_SET_FAILED;
 }
 
-float HikCamera::getMaxGain() {
-    if (m_handle == nullptr) return 0.0f;
+// ====================================================
+// 5.1 参数快照：每个节点都是一次 USB 往返，批量读一遍后缓存
+// ====================================================
+static ParamRange toParamRange(const MVCC_FLOATVALUE& value) {
+    ParamRange range;
+    range.current = value.fCurValue;
+    range.min = value.fMin;
+    range.max = value.fMax;
+    range.available = true;
+    return range;
+}
+
+static ParamRange toParamRange(const MVCC_INTVALUE_EX& value) {
+    ParamRange range;
+    range.current = static_cast<double>(value.nCurValue);
+    range.min = static_cast<double>(value.nMin);
+    range.max = static_cast<double>(value.nMax);
+    range.increment = static_cast<double>(value.nInc);
+    range.available = true;
+    return range;
+}
+
+CameraParams HikCamera::getParams() {
+    std::lock_guard<std::recursive_mutex> handleLock(m_handleMutex); // 先句柄后快照，与写参数的路径同一顺序
+    std::lock_guard<std::mutex> lock(m_paramsMutex);
+    if (m_paramsValid || m_handle == nullptr) return m_params;
+
+    CameraParams params;
+    params.revision = m_params.revision + 1;
+
+    MVCC_FLOATVALUE stFloat = { 0 };
+    if (m_sdk->getFloatValue(m_handle, "ExposureTime", &stFloat) == MV_OK) params.exposureTime = toParamRange(stFloat);
+    if (m_sdk->getFloatValue(m_handle, "Gain", &stFloat) == MV_OK) params.gain = toParamRange(stFloat);
+    if (m_sdk->getFloatValue(m_handle, "AcquisitionFrameRate", &stFloat) == MV_OK) params.frameRate = toParamRange(stFloat);
+
+    MVCC_INTVALUE_EX stInt = { 0 };
+    if (m_sdk->getIntValueEx(m_handle, "Width", &stInt) == MV_OK) params.width = toParamRange(stInt);
+    if (m_sdk->getIntValueEx(m_handle, "Height", &stInt) == MV_OK) params.height = toParamRange(stInt);
+
+    // 没被写过的参数以首次读到的值为准，断线重连后按它恢复
+    if (m_lastExposureUs < 0.0f && params.exposureTime.available) m_lastExposureUs = static_cast<float>(params.exposureTime.current);
+    if (m_lastGainDb < 0.0f && params.gain.available) m_lastGainDb = static_cast<float>(params.gain.current);
+
+    m_params = params;
+    m_paramsValid = true;
+    return m_params;
+}
+
+void HikCamera::invalidateParams() {
+    std::lock_guard<std::mutex> lock(m_paramsMutex);
+    m_paramsValid = false;
+}
+
+void HikCamera::refreshFloatParam(const char* key, ParamRange CameraParams::* field) {
+    std::lock_guard<std::mutex> lock(m_paramsMutex);
+    if (!m_paramsValid) return; // 整份快照都要重读，等下次 getParams()
 
     MVCC_FLOATVALUE stParam = { 0 };
-    int nRet = MV_CC_GetFloatValue(m_handle, "Gain", &stParam);
-    if (nRet == MV_OK) {
-        return stParam.fMax; // 拿取底层结构体里的最大值！
+    if (m_sdk->getFloatValue(m_handle, key, &stParam) == MV_OK) {
+        m_params.*field = toParamRange(stParam);
+        m_params.revision++;
+    }
+    else {
+        m_paramsValid = false;
     }
-    return 12.0f; // 如果获取失败，给个保守的保底值
 }
 
-// 纯异步架构下，同步抓图已被废弃，保留空实现以满足接口契约
+FramePoolStats HikCamera::getFramePoolStats() const {
+    return m_framePool.getStats();
+}
+
+DispatchStats HikCamera::getDispatchStats() const {
+    DispatchStats stats = m_dispatcher.getStats();
+    stats.incomplete = m_incompleteDropped;
+    return stats;
+}
+
+ClockCorrelationStats HikCamera::getClockStats() const {
+    return m_clock.getStats();
+}
+
+// 同步抓图：等待调用之后到达的下一帧 (两种取图模式下都可用，拉取模式下不占用 SDK 回调线程)
 bool HikCamera::grabFrame(cv::Mat& outFrame, int timeoutMs) {
-    return false;
+    Frame frame;
+    if (!grabFrame(frame, timeoutMs)) return false;
+    // 老接口的调用方不认识 Bayer，这里保持“黑白或 RGB”的约定
+    outFrame = frame.toFormat(displayFormatOf(frame.pixelFormat));
+    return true;
+}
+
+bool HikCamera::grabFrame(Frame& outFrame, int timeoutMs) {
+    if (!m_isStreaming) return false;
+
+    std::unique_lock<std::mutex> lock(m_latestMutex);
+    uint64_t seenSeq = m_latestSeq;
+    bool arrived = m_latestCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        return m_latestSeq != seenSeq || !m_isStreaming;
+        });
+    if (!arrived || m_latestSeq == seenSeq) return false;
+
+    outFrame = m_latestFrame;
+    return true;
 }
\ No newline at end of file
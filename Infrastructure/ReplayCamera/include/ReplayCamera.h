@@ -0,0 +1,124 @@
+﻿// Infrastructure/ReplayCamera/include/ReplayCamera.h
+#pragma once
+
+#include "ICamera.h" // 纯 C++ 契约
+#include "FrameBufferPool.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+// 回放节拍
+enum class ReplayTiming {
+    ORIGINAL,            // 按录制时的帧间隔回放，复现现场节奏
+    AS_FAST_AS_POSSIBLE  // 不等待，测量整条流水线的最大吞吐
+};
+
+// =========================================================
+// 回放配置
+// =========================================================
+struct ReplayConfig {
+    std::string source;                        // 图片目录 (JPEG/PNG/BMP) 或 .ocvraw 原始录像文件
+    ReplayTiming timing = ReplayTiming::ORIGINAL;
+    bool loop = false;                         // 播完后从头再来
+    double fallbackFrameRate = 30.0;           // 图片文件名里没有时间戳时使用的帧率
+    unsigned int decodeThreads = 0;            // 预取解码线程数，0 表示按 CPU 核数自动选择
+    size_t prefetchDepth = 8;                  // 最多提前解码多少帧
+};
+
+// 回放统计：判断瓶颈在解码还是在下游
+struct ReplayStats {
+    size_t totalFrames = 0;     // 源中的帧数
+    uint64_t played = 0;        // 已交付的帧数
+    uint64_t decodeFailed = 0;  // 解码失败被跳过的帧数
+    uint64_t decoderStalls = 0; // 播放线程因预取不足而等待解码的次数 (持续增长说明解码是瓶颈)
+    double stallMs = 0.0;       // 上述等待的累计时长
+    bool finished = false;      // 非循环模式下已播完
+};
+
+// =========================================================
+// ReplayCamera：把录制好的现场数据原样灌进真实的 CameraService 与 UI
+// 作用：复现现场问题；AS_FAST_AS_POSSIBLE 模式下测量整条流水线的最大吞吐。
+//
+// 结构：多个解码线程按帧号顺序领取任务、并行解码，结果放进按帧号排序的预取窗口；
+// 播放线程按顺序取出，按原始节拍 (或不等待) 交给上层回调。
+// 回调直接运行在播放线程上：下游处理不过来时回放自然放慢，而不是丢帧，
+// 这样测出来的吞吐才是流水线真实的处理能力。
+// =========================================================
+class ReplayCamera : public ICamera {
+public:
+    explicit ReplayCamera(const ReplayConfig& config);
+    ~ReplayCamera() override;
+
+    // ---------------------------------------------------------
+    // 强制实现 ICamera 的纯虚函数
+    // ---------------------------------------------------------
+    std::vector<CameraInfo> enumDevices() override;
+    CameraStatus openDevice(const std::string& serialNumber = "") override;
+    CameraStatus closeDevice() override;
+
+    void registerFrameCallback(FrameCallback callback) override;
+    CameraStatus startStream() override;
+    CameraStatus stopStream() override;
+
+    // 录像里的曝光与增益已经固定，无法修改
+    CameraStatus setExposureTime(float timeUs) override;
+    float getExposureTime() override;
+    CameraStatus setGain(float gain) override;
+    float getGain() override;
+    float getMaxGain() override;
+
+    bool grabFrame(cv::Mat& outFrame, int timeoutMs = 1000) override;
+    bool grabFrame(Frame& outFrame, int timeoutMs = 1000) override;
+
+    FramePoolStats getFramePoolStats() const override;
+
+    // ---------------------------------------------------------
+    // 回放专属接口
+    // ---------------------------------------------------------
+    // 取流中也可切换节拍
+    void setTiming(ReplayTiming timing);
+    ReplayTiming getTiming() const;
+
+    ReplayStats getReplayStats() const;
+
+    // 帧源的统一抽象：图片目录 / 原始录像 (定义见 ReplayCamera.cpp)
+    class Source;
+
+private:
+    void decodeLoop();
+    void playLoop();
+    void publishLatest(const Frame& frame);
+    // 让解码与播放线程退出并回收
+    void stopThreads();
+
+private:
+    ReplayConfig m_config;
+    std::unique_ptr<Source> m_source;
+    std::atomic<bool> m_isStreaming;
+    FrameCallback m_callback;
+    std::atomic<ReplayTiming> m_timing;
+
+    FrameBufferPool m_framePool;
+
+    // 预取窗口：帧序号 -> 已解码的帧 (解码失败的帧以空 Frame 占位，保证播放线程不会卡住)
+    mutable std::mutex m_mutex;
+    std::condition_variable m_decodedCond;   // 有新帧解码完成
+    std::condition_variable m_spaceCond;     // 预取窗口有空位
+    std::map<uint64_t, Frame> m_ready;
+    uint64_t m_nextToDecode;                 // 下一个待领取的解码序号 (循环模式下会超过帧数)
+    uint64_t m_nextToPlay;                   // 下一个待播放的序号
+    bool m_running;
+
+    std::vector<std::thread> m_decoders;
+    std::thread m_player;
+    ReplayStats m_stats;
+
+    // 最新帧信箱 (grabFrame 同步等待用)
+    std::mutex m_latestMutex;
+    std::condition_variable m_latestCond;
+    Frame m_latestFrame;
+    uint64_t m_latestSeq;
+};
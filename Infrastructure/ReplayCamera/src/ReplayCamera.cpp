@@ -0,0 +1,449 @@
+﻿#include "ReplayCamera.h"
+#include "RawRecording.h"
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+// 预取窗口之外，同时在下游路上的帧 (UI 队列 + 存图 + 算法) 一般不超过这个数
+static constexpr size_t kInFlightFrames = 8;
+
+// ====================================================
+// 1. 帧源抽象
+// ====================================================
+class ReplayCamera::Source {
+public:
+    virtual ~Source() = default;
+    virtual size_t frameCount() const = 0;
+    // 第 index 帧相对第一帧的时刻
+    virtual std::chrono::nanoseconds timestampOf(size_t index) const = 0;
+    // 解码第 index 帧 (会被多个预取线程同时调用)
+    virtual bool decode(size_t index, Frame& out, FrameBufferPool& pool) = 0;
+};
+
+namespace {
+    // 1970-01-01 起的天数 (公历)，用于把文件名里的日期换算成时间轴
+    int64_t daysFromCivil(int year, int month, int day) {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const int64_t yoe = year - era * 400;
+        const int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    // 解析 CameraView::saveFrameToFile 的文件名 IMG_yyyyMMdd_HHmmss_zzz，返回毫秒时间戳
+    bool parseCaptureTime(const std::string& stem, int64_t& ms) {
+        // 0123456789012345678901234
+        // IMG_20240101_120000_123
+        if (stem.size() != 23 || stem.compare(0, 4, "IMG_") != 0 || stem[12] != '_' || stem[19] != '_') return false;
+        for (size_t i : { 4, 5, 6, 7, 8, 9, 10, 11, 13, 14, 15, 16, 17, 18, 20, 21, 22 }) {
+            if (!std::isdigit(static_cast<unsigned char>(stem[i]))) return false;
+        }
+        auto num = [&](size_t pos, size_t len) { return std::stoi(stem.substr(pos, len)); };
+        int64_t days = daysFromCivil(num(4, 4), num(8, 2), num(10, 2));
+        ms = ((days * 24 + num(13, 2)) * 60 + num(15, 2)) * 60000 + num(17, 2) * 1000 + num(20, 3);
+        return true;
+    }
+
+    // ------------------------------------------------
+    // A. 图片目录：按文件名排序 (时间戳文件名即时间顺序)
+    // ------------------------------------------------
+    class ImageDirectorySource : public ReplayCamera::Source {
+    public:
+        ImageDirectorySource(const fs::path& dir, double fallbackFps) {
+            for (const auto& item : fs::directory_iterator(dir)) {
+                if (!item.is_regular_file()) continue;
+                std::string ext = item.path().extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+                    m_files.push_back(item.path());
+                }
+            }
+            std::sort(m_files.begin(), m_files.end());
+
+            // 所有文件名都带拍摄时间时按真实间隔回放，否则按固定帧率
+            std::vector<int64_t> captureMs(m_files.size());
+            bool allParsed = !m_files.empty();
+            for (size_t i = 0; i < m_files.size() && allParsed; i++) {
+                allParsed = parseCaptureTime(m_files[i].stem().string(), captureMs[i]);
+            }
+
+            const double period = 1.0 / (fallbackFps > 0.0 ? fallbackFps : 30.0);
+            m_timestamps.resize(m_files.size());
+            for (size_t i = 0; i < m_files.size(); i++) {
+                m_timestamps[i] = allParsed ?
+                    std::chrono::milliseconds(captureMs[i] - captureMs[0]) :
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(period * i));
+            }
+        }
+
+        size_t frameCount() const override { return m_files.size(); }
+        std::chrono::nanoseconds timestampOf(size_t index) const override { return m_timestamps[index]; }
+
+        bool decode(size_t index, Frame& out, FrameBufferPool& pool) override {
+            cv::Mat decoded = cv::imread(m_files[index].string(), cv::IMREAD_UNCHANGED);
+            if (decoded.empty() || decoded.depth() != CV_8U) return false;
+
+            out = Frame{};
+            if (decoded.channels() == 1) {
+                out.setImage(decoded);
+                out.pixelFormat = PixelFormat::MONO8;
+            }
+            else {
+                // 存图时从 RGB 转成了 BGR，这里转回来 (在预取线程上完成，不占播放线程)
+                cv::Mat rgb = pool.acquire(decoded.rows, decoded.cols, CV_8UC3);
+                cv::cvtColor(decoded, rgb, decoded.channels() == 4 ? cv::COLOR_BGRA2RGB : cv::COLOR_BGR2RGB);
+                out.setImage(rgb);
+                out.pixelFormat = PixelFormat::RGB8;
+            }
+            out.sensorFormat = out.pixelFormat;
+            out.frameNumber = index + 1;
+            out.deviceTimestamp = static_cast<uint64_t>(m_timestamps[index].count());
+            return true;
+        }
+
+    private:
+        std::vector<fs::path> m_files;
+        std::vector<std::chrono::nanoseconds> m_timestamps;
+    };
+
+    // ------------------------------------------------
+    // B. 原始录像：帧号、设备时间戳、丢包数、到达间隔全部原样还原
+    // ------------------------------------------------
+    class RawRecordingSource : public ReplayCamera::Source {
+    public:
+        bool open(const std::string& path) { return m_reader.open(path); }
+
+        size_t frameCount() const override { return m_reader.frameCount(); }
+
+        std::chrono::nanoseconds timestampOf(size_t index) const override {
+            return std::chrono::nanoseconds(m_reader.entry(index).header.hostTimeNs - m_reader.entry(0).header.hostTimeNs);
+        }
+
+        bool decode(size_t index, Frame& out, FrameBufferPool& pool) override {
+            const RawFrameHeader& header = m_reader.entry(index).header;
+            cv::Mat image = pool.acquire(static_cast<int>(header.height), static_cast<int>(header.width),
+                cvTypeOf(static_cast<PixelFormat>(header.pixelFormat)));
+            return m_reader.read(index, out, image);
+        }
+
+    private:
+        RawRecordingReader m_reader;
+    };
+}
+
+// ====================================================
+// 2. 构造、析构与流控制
+// ====================================================
+ReplayCamera::ReplayCamera(const ReplayConfig& config)
+    : m_config(config),
+    m_isStreaming(false),
+    m_timing(config.timing),
+    m_framePool(std::max<size_t>(config.prefetchDepth, 1) + kInFlightFrames),
+    m_nextToDecode(0),
+    m_nextToPlay(0),
+    m_running(false),
+    m_latestSeq(0) {
+    if (m_config.prefetchDepth == 0) m_config.prefetchDepth = 1;
+}
+
+ReplayCamera::~ReplayCamera() {
+    closeDevice();
+}
+
+void ReplayCamera::registerFrameCallback(FrameCallback callback) {
+    m_callback = callback;
+}
+
+CameraStatus ReplayCamera::startStream() {
+    if (!m_source) return CameraStatus::OPEN_FAILED;
+    if (m_isStreaming) return CameraStatus::SUCCESS;
+
+    // 非循环回放自己播完时线程还没回收：先收掉再重新开始
+    stopThreads();
+
+    unsigned int decoders = m_config.decodeThreads;
+    if (decoders == 0) decoders = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 从上次停下的位置继续；非循环模式下已经播完则从头开始
+        if (m_stats.finished) {
+            m_nextToPlay = 0;
+            m_stats.finished = false;
+        }
+        m_ready.clear();
+        m_nextToDecode = m_nextToPlay;
+        m_running = true;
+    }
+
+    for (unsigned int i = 0; i < decoders; i++) {
+        m_decoders.emplace_back(&ReplayCamera::decodeLoop, this);
+    }
+    m_player = std::thread(&ReplayCamera::playLoop, this);
+    m_isStreaming = true;
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus ReplayCamera::stopStream() {
+    if (!m_source) return CameraStatus::OPEN_FAILED;
+    stopThreads();
+    m_isStreaming = false;
+    m_latestCond.notify_all(); // 让还在 grabFrame() 里等待的调用者立即返回
+    return CameraStatus::SUCCESS;
+}
+
+void ReplayCamera::stopThreads() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_decodedCond.notify_all();
+    m_spaceCond.notify_all();
+
+    if (m_player.joinable()) m_player.join();
+    for (auto& decoder : m_decoders) {
+        if (decoder.joinable()) decoder.join();
+    }
+    m_decoders.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ready.clear(); // 预取的帧随之归还缓冲池
+}
+
+void ReplayCamera::publishLatest(const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_latestMutex);
+        m_latestFrame = frame; // 仅增加引用计数
+        m_latestSeq++;
+    }
+    m_latestCond.notify_all();
+}
+
+// ====================================================
+// 3. 设备发现与生命周期 (“设备”即回放源)
+// ====================================================
+std::vector<CameraInfo> ReplayCamera::enumDevices() {
+    CameraInfo info;
+    info.serialNumber = m_config.source;
+    info.modelName = "ReplayCamera";
+    return { info };
+}
+
+CameraStatus ReplayCamera::openDevice(const std::string& serialNumber) {
+    if (m_source) return CameraStatus::SUCCESS;
+    // 序列号即回放源路径：非空时覆盖配置里的路径
+    if (!serialNumber.empty()) m_config.source = serialNumber;
+
+    std::error_code ec;
+    fs::path path(m_config.source);
+    if (fs::is_directory(path, ec)) {
+        m_source = std::make_unique<ImageDirectorySource>(path, m_config.fallbackFrameRate);
+    }
+    else if (RawRecordingReader::isRawRecording(m_config.source)) {
+        auto raw = std::make_unique<RawRecordingSource>();
+        if (raw->open(m_config.source)) m_source = std::move(raw);
+    }
+
+    if (!m_source || m_source->frameCount() == 0) {
+        m_source.reset();
+        std::cerr << "[ReplayCamera] 回放源不存在或没有可用帧: " << m_config.source << std::endl;
+        return CameraStatus::DEVICE_NOT_FOUND;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats = ReplayStats{};
+        m_stats.totalFrames = m_source->frameCount();
+        m_nextToPlay = 0;
+    }
+    std::cout << "[ReplayCamera] 已打开回放源 " << m_config.source << "，共 " << m_source->frameCount() << " 帧" << std::endl;
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus ReplayCamera::closeDevice() {
+    if (!m_source) return CameraStatus::SUCCESS;
+    // 非循环回放播完后取流标志已复位，但播放与解码线程还没回收：不看标志，一律先收掉再释放数据源
+    stopStream();
+    m_source.reset();
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 4. 预取解码与播放
+// ====================================================
+void ReplayCamera::decodeLoop() {
+    const size_t count = m_source->frameCount();
+
+    while (true) {
+        uint64_t seq = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // 预取窗口已满，或非循环模式下所有帧都已领取：等待
+            m_spaceCond.wait(lock, [&] {
+                return !m_running || (m_nextToDecode - m_nextToPlay < m_config.prefetchDepth &&
+                    (m_config.loop || m_nextToDecode < count));
+                });
+            if (!m_running) return;
+            seq = m_nextToDecode++;
+        }
+
+        // 解码在锁外并行进行
+        Frame frame;
+        bool ok = m_source->decode(static_cast<size_t>(seq % count), frame, m_framePool);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!ok) {
+                frame = Frame{}; // 空帧占位：播放线程跳过它，而不是一直等下去
+                m_stats.decodeFailed++;
+            }
+            m_ready.emplace(seq, std::move(frame));
+        }
+        m_decodedCond.notify_all();
+    }
+}
+
+void ReplayCamera::playLoop() {
+    using Clock = std::chrono::steady_clock;
+    const size_t count = m_source->frameCount();
+
+    // 一轮的时长 = 最后一帧的时刻 + 一个平均帧间隔，循环播放时帧间隔保持均匀
+    const std::chrono::nanoseconds lastTs = m_source->timestampOf(count - 1);
+    const std::chrono::nanoseconds loopDuration = lastTs + (count > 1 ?
+        lastTs / static_cast<int64_t>(count - 1) :
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / m_config.fallbackFrameRate)));
+
+    // 原始节拍的锚点：切换到 ORIGINAL 或刚开始时，以“当前时刻 = 当前帧的录制时刻”重新对齐
+    bool anchored = false;
+    Clock::time_point anchorWall;
+    std::chrono::nanoseconds anchorMedia(0);
+
+    while (true) {
+        Frame frame;
+        uint64_t seq = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_config.loop && m_nextToPlay >= count) {
+                // 播完即停止取流：isStreaming 如实反映，再次 startStream() 从头播放
+                m_stats.finished = true;
+                m_isStreaming = false;
+                lock.unlock();
+                m_latestCond.notify_all(); // 让还在 grabFrame() 里等待的调用者立即返回
+                return;
+            }
+
+            seq = m_nextToPlay;
+            if (m_ready.find(seq) == m_ready.end()) {
+                // 预取没跟上：解码是瓶颈
+                auto waitBegin = Clock::now();
+                m_decodedCond.wait(lock, [&] { return !m_running || m_ready.find(seq) != m_ready.end(); });
+                if (!m_running) return; // 被停流唤醒，不算解码卡顿
+                m_stats.decoderStalls++;
+                m_stats.stallMs += std::chrono::duration<double, std::milli>(Clock::now() - waitBegin).count();
+            }
+            if (!m_running) return;
+
+            auto it = m_ready.find(seq);
+            frame = std::move(it->second);
+            m_ready.erase(it);
+            m_nextToPlay++;
+        }
+        m_spaceCond.notify_all();
+
+        if (frame.empty()) continue;
+
+        if (m_timing == ReplayTiming::ORIGINAL) {
+            std::chrono::nanoseconds media = loopDuration * static_cast<int64_t>(seq / count) + m_source->timestampOf(seq % count);
+            if (!anchored) {
+                anchorWall = Clock::now();
+                anchorMedia = media;
+                anchored = true;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_decodedCond.wait_until(lock, anchorWall + (media - anchorMedia), [this] { return !m_running; });
+            if (!m_running) return;
+        }
+        else {
+            anchored = false;
+        }
+
+        // 到达时刻按回放时重新打点，下游的延迟统计才有意义
+        frame.hostArrival = Clock::now();
+        publishLatest(frame);
+        if (m_callback) m_callback(frame);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.played++;
+    }
+}
+
+// ====================================================
+// 5. 参数与统计
+// ====================================================
+CameraStatus ReplayCamera::setExposureTime(float /*timeUs*/) {
+    return CameraStatus::PARAM_SET_FAILED;
+}
+
+float ReplayCamera::getExposureTime() {
+    return 0.0f;
+}
+
+CameraStatus ReplayCamera::setGain(float /*gain*/) {
+    return CameraStatus::PARAM_SET_FAILED;
+}
+
+float ReplayCamera::getGain() {
+    return 0.0f;
+}
+
+float ReplayCamera::getMaxGain() {
+    return 0.0f;
+}
+
+void ReplayCamera::setTiming(ReplayTiming timing) {
+    m_timing = timing;
+}
+
+ReplayTiming ReplayCamera::getTiming() const {
+    return m_timing;
+}
+
+ReplayStats ReplayCamera::getReplayStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+FramePoolStats ReplayCamera::getFramePoolStats() const {
+    return m_framePool.getStats();
+}
+
+// ====================================================
+// 6. 同步抓图：等待调用之后到达的下一帧
+// ====================================================
+bool ReplayCamera::grabFrame(cv::Mat& outFrame, int timeoutMs) {
+    Frame frame;
+    if (!grabFrame(frame, timeoutMs)) return false;
+    // 老接口的调用方不认识 Bayer，这里保持“黑白或 RGB”的约定
+    outFrame = frame.toFormat(displayFormatOf(frame.pixelFormat));
+    return true;
+}
+
+bool ReplayCamera::grabFrame(Frame& outFrame, int timeoutMs) {
+    if (!m_isStreaming) return false;
+
+    std::unique_lock<std::mutex> lock(m_latestMutex);
+    uint64_t seenSeq = m_latestSeq;
+    bool arrived = m_latestCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        return m_latestSeq != seenSeq || !m_isStreaming;
+        });
+    if (!arrived || m_latestSeq == seenSeq) return false;
+
+    outFrame = m_latestFrame;
+    return true;
+}
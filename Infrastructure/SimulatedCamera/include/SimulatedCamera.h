@@ -0,0 +1,177 @@
+﻿// Infrastructure/SimulatedCamera/include/SimulatedCamera.h
+#pragma once
+
+#include "ICamera.h" // 纯 C++ 契约
+#include "FrameBufferPool.h"
+#include "AsyncFrameDispatcher.h"
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+// =========================================================
+// 模拟相机配置
+// =========================================================
+struct SimulatedCameraConfig {
+    int width = 1280;
+    int height = 1024;
+    PixelFormat format = PixelFormat::BAYER_RG8;  // 模拟传感器的原始输出格式 (MONO8 / RGB8 / BGR8 / BAYER_xx8)
+    double frameRate = 30.0;                      // 帧率 (fps)
+    int ringCount = 6;                            // 同心圆环数量
+    int noiseAmplitude = 6;                       // 噪声幅度 (灰度级，0 关闭)
+    double blurSigma = 1.5;                       // 高斯模糊 (0 关闭)
+    std::string serialNumber = "SIM00001";
+    int deviceCount = 1;                          // 枚举出的虚拟设备数 (SIM00001, SIM00002 ...)，用于多相机联调
+};
+
+// =========================================================
+// SimulatedCamera：不依赖任何硬件与 SDK 的合成图像相机
+// 作用：在没有海康 SDK、没有 USB 相机的 Linux 构建机上跑基准测试与回归测试。
+//
+// 画面：缓慢移动的同心圆环 + 模糊 + 噪声；曝光与增益会线性改变亮度，
+//       可以用来测试自动曝光之类的控制回路。
+// 原理：整幅场景在开始取流时渲染一次 (比画面大一圈)，每帧只是裁出移动的窗口、
+//       乘以亮度系数、叠加一块随机偏移的预生成噪声，因此能跑到很高的帧率；
+//       帧间隔按 steady_clock 的绝对截止时刻排程，不会累积漂移。
+// =========================================================
+class SimulatedCamera : public ICamera {
+public:
+    explicit SimulatedCamera(const SimulatedCameraConfig& config = SimulatedCameraConfig());
+    ~SimulatedCamera() override;
+
+    // ---------------------------------------------------------
+    // 强制实现 ICamera 的纯虚函数
+    // ---------------------------------------------------------
+    std::vector<CameraInfo> enumDevices() override;
+    CameraStatus openDevice(const std::string& serialNumber = "") override;
+    CameraStatus closeDevice() override;
+
+    void registerFrameCallback(FrameCallback callback) override;
+    CameraStatus startStream() override;
+    CameraStatus stopStream() override;
+
+    CameraStatus setExposureTime(float timeUs) override;
+    float getExposureTime() override;
+
+    CameraStatus setGain(float gain) override;
+    float getGain() override;
+    float getMaxGain() override;
+    // 参数都在内存里，快照每次现拼，不需要缓存
+    CameraParams getParams() override;
+    // 修改帧率，取流中立即生效 (<= 0 恢复配置里的帧率)
+    CameraStatus setFrameRate(double fps) override;
+
+    bool grabFrame(cv::Mat& outFrame, int timeoutMs = 1000) override;
+    bool grabFrame(Frame& outFrame, int timeoutMs = 1000) override;
+
+    // 模拟传感器可以直出任意支持的格式，永远是“传感器直出、主机零转换”
+    CameraStatus setOutputFormat(PixelFormat format) override;
+    PixelFormat getOutputFormat() const override;
+    FormatNegotiation getFormatNegotiation() const override;
+    CameraStatus setHostDemosaic(bool inHouse, DemosaicQuality quality = DemosaicQuality::BILINEAR) override;
+
+    // 软触发与硬触发 (硬触发信号由 pulseLine() 模拟)
+    CameraStatus setTriggerMode(TriggerMode mode, int line = 0) override;
+    TriggerMode getTriggerMode() const override;
+    CameraStatus triggerSoftware() override;
+
+    // ROI、合并与抽样：模拟传感器任何时候都能直接改读出区域，取流中立即生效
+    CameraStatus setRoi(const SensorRoi& roi) override;
+    SensorRoi getRoi() const override;
+    SensorGeometry getSensorGeometry() const override;
+    CameraStatus setBinning(int factor) override;
+    int getBinning() const override;
+    CameraStatus setDecimation(int factor) override;
+    int getDecimation() const override;
+
+    // 断线事件由 simulateDisconnect() 产生
+    void registerDeviceEventCallback(DeviceEventCallback callback) override;
+    bool isConnected() const override;
+
+    FramePoolStats getFramePoolStats() const override;
+    DispatchStats getDispatchStats() const override;
+    ClockCorrelationStats getClockStats() const override;
+
+    // ---------------------------------------------------------
+    // 模拟相机专属配置
+    // ---------------------------------------------------------
+    // 当前的出图帧率
+    double getFrameRate() const;
+
+    // 因为处理不过来而被跳过的排程时刻数 (生成线程掉队时不补帧)
+    uint64_t getLateFrames() const;
+
+    // 模拟外部输入线上的一个触发脉冲：所有在该线上硬触发的模拟相机同时采一帧
+    static void pulseLine(int line);
+
+    // 模拟一次断线：outage 时长内不出图，随后自动“重连”并续流 (参数与 ROI 不丢)
+    // 断开与恢复都会通过设备事件回调上报，用来在没有硬件时演练上层的断线处理
+    void simulateDisconnect(std::chrono::milliseconds outage);
+
+private:
+    // 生成线程主循环：按绝对截止时刻排程
+    void generateLoop();
+    // 渲染整幅场景与噪声库 (开始取流时调用一次)
+    void renderScene();
+    // 裁出第 index 帧 (开始取流后 seconds 秒) 的画面中 roi 那一块，按合并/抽样缩小后写入池化缓冲
+    cv::Mat renderFrame(uint64_t index, double seconds, const SensorRoi& roi, int binning, int decimation);
+    // 把最新一帧挂到信箱里，唤醒 grabFrame() 的等待者
+    void publishLatest(const Frame& frame);
+    void triggerCallback(const Frame& frame);
+    // 记下一个待响应的触发，唤醒生成线程
+    void acceptTrigger();
+
+private:
+    SimulatedCameraConfig m_config;
+    bool m_isOpen;
+    std::atomic<bool> m_isStreaming;
+    std::mutex m_callbackMutex;
+    std::shared_ptr<const FrameCallback> m_callback; // 整体替换：转换线程上执行中的旧回调不受影响
+
+    // 传感器模型
+    PixelFormat m_requestedFormat;           // 上层要求的格式 (UNKNOWN = 配置里的原始格式)
+    std::atomic<PixelFormat> m_sensorFormat; // 当前实际输出的格式
+    std::atomic<float> m_exposureUs;
+    std::atomic<float> m_gainDb;
+    std::atomic<double> m_frameRate;
+
+    // 预渲染的场景 (仅生成线程访问)
+    cv::Mat m_scene;                         // 比画面大 2 * m_travel 的场景
+    cv::Mat m_noise;                         // 噪声库，每帧随机取一块
+    int m_travel;                            // 圆环移动的最大幅度 (像素，偶数以保持 Bayer 相位)
+
+    FrameBufferPool m_framePool;
+    AsyncFrameDispatcher m_dispatcher;       // 与 HikCamera 相同：慢消费者不会拖慢生成节拍
+    ClockCorrelator m_clock;                 // 与 HikCamera 相同：给每帧标上曝光时刻
+
+    // 生成线程
+    std::thread m_generateThread;
+    std::mutex m_runMutex;
+    std::condition_variable m_runCond;       // 停止时立即唤醒正在等截止时刻的生成线程
+    bool m_running;
+    std::atomic<uint64_t> m_lateFrames;
+
+    // 触发 (m_pendingTriggers 与 m_triggerCount 受 m_runMutex 保护)
+    std::atomic<TriggerMode> m_triggerMode;
+    std::atomic<int> m_triggerLine;
+    uint64_t m_pendingTriggers;              // 已收到、尚未出图的触发数
+    uint64_t m_triggerCount;                 // 本次取流的触发计数 (即 Frame::triggerId)
+
+    // 模拟断线 (m_outageStop 受 m_runMutex 保护)
+    DeviceEventCallback m_deviceEventCallback;
+    std::atomic<bool> m_offline;             // 断线期间生成线程照常排程但不出图
+    std::thread m_outageThread;
+    bool m_outageStop;
+
+    // 读出区域 (全幅像素)，生成线程每帧取一次快照
+    mutable std::mutex m_roiMutex;
+    SensorRoi m_roi;
+    int m_binning;
+    int m_decimation;
+
+    // 最新帧信箱 (grabFrame 同步等待用)
+    std::mutex m_latestMutex;
+    std::condition_variable m_latestCond;
+    Frame m_latestFrame;
+    uint64_t m_latestSeq;
+};
@@ -0,0 +1,696 @@
+﻿#include "SimulatedCamera.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cctype>
+
+// ====================================================
+// 1. 传感器模型常量
+// ====================================================
+// 与 HikCamera 保持一致：同时在路上的帧一般不超过这个数
+static constexpr size_t kFramePoolSlots = 16;
+static constexpr size_t kDispatchQueueCapacity = 4;
+static constexpr unsigned int kDispatchWorkers = 1; // 模拟帧不需要转换，单线程按序交付即可
+
+// 曝光 10ms、增益 0dB 时亮度系数为 1；曝光与增益 (线性倍数) 都按比例放大亮度
+static constexpr float kReferenceExposureUs = 10000.0f;
+static constexpr float kMinExposureUs = 10.0f;
+static constexpr float kMaxExposureUs = 1000000.0f;
+static constexpr float kMaxGainDb = 24.0f;
+static constexpr double kMinFrameRate = 0.1;
+static constexpr double kMaxFrameRate = 1000.0;
+
+// ROI 的最小边长 (全幅像素)；偏移与尺寸按 2 对齐，保持 Bayer 相位
+static constexpr int kMinRoiSize = 16;
+static constexpr int kRoiAlign = 2;
+
+// 圆环来回移动一周的时间 (秒)
+static constexpr double kMotionPeriodSec = 4.0;
+
+// 噪声库比画面多出的边，每帧在其中随机取一块，避免噪声图案静止不动
+static constexpr int kNoiseMargin = 64;
+
+// 模拟设备时钟：1 tick = 1 ns
+static uint64_t toDeviceTicks(std::chrono::steady_clock::duration d) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+// 按传感器排列对 RGB 三个平面采样，得到单通道 Bayer 图
+static cv::Mat mosaic(const cv::Mat& r, const cv::Mat& g, const cv::Mat& b, PixelFormat format) {
+    // [行奇偶][列奇偶] -> 0=R 1=G 2=B
+    static const int kTable[4][2][2] = {
+        { { 0, 1 }, { 1, 2 } }, // RG
+        { { 1, 2 }, { 0, 1 } }, // GB
+        { { 1, 0 }, { 2, 1 } }, // GR
+        { { 2, 1 }, { 1, 0 } }  // BG
+    };
+    const int (&table)[2][2] = kTable[static_cast<int>(bayerPatternOf(format))];
+    const cv::Mat* planes[3] = { &r, &g, &b };
+
+    cv::Mat raw(r.rows, r.cols, CV_8UC1);
+    for (int y = 0; y < raw.rows; y++) {
+        uchar* dst = raw.ptr<uchar>(y);
+        for (int x = 0; x < raw.cols; x++) {
+            dst[x] = planes[table[y & 1][x & 1]]->ptr<uchar>(y)[x];
+        }
+    }
+    return raw;
+}
+
+// 模拟的外部触发线：所有实例共享，pulseLine() 时同时唤醒挂在该线上的相机
+static std::mutex g_lineMutex;
+static std::vector<SimulatedCamera*> g_lineListeners;
+
+// ====================================================
+// 2. 构造、析构与流控制
+// ====================================================
+SimulatedCamera::SimulatedCamera(const SimulatedCameraConfig& config)
+    : m_config(config),
+    m_isOpen(false),
+    m_isStreaming(false),
+    m_requestedFormat(PixelFormat::UNKNOWN),
+    m_sensorFormat(config.format),
+    m_exposureUs(kReferenceExposureUs),
+    m_gainDb(0.0f),
+    m_frameRate(config.frameRate > 0.0 ? config.frameRate : 30.0),
+    m_travel(0),
+    m_framePool(kFramePoolSlots),
+    m_dispatcher(kDispatchQueueCapacity, kDispatchWorkers),
+    m_running(false),
+    m_lateFrames(0),
+    m_triggerMode(TriggerMode::FREE_RUN),
+    m_triggerLine(0),
+    m_pendingTriggers(0),
+    m_triggerCount(0),
+    m_offline(false),
+    m_outageStop(false),
+    m_binning(1),
+    m_decimation(1),
+    m_latestSeq(0) {
+    // Bayer 的 2x2 相位要求宽高为偶数
+    m_config.width = std::max(2, m_config.width & ~1);
+    m_config.height = std::max(2, m_config.height & ~1);
+    if (m_config.format == PixelFormat::UNKNOWN) m_config.format = PixelFormat::MONO8;
+    m_sensorFormat = m_config.format;
+    m_roi = SensorRoi{ 0, 0, m_config.width, m_config.height };
+
+    std::lock_guard<std::mutex> lock(g_lineMutex);
+    g_lineListeners.push_back(this);
+}
+
+SimulatedCamera::~SimulatedCamera() {
+    {
+        std::lock_guard<std::mutex> lock(g_lineMutex);
+        g_lineListeners.erase(std::remove(g_lineListeners.begin(), g_lineListeners.end(), this), g_lineListeners.end());
+    }
+    closeDevice();
+}
+
+void SimulatedCamera::registerFrameCallback(FrameCallback callback) {
+    std::shared_ptr<const FrameCallback> holder;
+    if (callback) holder = std::make_shared<const FrameCallback>(std::move(callback));
+
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_callback.swap(holder);
+}
+
+void SimulatedCamera::triggerCallback(const Frame& frame) {
+    std::shared_ptr<const FrameCallback> callback;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        callback = m_callback;
+    }
+    if (callback) (*callback)(frame);
+}
+
+CameraStatus SimulatedCamera::startStream() {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (m_isStreaming) return CameraStatus::SUCCESS;
+
+    renderScene();
+
+    m_dispatcher.start(
+        [](FrameJob&) { return true; }, // 模拟传感器直出目标格式，无需转换
+        [this](const Frame& frame) {
+            publishLatest(frame);
+            triggerCallback(frame);
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_running = true;
+        m_pendingTriggers = 0; // 触发计数每次开始取流从 1 重新计
+        m_triggerCount = 0;
+    }
+    m_generateThread = std::thread(&SimulatedCamera::generateLoop, this);
+    m_isStreaming = true;
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus SimulatedCamera::stopStream() {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_running = false;
+    }
+    m_runCond.notify_all();
+    if (m_generateThread.joinable()) m_generateThread.join();
+
+    m_dispatcher.stop();
+    m_isStreaming = false;
+    m_latestCond.notify_all(); // 让还在 grabFrame() 里等待的调用者立即返回
+    return CameraStatus::SUCCESS;
+}
+
+void SimulatedCamera::publishLatest(const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_latestMutex);
+        m_latestFrame = frame; // 仅增加引用计数
+        m_latestSeq++;
+    }
+    m_latestCond.notify_all();
+}
+
+// ====================================================
+// 3. 设备发现与生命周期 (deviceCount 台虚拟设备，每个实例打开其中一台)
+// ====================================================
+namespace {
+    // 第 index 台设备的序列号：把基准序列号末尾的数字加上 index (SIM00001 -> SIM00002 ...)
+    std::string nthSerial(const std::string& base, int index) {
+        if (index == 0) return base;
+        size_t digits = base.size();
+        while (digits > 0 && std::isdigit(static_cast<unsigned char>(base[digits - 1]))) digits--;
+        if (digits == base.size()) return base + "_" + std::to_string(index + 1);
+
+        std::string number = std::to_string(std::stoull(base.substr(digits)) + index);
+        size_t width = base.size() - digits;
+        if (number.size() < width) number.insert(0, width - number.size(), '0');
+        return base.substr(0, digits) + number;
+    }
+}
+
+std::vector<CameraInfo> SimulatedCamera::enumDevices() {
+    std::vector<CameraInfo> devices;
+    for (int i = 0; i < std::max(m_config.deviceCount, 1); i++) {
+        CameraInfo info;
+        info.serialNumber = nthSerial(m_config.serialNumber, i);
+        info.modelName = "SimulatedCamera";
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+CameraStatus SimulatedCamera::openDevice(const std::string& serialNumber) {
+    if (m_isOpen) return CameraStatus::SUCCESS;
+    if (!serialNumber.empty()) {
+        std::vector<CameraInfo> devices = enumDevices();
+        bool found = std::any_of(devices.begin(), devices.end(), [&](const CameraInfo& info) { return info.serialNumber == serialNumber; });
+        if (!found) return CameraStatus::DEVICE_NOT_FOUND;
+    }
+
+    // 按 RGB8 最坏情况一次性预分配帧缓冲池，稳态取流不再分配内存
+    m_framePool.reserve(static_cast<size_t>(m_config.width) * static_cast<size_t>(m_config.height) * 3);
+    m_isOpen = true;
+
+    std::cout << "[SimulatedCamera] 已打开模拟相机 " << m_config.width << "x" << m_config.height
+        << " @ " << m_frameRate.load() << " fps" << std::endl;
+    return CameraStatus::SUCCESS;
+}
+
+CameraStatus SimulatedCamera::closeDevice() {
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_outageStop = true;
+    }
+    m_runCond.notify_all();
+    if (m_outageThread.joinable()) m_outageThread.join();
+    m_offline = false;
+
+    if (!m_isOpen) return CameraStatus::SUCCESS;
+    if (m_isStreaming) stopStream();
+    m_isOpen = false;
+    return CameraStatus::SUCCESS;
+}
+
+// ====================================================
+// 4. 合成图像引擎
+// ====================================================
+void SimulatedCamera::renderScene() {
+    const int width = m_config.width;
+    const int height = m_config.height;
+    m_travel = (std::min(width, height) / 8) & ~1; // 偶数步长，裁剪窗口移动时不打乱 Bayer 相位
+
+    const int sceneWidth = width + 2 * m_travel;
+    const int sceneHeight = height + 2 * m_travel;
+
+    // A. 灰度场景：横向渐变背景 + 同心圆环 + 圆心亮斑 (与负压环检测的目标形态一致)
+    cv::Mat gray(sceneHeight, sceneWidth, CV_8UC1);
+    for (int y = 0; y < sceneHeight; y++) {
+        uchar* row = gray.ptr<uchar>(y);
+        for (int x = 0; x < sceneWidth; x++) {
+            row[x] = static_cast<uchar>(40 + 40 * x / sceneWidth);
+        }
+    }
+
+    int ringCount = std::max(1, m_config.ringCount);
+    int spacing = std::max(4, std::min(width, height) / (2 * (ringCount + 1)));
+    cv::Point center(sceneWidth / 2, sceneHeight / 2);
+    for (int k = 1; k <= ringCount; k++) {
+        cv::circle(gray, center, k * spacing, cv::Scalar(140), std::max(2, spacing / 3), cv::LINE_AA);
+    }
+    cv::circle(gray, center, std::max(2, spacing / 4), cv::Scalar(200), -1, cv::LINE_AA);
+
+    if (m_config.blurSigma > 0.0) {
+        cv::GaussianBlur(gray, gray, cv::Size(0, 0), m_config.blurSigma);
+    }
+
+    // B. 按传感器格式上色：暖色调，三个通道的亮度各不相同，方便肉眼看出通道顺序是否正确
+    PixelFormat format = m_sensorFormat;
+    if (format == PixelFormat::MONO8) {
+        m_scene = gray;
+    }
+    else {
+        cv::Mat r = gray, g, b;
+        gray.convertTo(g, -1, 0.85);
+        gray.convertTo(b, -1, 0.6);
+
+        if (isBayerFormat(format)) {
+            m_scene = mosaic(r, g, b, format);
+        }
+        else {
+            std::vector<cv::Mat> planes = (format == PixelFormat::BGR8) ? std::vector<cv::Mat>{ b, g, r } : std::vector<cv::Mat>{ r, g, b };
+            cv::merge(planes, m_scene);
+        }
+    }
+
+    // C. 噪声库：[0, 2A] 的均匀噪声，叠加前先把画面整体减去 A，噪声均值为 0
+    if (m_config.noiseAmplitude > 0) {
+        m_noise.create(height + kNoiseMargin, width + kNoiseMargin, m_scene.type());
+        cv::randu(m_noise, cv::Scalar::all(0), cv::Scalar::all(2 * m_config.noiseAmplitude + 1));
+    }
+    else {
+        m_noise.release();
+    }
+}
+
+cv::Mat SimulatedCamera::renderFrame(uint64_t index, double seconds, const SensorRoi& roi, int binning, int decimation) {
+    const double pi = 3.14159265358979323846;
+
+    // 1. 圆环沿李萨如轨迹移动：裁剪窗口在场景里平移，偏移量保持偶数；ROI 再在窗口里取一块
+    int dx = static_cast<int>(m_travel + m_travel * std::sin(2.0 * pi * seconds / kMotionPeriodSec)) & ~1;
+    int dy = static_cast<int>(m_travel + m_travel * std::cos(2.0 * pi * seconds / (kMotionPeriodSec * 1.3))) & ~1;
+    cv::Mat view = m_scene(cv::Rect(dx + roi.offsetX, dy + roi.offsetY, roi.width, roi.height));
+
+    // 2. 合并 (相邻像素取平均) 与抽样 (隔行隔列取一个)：两者都只缩小读出的那一块
+    if (binning > 1) {
+        cv::Mat binned;
+        cv::resize(view, binned, cv::Size(view.cols / binning, view.rows / binning), 0, 0, cv::INTER_AREA);
+        view = binned;
+    }
+    if (decimation > 1) {
+        cv::Mat decimated;
+        cv::resize(view, decimated, cv::Size(view.cols / decimation, view.rows / decimation), 0, 0, cv::INTER_NEAREST);
+        view = decimated;
+    }
+    const int width = view.cols;
+    const int height = view.rows;
+
+    // 3. 曝光与增益：亮度 = 场景 * (曝光 / 参考曝光) * 10^(增益dB / 20)
+    double brightness = (m_exposureUs / kReferenceExposureUs) * std::pow(10.0, m_gainDb / 20.0);
+
+    cv::Mat image = m_framePool.acquire(height, width, m_scene.type());
+    if (m_noise.empty()) {
+        view.convertTo(image, -1, brightness);
+        return image;
+    }
+
+    // 4. 噪声：按帧号确定随机偏移，同一帧号的画面可复现
+    std::minstd_rand rng(static_cast<unsigned int>(index) + 1);
+    int nx = static_cast<int>(rng() % kNoiseMargin);
+    int ny = static_cast<int>(rng() % kNoiseMargin);
+    view.convertTo(image, -1, brightness, -m_config.noiseAmplitude);
+    cv::add(image, m_noise(cv::Rect(nx, ny, width, height)), image);
+    return image;
+}
+
+void SimulatedCamera::generateLoop() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point streamStart = Clock::now();
+    Clock::time_point deadline = streamStart;
+    uint64_t index = 0;
+
+    while (true) {
+        uint64_t triggerId = 0;
+        if (m_triggerMode != TriggerMode::FREE_RUN) {
+            // 触发模式：每个触发采一帧，收到触发的时刻即曝光结束时刻
+            std::unique_lock<std::mutex> lock(m_runMutex);
+            m_runCond.wait(lock, [this] {
+                return !m_running || m_pendingTriggers > 0 || m_triggerMode == TriggerMode::FREE_RUN;
+                });
+            if (!m_running) break;
+            deadline = Clock::now(); // 切回连续采集时从这里重新排程
+            if (m_pendingTriggers == 0) continue;
+            m_pendingTriggers--;
+            triggerId = ++m_triggerCount;
+        }
+        else {
+            auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_frameRate));
+            deadline += period; // 绝对截止时刻：不受单帧处理耗时影响，不会累积漂移
+
+            // 睡到截止时刻 (停流时立即醒来)；定时器粒度带来的迟到由下面的掉队检查吸收，不占 CPU 自旋
+            {
+                std::unique_lock<std::mutex> lock(m_runMutex);
+                m_runCond.wait_until(lock, deadline, [this] { return !m_running; });
+                if (!m_running) break;
+            }
+
+            // 掉队超过一帧：跳过错过的排程，从当前时刻重新对齐，不补发突发帧
+            Clock::time_point now = Clock::now();
+            if (now - deadline > period) {
+                m_lateFrames += static_cast<uint64_t>((now - deadline) / period);
+                deadline = now;
+            }
+        }
+
+        if (m_offline) continue; // 断线：这一拍的帧丢了
+
+        SensorRoi roi;
+        int binning, decimation;
+        {
+            std::lock_guard<std::mutex> lock(m_roiMutex);
+            roi = m_roi;
+            binning = m_binning;
+            decimation = m_decimation;
+        }
+
+        index++;
+        FrameJob job;
+        Frame& frame = job.frame;
+        frame.setImage(renderFrame(index, std::chrono::duration<double>(deadline - streamStart).count(), roi, binning, decimation));
+        frame.pixelFormat = m_sensorFormat;
+        frame.sensorFormat = frame.pixelFormat;
+        frame.frameNumber = index;
+        frame.triggerId = triggerId;
+        frame.deviceTimestamp = toDeviceTicks(deadline - streamStart); // 曝光结束时刻
+        frame.sensorRect = cv::Rect(roi.offsetX, roi.offsetY, roi.width, roi.height);
+        frame.pixelStep = binning * decimation;
+        frame.hostArrival = Clock::now();
+        m_clock.correlate(frame);
+        job.width = frame.image().cols;
+        job.height = frame.image().rows;
+
+        m_dispatcher.post(std::move(job));
+    }
+}
+
+// ====================================================
+// 5. 参数控制 (改变的是合成画面的亮度与节拍)
+// ====================================================
+CameraStatus SimulatedCamera::setExposureTime(float timeUs) {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (timeUs < kMinExposureUs || timeUs > kMaxExposureUs) return CameraStatus::PARAM_SET_FAILED;
+    m_exposureUs = timeUs;
+    return CameraStatus::SUCCESS;
+}
+
+float SimulatedCamera::getExposureTime() {
+    return m_exposureUs;
+}
+
+CameraStatus SimulatedCamera::setGain(float gain) {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (gain < 0.0f || gain > kMaxGainDb) return CameraStatus::PARAM_SET_FAILED;
+    m_gainDb = gain;
+    return CameraStatus::SUCCESS;
+}
+
+float SimulatedCamera::getGain() {
+    return m_gainDb;
+}
+
+float SimulatedCamera::getMaxGain() {
+    return kMaxGainDb;
+}
+
+CameraParams SimulatedCamera::getParams() {
+    CameraParams params;
+    params.exposureTime = ParamRange{ m_exposureUs.load(), kMinExposureUs, kMaxExposureUs, 0.0, true };
+    params.gain = ParamRange{ m_gainDb.load(), 0.0, kMaxGainDb, 0.0, true };
+
+    SensorGeometry geometry = getSensorGeometry();
+    SensorRoi roi = getRoi();
+    int step = getBinning() * getDecimation();
+    params.width = ParamRange{ static_cast<double>(roi.width / step), static_cast<double>(geometry.minWidth / step),
+        static_cast<double>(geometry.maxWidth / step), static_cast<double>(geometry.widthStep / step), true };
+    params.height = ParamRange{ static_cast<double>(roi.height / step), static_cast<double>(geometry.minHeight / step),
+        static_cast<double>(geometry.maxHeight / step), static_cast<double>(geometry.heightStep / step), true };
+    params.frameRate = ParamRange{ m_frameRate.load(), kMinFrameRate, kMaxFrameRate, 0.0, true };
+    return params;
+}
+
+CameraStatus SimulatedCamera::setFrameRate(double fps) {
+    if (fps > kMaxFrameRate || (fps > 0.0 && fps < kMinFrameRate)) return CameraStatus::PARAM_SET_FAILED;
+    m_frameRate = fps > 0.0 ? fps : (m_config.frameRate > 0.0 ? m_config.frameRate : 30.0);
+    return CameraStatus::SUCCESS;
+}
+
+double SimulatedCamera::getFrameRate() const {
+    return m_frameRate;
+}
+
+uint64_t SimulatedCamera::getLateFrames() const {
+    return m_lateFrames;
+}
+
+// ====================================================
+// 5.1 触发模式 (硬触发由 pulseLine() 模拟外部信号)
+// ====================================================
+CameraStatus SimulatedCamera::setTriggerMode(TriggerMode mode, int line) {
+    if (mode == TriggerMode::HARDWARE && (line < 0 || line > 3)) return CameraStatus::PARAM_SET_FAILED;
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_triggerMode = mode;
+        m_triggerLine = line;
+        m_pendingTriggers = 0; // 切换模式时丢弃尚未响应的触发
+    }
+    m_runCond.notify_all();
+    return CameraStatus::SUCCESS;
+}
+
+TriggerMode SimulatedCamera::getTriggerMode() const {
+    return m_triggerMode;
+}
+
+CameraStatus SimulatedCamera::triggerSoftware() {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (m_triggerMode != TriggerMode::SOFTWARE) return CameraStatus::PARAM_SET_FAILED;
+    if (!m_isStreaming) return CameraStatus::STREAM_FAILED;
+    acceptTrigger();
+    return CameraStatus::SUCCESS;
+}
+
+void SimulatedCamera::pulseLine(int line) {
+    std::lock_guard<std::mutex> lock(g_lineMutex);
+    for (SimulatedCamera* camera : g_lineListeners) {
+        if (camera->m_isStreaming && camera->m_triggerMode == TriggerMode::HARDWARE && camera->m_triggerLine == line) {
+            camera->acceptTrigger();
+        }
+    }
+}
+
+void SimulatedCamera::acceptTrigger() {
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_pendingTriggers++;
+    }
+    m_runCond.notify_all();
+}
+
+// ====================================================
+// 5.2 读出区域、合并与抽样 (下一帧生效，无需停流)
+// ====================================================
+SensorGeometry SimulatedCamera::getSensorGeometry() const {
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    // 尺寸还须是合并/抽样倍数的整数倍，缩小后的图像才不会丢掉边缘
+    const int sizeStep = kRoiAlign * m_binning * m_decimation;
+
+    SensorGeometry geometry;
+    geometry.maxWidth = m_config.width;
+    geometry.maxHeight = m_config.height;
+    geometry.minWidth = std::max(kMinRoiSize, sizeStep);
+    geometry.minHeight = std::max(kMinRoiSize, sizeStep);
+    geometry.widthStep = sizeStep;
+    geometry.heightStep = sizeStep;
+    geometry.offsetXStep = kRoiAlign;
+    geometry.offsetYStep = kRoiAlign;
+    geometry.liveOffset = true;
+    return geometry;
+}
+
+CameraStatus SimulatedCamera::setRoi(const SensorRoi& roi) {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    SensorRoi aligned = getSensorGeometry().align(roi);
+
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    m_roi = aligned;
+    return CameraStatus::SUCCESS;
+}
+
+SensorRoi SimulatedCamera::getRoi() const {
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    return m_roi;
+}
+
+CameraStatus SimulatedCamera::setBinning(int factor) {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (factor != 1 && factor != 2 && factor != 4) return CameraStatus::PARAM_SET_FAILED;
+    // 逐像素合并会把不同颜色的像素混在一起：模拟的 Bayer 传感器不支持
+    if (factor != 1 && isBayerFormat(m_sensorFormat)) return CameraStatus::PARAM_SET_FAILED;
+
+    {
+        std::lock_guard<std::mutex> lock(m_roiMutex);
+        m_binning = factor;
+    }
+    SensorRoi aligned = getSensorGeometry().align(getRoi()); // 按新的步进重新对齐当前 ROI
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    m_roi = aligned;
+    return CameraStatus::SUCCESS;
+}
+
+int SimulatedCamera::getBinning() const {
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    return m_binning;
+}
+
+CameraStatus SimulatedCamera::setDecimation(int factor) {
+    if (!m_isOpen) return CameraStatus::OPEN_FAILED;
+    if (factor != 1 && factor != 2 && factor != 4) return CameraStatus::PARAM_SET_FAILED;
+    // Bayer 须按 2x2 单元抽样才能保持相位，模拟传感器只对非 Bayer 格式开放
+    if (factor != 1 && isBayerFormat(m_sensorFormat)) return CameraStatus::PARAM_SET_FAILED;
+
+    {
+        std::lock_guard<std::mutex> lock(m_roiMutex);
+        m_decimation = factor;
+    }
+    SensorRoi aligned = getSensorGeometry().align(getRoi());
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    m_roi = aligned;
+    return CameraStatus::SUCCESS;
+}
+
+int SimulatedCamera::getDecimation() const {
+    std::lock_guard<std::mutex> lock(m_roiMutex);
+    return m_decimation;
+}
+
+// ====================================================
+// 6. 像素格式：模拟传感器直出任何支持的格式
+// ====================================================
+CameraStatus SimulatedCamera::setOutputFormat(PixelFormat format) {
+    m_requestedFormat = format;
+    PixelFormat sensor = (format == PixelFormat::UNKNOWN) ? m_config.format : format;
+    if (sensor == m_sensorFormat) return CameraStatus::SUCCESS;
+
+    // 场景需要按新格式重新渲染：短暂停流
+    bool wasStreaming = m_isStreaming;
+    if (wasStreaming) stopStream();
+    m_sensorFormat = sensor;
+    if (wasStreaming) return startStream();
+    return CameraStatus::SUCCESS;
+}
+
+PixelFormat SimulatedCamera::getOutputFormat() const {
+    return m_requestedFormat;
+}
+
+FormatNegotiation SimulatedCamera::getFormatNegotiation() const {
+    FormatNegotiation result;
+    result.requested = m_requestedFormat;
+    result.sensor = m_sensorFormat;
+    result.nativeOutput = true;
+    return result;
+}
+
+CameraStatus SimulatedCamera::setHostDemosaic(bool /*inHouse*/, DemosaicQuality /*quality*/) {
+    // 帧总是以传感器格式发出，下游 Frame::toFormat() 本来就走自研引擎
+    return CameraStatus::SUCCESS;
+}
+
+FramePoolStats SimulatedCamera::getFramePoolStats() const {
+    return m_framePool.getStats();
+}
+
+DispatchStats SimulatedCamera::getDispatchStats() const {
+    return m_dispatcher.getStats();
+}
+
+ClockCorrelationStats SimulatedCamera::getClockStats() const {
+    return m_clock.getStats();
+}
+
+// ====================================================
+// 6.1 模拟断线
+// ====================================================
+void SimulatedCamera::registerDeviceEventCallback(DeviceEventCallback callback) {
+    std::lock_guard<std::mutex> lock(m_runMutex);
+    m_deviceEventCallback = callback;
+}
+
+bool SimulatedCamera::isConnected() const {
+    return m_isOpen && !m_offline;
+}
+
+void SimulatedCamera::simulateDisconnect(std::chrono::milliseconds outage) {
+    if (!m_isOpen || m_offline) return;
+    if (m_outageThread.joinable()) m_outageThread.join(); // 上一次断线已经恢复
+
+    DeviceEventCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_runMutex);
+        m_outageStop = false;
+        callback = m_deviceEventCallback;
+    }
+    m_offline = true;
+    std::cout << "[SimulatedCamera] 模拟断线 " << outage.count() << " ms" << std::endl;
+    if (callback) callback(DeviceEvent::DISCONNECTED, 0.0);
+
+    // 恢复放在单独的线程上，与真实相机一样由驱动自己完成
+    m_outageThread = std::thread([this, outage, callback]() {
+        auto begin = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(m_runMutex);
+            if (m_runCond.wait_for(lock, outage, [this] { return m_outageStop; })) return; // 关闭设备时提前结束
+        }
+        m_offline = false;
+        double outageMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        if (callback) callback(DeviceEvent::RECONNECTED, outageMs);
+        });
+}
+
+// ====================================================
+// 7. 同步抓图：等待调用之后到达的下一帧
+// ====================================================
+bool SimulatedCamera::grabFrame(cv::Mat& outFrame, int timeoutMs) {
+    Frame frame;
+    if (!grabFrame(frame, timeoutMs)) return false;
+    // 老接口的调用方不认识 Bayer，这里保持“黑白或 RGB”的约定
+    outFrame = frame.toFormat(displayFormatOf(frame.pixelFormat));
+    return true;
+}
+
+bool SimulatedCamera::grabFrame(Frame& outFrame, int timeoutMs) {
+    if (!m_isStreaming) return false;
+
+    std::unique_lock<std::mutex> lock(m_latestMutex);
+    uint64_t seenSeq = m_latestSeq;
+    bool arrived = m_latestCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        return m_latestSeq != seenSeq || !m_isStreaming;
+        });
+    if (!arrived || m_latestSeq == seenSeq) return false;
+
+    outFrame = m_latestFrame;
+    return true;
+}
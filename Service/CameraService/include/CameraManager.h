@@ -0,0 +1,128 @@
+﻿// Service/CameraService/include/CameraManager.h
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CameraService.h"
+#include "FrameSynchronizer.h"
+
+// 每台相机一个独立的驱动实例 (HikCamera / SimulatedCamera ...)，由 Application 层提供
+using CameraFactory = std::function<ICamera* ()>;
+
+// 单台相机的运行统计
+struct CameraRuntimeStats {
+    std::string serialNumber;
+    double fps = 0.0;            // 最近一个采样周期内的帧率
+    uint64_t received = 0;       // 收到的帧总数
+    uint64_t dropped = 0;        // 丢帧总数 = 帧号断层 + 被丢弃的残帧
+    double lastLatencyMs = 0.0;
+};
+
+// 所有相机的汇总
+struct CameraManagerStats {
+    std::vector<CameraRuntimeStats> cameras;
+    double totalFps = 0.0;
+    uint64_t totalReceived = 0;
+    uint64_t totalDropped = 0;
+};
+
+// =========================================================
+// CameraManager：同时驱动多台相机
+// 每台相机拥有自己的驱动实例、CameraService 与 QThread，互不阻塞；
+// 管理器只负责生命周期与统计汇总，不碰图像数据。
+// =========================================================
+class CameraManager : public QObject {
+    Q_OBJECT
+public:
+    explicit CameraManager(CameraFactory factory, QObject* parent = nullptr);
+    ~CameraManager() override;
+
+    /**
+     * @brief 打开相机
+     * @param serialNumbers 指定序列号列表；为空时打开 enumDevices() 枚举到的全部设备
+     * @return 成功打开的台数 (打不开的设备会被跳过并通过 serviceMessage 报告)
+     */
+    int openAll(const std::vector<std::string>& serialNumbers = {});
+
+    /**
+     * @brief 同 openAll()，但枚举、打开与首次参数读取 (全是 USB 往返) 都在后台线程完成
+     * @details 立即返回；完成后在管理器所在线程发出 openFinished(台数)，此时才能访问 camera()/service()。
+     *          界面可以先显示出来，不必等相机。
+     */
+    void openAllAsync(const std::vector<std::string>& serialNumbers = {});
+
+    // 为每台相机启动独立线程并开始取流
+    void startAll();
+
+    // 停流、关设备、回收线程与实例 (顺序同 AppManager：先掐断回调源头，再退线程)
+    void closeAll();
+
+    int cameraCount() const;
+    ICamera* camera(int index) const;
+    CameraService* service(int index) const;
+    std::string serialNumber(int index) const;
+
+    // 对所有相机设置触发模式，返回第一个失败的状态 (全部成功返回 SUCCESS)
+    CameraStatus setTriggerMode(TriggerMode mode, int line = 0);
+
+    // 对所有相机依次发一次软触发，返回成功的台数
+    int triggerAll();
+
+    /**
+     * @brief 开启多相机组帧：各相机的帧按触发号或时间窗拼成 FrameSet 后交给 callback
+     * @note 需在 openAll() 之后、startAll() 之前调用；callback 运行在相机回调线程上
+     */
+    void enableSynchronization(const SyncConfig& config, FrameSetCallback callback);
+    SyncStats getSyncStats() const;
+
+    // 按采样周期计算帧率并广播 statsUpdated (startAll 后由定时器周期调用，也可手动调用)
+    CameraManagerStats sampleStats();
+    void setStatsInterval(int intervalMs);
+
+signals:
+    void openFinished(int opened);
+    void statsUpdated(const CameraManagerStats& stats);
+    void serviceMessage(const QString& msg);
+
+private:
+    struct OpenedCamera {
+        std::string serialNumber;
+        ICamera* camera = nullptr;
+    };
+
+    // 枚举并打开相机 (可在任意线程调用：只用到工厂，不碰 m_units)
+    std::vector<OpenedCamera> openCameras(const std::vector<std::string>& serialNumbers);
+    // 在管理器线程上为打开的相机创建 CameraService
+    void adoptCameras(const std::vector<OpenedCamera>& opened);
+    // 收下后台打开的结果 (等待后台线程结束)
+    void finishAsyncOpen();
+
+    struct CameraUnit {
+        std::string serialNumber;
+        ICamera* camera = nullptr;
+        CameraService* service = nullptr;
+        QThread* thread = nullptr;
+
+        // 帧率采样 (仅管理器线程访问)
+        uint64_t lastReceived = 0;
+        std::chrono::steady_clock::time_point lastSample;
+    };
+
+    CameraFactory m_factory;
+    std::vector<CameraUnit> m_units;
+    std::unique_ptr<FrameSynchronizer> m_synchronizer;
+    QTimer* m_statsTimer;
+
+    // 后台打开
+    std::thread m_openThread;
+    std::mutex m_openMutex;
+    std::vector<OpenedCamera> m_openedPending;   // 后台线程的成果，交回管理器线程前暂存于此
+};
@@ -2,9 +2,27 @@
 #pragma once
 
 #include <QObject>
+#include <QTimer>
 #include <atomic>
 #include <opencv2/opencv.hpp>
 #include "ICamera.h" // 认识业务契约
+#include "RoiFollower.h"
+#include "ParamCommandQueue.h"
+#include "FrameBus.h"
+#include "LatestFrameMailbox.h"
+#include "ProcessingPipeline.h"
+#include "ParallelAnalyzer.h"
+#include "PreTriggerRecorder.h"
+#include <memory>
+
+// 帧流健康度统计：从 Frame 的帧号、丢包数、到达时刻推算而来
+struct FrameFlowStats {
+    uint64_t received = 0;       // 收到的帧总数
+    uint64_t incomplete = 0;     // 因传输丢包被丢弃的残帧数
+    uint64_t sequenceGaps = 0;   // 根据帧号断层推算出的丢帧数
+    double lastLatencyMs = 0.0;  // 最近一帧从到达主机到交给 UI 的延迟
+    double lastExposureLatencyMs = 0.0; // 最近一帧从曝光到交给 UI 的延迟 (设备时钟已拟合时才准确，否则同上)
+};
 
 class CameraService : public QObject {
     Q_OBJECT // 开启信号槽能力
@@ -17,22 +35,152 @@ public slots:
     // 启动业务主循环（这个函数未来会在 Application 分配的子线程中运行）
     void startWorkLoop();
 
-    // 停止业务主循环
+    // 停止业务主循环并停止取流 (需在 Service 所在线程调用，跨线程请排队调用)
     void stopWorkLoop();
 
-    // 接收 UI 传来的参数设置指令
+    // 接收 UI 传来的参数设置指令：进入合并队列，按固定节拍只下发每个参数的最新值
     void setExposureTime(double timeUs);
     void setGain(double gain);
+    // 传感器的采集帧率 (<= 0 不限)，同样经过合并队列
+    void setAcquisitionFrameRate(double fps);
+
+    // 预览 (previewFrameAvailable) 的目标帧率，<= 0 表示每帧都显示；没轮到的帧不做显示格式转换
+    void setPreviewFrameRate(double fps);
+
+    // 按使用场景切换取流策略 (取流中直接生效，不会重新打开相机)
+    void usePreviewStrategy();    // 实时预览：只要最新一帧，延迟最低
+    void useRecordingStrategy();  // 录像：逐帧交付，绝不丢帧
+
+    // 传感器读出区域 (全幅像素)、合并与抽样
+    void setRoi(int offsetX, int offsetY, int width, int height);
+    void setBinning(int factor);
+    void setDecimation(int factor);
+
+    // ROI 跟随：开启后按 reportRingDetection() 送来的检测结果移动 ROI，关闭时恢复全幅
+    void setRoiFollowEnabled(bool enabled);
+    // 分析端回报一帧的检测结果 (圆心与半径为传感器全幅坐标，用 Frame::toSensor 换算)
+    void reportRingDetection(double centerX, double centerY, double radius, bool found);
+
+    // 事件录制：把事件前后的原始帧写成 .ocvraw (需先 enableEventCapture)；检测目标丢失时也会自动触发
+    void captureEvent(const QString& reason);
+
+
+public:
+    // 通用入口：自定义取流策略与输出队列深度 (需在 Service 所在线程调用)
+    void setGrabStrategy(GrabStrategy strategy, unsigned int queueSize = 1);
+
+    // 指定下游需要的像素格式：传感器能直出就不再做主机转换 (需在 Service 所在线程调用)
+    void setOutputFormat(PixelFormat format);
+
+    // 旁路观察者：每个通过检查的帧都会在相机回调线程上原样交给它 (如多相机组帧)，需在 startWorkLoop 之前设置
+    void setFrameObserver(FrameCallback observer);
+
+    // 帧总线订阅：每个订阅者有自己的有界队列、背压策略与交付线程 (见 FrameBus)，预览本身也是其中之一
+    // 回调以传感器原始格式拿到帧 (引用计数共享，不拷贝)；慢的订阅者只会让自己丢帧，不会拖慢采集与其他订阅者。
+    // 不能在回调里增删订阅者。线程安全，取流中可随时增删；返回订阅号。
+    int addFrameSubscriber(const FrameSubscription& subscription, FrameCallback callback);
+    // 简写：按帧率订阅 (<= 0 表示每帧都要)，队列满时挤掉最旧的帧
+    int addFrameSubscriber(double targetFps, FrameCallback callback);
+    void removeFrameSubscriber(int id);  // 返回后回调不会再被调用
+    void setSubscriberFrameRate(int id, double targetFps);
+    FrameBusSubscriberStats getSubscriberStats(int id) const;
+    FrameBusSubscriberStats getPreviewStats() const;
+    std::vector<FrameBusSubscriberStats> getFrameBusStats() const;  // 全部订阅者 (含预览)
+
+    // 预览信箱：界面收到 previewFrameAvailable 后从这里取最新一帧 (显示格式)；共享所有权，界面可比服务活得久
+    std::shared_ptr<LatestFrameMailbox> previewMailbox() const;
+    MailboxStats getPreviewMailboxStats() const;
+
+    // 事件录制：始终在内存里保留最近一段原始帧，captureEvent() 时把事件前后的一段写进 directory
+    // 挂在帧订阅上 (每帧都要)，拷贝与写盘都在录制器自己的线程上，不增加回调线程的耗时；取流中可随时开关
+    void enableEventCapture(const PreTriggerConfig& config, const QString& directory);
+    void disableEventCapture();  // 等已触发的事件写完再返回
+    PreTriggerStats getEventCaptureStats() const;
 
+    // 实时负压环分析：帧总线上挂一条处理流水线 (见 ProcessingPipeline)，每个阶段一条线程
+    // 结果经 ringAnalyzed 报告 (同时喂给 ROI 跟随与事件录制)，标注图放进分析信箱；需在 Service 所在线程调用
+    void enableRingAnalysis(const RingDetectorConfig& config = RingDetectorConfig(), double targetFps = 0.0);
+    // 同上，但改为帧级并行 (见 ParallelAnalyzer)：单帧分析比帧周期还长时用它，结果仍按帧序报告
+    void enableParallelRingAnalysis(const ParallelAnalyzerConfig& parallel,
+        const RingDetectorConfig& config = RingDetectorConfig(), double targetFps = 0.0);
+    void disableRingAnalysis();
+    PipelineStats getAnalysisStats() const;                  // 仅流水线模式
+    ParallelAnalyzerStats getParallelAnalysisStats() const;  // 仅帧级并行模式
+    std::shared_ptr<LatestFrameMailbox> analysisMailbox() const;
+
+    // 线程安全：随时可查询帧流统计
+    FrameFlowStats getFrameFlowStats() const;
+    RoiFollowStats getRoiFollowStats() const;
+    ParamQueueStats getParamQueueStats() const;
 
 signals:
-    // 【跨界翻译】：当底层抓到纯 C++ 的 cv::Mat 图像后，通过 Qt 信号发给 UI 层
-    void frameReadyToShow(const cv::Mat& image);
+    // 【跨界翻译】：预览信箱由空变满时通知 UI 来取图 (图本身不走信号)
+    // UI 线程忙时新帧直接覆盖信箱里的旧帧，事件队列里最多只有一个这样的通知，画面永远只落后一帧
+    void previewFrameAvailable();
+
+    // 参数真正写入设备后，回报请求值与设备实际采用的值 (可能被对齐或钳位)；期间又有新值排队时不回报
+    void exposureTimeApplied(double requestedUs, double appliedUs);
+    void gainApplied(double requested, double applied);
 
     // 向外部报告服务状态或错误（可选）
     void serviceMessage(const QString& msg);
 
+    // 相机断线/重连 (同时也会发一条 serviceMessage)；界面据此提示，不必解析消息文本
+    void connectionStateChanged(bool connected, const QString& msg);
+
+    // 一个事件窗口写盘结束 (同时也会发一条 serviceMessage)
+    void eventCaptured(const QString& path, qulonglong frames, bool ok);
+
+    // 一帧分析完成：圆心与半径为传感器全幅坐标
+    void ringAnalyzed(bool found, double centerX, double centerY, double radius, qulonglong frameNumber);
+    // 分析信箱由空变满 (与预览信箱同样的用法)
+    void analysisFrameAvailable();
+
+private:
+    // 在相机回调线程中执行：统计丢帧、拦截残帧，返回该帧是否值得继续处理
+    bool acceptFrame(const Frame& frame);
+
+    // 在预览订阅者的交付线程中执行：转换为显示格式并放进预览信箱
+    void deliverPreview(const Frame& frame);
+
+    // 在分析线程中执行：标注图进分析信箱，检测结果换算到传感器坐标后排队回本线程
+    void publishAnalysis(const PipelineItem& item);
+
+    // 参数队列：能下发就立即下发，否则定时到下一个允许的时刻
+    void scheduleParamFlush();
+    void flushParams();
+
 private:
     ICamera* m_camera;                // 底层相机实例指针
     std::atomic<bool> m_isWorking;    // 线程安全的循环标志位
+    FrameCallback m_frameObserver;    // 旁路观察者 (可为空)
+    RoiFollower m_roiFollower;
+    bool m_roiFollowEnabled;
+    ParamCommandQueue m_paramQueue;
+    QTimer* m_paramTimer;             // 子对象：随 Service 一起迁到相机线程
+
+    // 帧总线：预览、分析、录像各自一个订阅者
+    FrameBus m_frameBus;
+    int m_previewSubscriberId;
+    std::shared_ptr<LatestFrameMailbox> m_previewMailbox;
+
+    // 事件录制 (仅 Service 所在线程访问)
+    std::unique_ptr<PreTriggerRecorder> m_eventRecorder;
+    int m_eventSubscriberId;
+    QString m_eventDirectory;
+    bool m_ringFound;                 // 上一帧是否检测到目标，由有变无时自动触发事件
+
+    // 实时分析 (仅 Service 所在线程访问；结果从流水线线程排队回到本线程)
+    std::unique_ptr<ProcessingPipeline> m_analysisPipeline;  // 两种模式同一时刻只开一种
+    std::unique_ptr<ParallelAnalyzer> m_parallelAnalyzer;
+    int m_analysisSubscriberId;
+    std::shared_ptr<LatestFrameMailbox> m_analysisMailbox;
+
+    // 帧流统计 (回调线程写，任意线程读)
+    std::atomic<uint64_t> m_received;
+    std::atomic<uint64_t> m_incomplete;
+    std::atomic<uint64_t> m_sequenceGaps;
+    std::atomic<double> m_lastLatencyMs;
+    std::atomic<double> m_lastExposureLatencyMs;
+    uint64_t m_lastFrameNumber;       // 仅回调线程访问
 };
\ No newline at end of file
@@ -0,0 +1,122 @@
+﻿// Service/CameraService/include/ParallelAnalyzer.h
+#pragma once
+
+#include "ProcessingPipeline.h"
+#include "TaskScheduler.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+struct ParallelAnalyzerConfig {
+    size_t workers = 0;                        // 并行度：同时分析的帧数 (阶段链的套数)，0 = 调度器的工作线程数
+    TaskPriority priority = TaskPriority::ANALYSIS; // 分析任务在共享调度器里的优先级类别
+    size_t reorderWindow = 8;                  // 已送入、尚未按序交出的帧最多这么多，再来的帧在入口丢弃 (不小于 workers)
+    bool dropLate = false;                     // 队首一帧迟迟出不了结果时，是否跳过它、先交出后面已完成的帧
+    std::chrono::milliseconds maxWait{ 200 };  // 仅 dropLate：已完成的帧最多为队首等这么久，被跳过的帧结果作废
+};
+
+struct ParallelAnalyzerStats {
+    size_t workers = 0;
+    size_t reorderWindow = 0;
+    uint64_t pushed = 0;          // 送进入口的帧数
+    uint64_t entryDropped = 0;    // 重排窗口已满、在入口丢弃的帧数 (分析跟不上相机)
+    uint64_t analyzed = 0;        // 分析完成的帧数 (含作废的)
+    uint64_t emitted = 0;         // 按帧序交给结果回调的帧数
+    uint64_t rejected = 0;        // 某个阶段返回 false、没有结果的帧数 (不占顺序，后面的帧照常交出)
+    uint64_t lateDropped = 0;     // dropLate：被跳过、结果作废的帧数
+    size_t inFlight = 0;          // 已送入、尚未交出 (排队 + 分析中 + 等待重排)
+    size_t reorderPending = 0;    // 已分析完、在等前面的帧
+    size_t peakReorderPending = 0;
+    double maxReorderWaitMs = 0.0; // 分析完到按序交出之间等得最久的一次
+    double lastAnalyzeMs = 0.0;   // 单帧分析耗时 (整条阶段链)
+    double avgAnalyzeMs = 0.0;
+    double maxAnalyzeMs = 0.0;
+    double lastLatencyMs = 0.0;   // 最近一帧从到达主机到交出的延迟
+};
+
+// =========================================================
+// ParallelAnalyzer：帧级并行的分析器 + 重排缓冲
+// 单帧分析 (resize + CLAHE + 中值滤波 + 霍夫圆) 比一个帧周期还长时，ProcessingPipeline 的
+// 吞吐量受限于最慢的那一级 (霍夫圆)；这里改为每帧一个任务、在共享调度器 (TaskScheduler) 上
+// 对整帧跑完整条阶段链，几帧同时分析，完成顺序不定，由重排缓冲按送入顺序逐帧交出。
+// 分析器自己不开线程，同时在调度器上执行的任务不超过 workers 个。
+//
+// 阶段不共享：用 StageFactory 造 workers 套阶段，每个任务借用一套 (CLAHE 对象等不能并发共用)。
+// 背压：在途帧数达到 reorderWindow 时入口直接丢新帧，相机侧永不等待。
+// 迟到：默认严格按序，队首没完成后面的都等着；开启 dropLate 后，后面的帧等够 maxWait
+//      就跳过队首，它的结果回来时直接作废 (计入 lateDropped)，交出的帧序仍然单调递增；
+//      是否等够在有结果完成或有新帧送入时判定。
+// 线程：结果回调在调度器的工作线程上调用，同一时刻只有一个任务在调用，严格按帧序；
+//      push() 可在任意线程调用。
+// =========================================================
+class ParallelAnalyzer {
+public:
+    using StageFactory = std::function<std::vector<PipelineStage>()>;
+
+    explicit ParallelAnalyzer(StageFactory factory, const ParallelAnalyzerConfig& config = ParallelAnalyzerConfig(),
+        TaskScheduler& scheduler = TaskScheduler::shared());
+    ~ParallelAnalyzer();
+
+    ParallelAnalyzer(const ParallelAnalyzer&) = delete;
+    ParallelAnalyzer& operator=(const ParallelAnalyzer&) = delete;
+
+    // 造好各套阶段并开始接收帧；已启动时返回 false
+    bool start(PipelineResultCallback callback);
+    // 停止：丢弃排队与待重排的帧，等正在分析的帧做完；返回后回调不会再被调用
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * @brief 送入一帧 (永不阻塞)
+     * @return false 表示重排窗口已满，帧被丢弃
+     */
+    bool push(const Frame& frame);
+
+    ParallelAnalyzerStats getStats() const;
+
+private:
+    // 重排窗口里的一帧
+    struct Slot {
+        enum class State { PENDING, DONE, REJECTED };
+        State state = State::PENDING;
+        PipelineItem item;
+        std::chrono::steady_clock::time_point doneAt;
+    };
+
+    struct Task {
+        uint64_t seq;
+        PipelineItem item;
+    };
+
+    // 调度器上的一个任务：分析一帧 (没有待分析的帧时只做交出)，还有帧排队就接力提交下一个
+    void runTask();
+    // 以下均需持有 m_mutex
+    bool scheduleLocked();   // 返回 true 表示调用方需要 (在锁外) 提交一个任务
+    void completeLocked(uint64_t seq, PipelineItem& item, bool ok, double analyzeMs);
+    void skipLateLocked(std::chrono::steady_clock::time_point now);
+    void emitReadyLocked(std::unique_lock<std::mutex>& lock);
+
+private:
+    const StageFactory m_factory;
+    ParallelAnalyzerConfig m_config;
+    TaskScheduler& m_scheduler;
+    PipelineResultCallback m_callback;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idleCond;    // 停止时等调度器上的任务全部结束
+    bool m_running;
+    bool m_emitting;                       // 有一个任务正在按序交出结果 (其余任务只管放进窗口)
+    size_t m_activeTasks;                  // 已提交到调度器、尚未结束的任务数 (不超过 workers)
+    std::vector<std::vector<PipelineStage>> m_chains;
+    std::vector<size_t> m_freeChains;      // 空闲的阶段链下标
+    std::deque<Task> m_tasks;              // 等待分析的帧
+    std::map<uint64_t, Slot> m_window;     // 按送入序号排列，首元素即下一帧要交出的
+    uint64_t m_nextSeq;
+    ParallelAnalyzerStats m_stats;     // 不含 inFlight/reorderPending/avgAnalyzeMs (取统计时现算)
+    double m_totalAnalyzeMs;
+};
@@ -0,0 +1,62 @@
+﻿// Service/CameraService/include/ParamCommandQueue.h
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// 经由命令队列下发的相机参数
+enum class CameraParam {
+    EXPOSURE_TIME,  // 曝光时间 (us)
+    GAIN,           // 增益 (dB)
+    FRAME_RATE,     // 采集帧率 (fps，<= 0 不限)
+    COUNT
+};
+
+struct ParamCommand {
+    CameraParam param;
+    double value;
+};
+
+struct ParamQueueStats {
+    uint64_t posted = 0;      // 收到的写请求数
+    uint64_t applied = 0;     // 实际下发到设备的次数
+    uint64_t coalesced = 0;   // 被同一参数更新的值覆盖、没有下发的请求数
+};
+
+// =========================================================
+// ParamCommandQueue：相机参数写入的合并队列
+// 界面拖动数值框时每一步都会发来一个新值，但只有最后一个值有意义：
+// 同一参数尚未下发的旧值直接被新值覆盖，两次下发之间至少间隔 minInterval，
+// 把一串 SDK 同步往返压缩成每个周期一次。
+// 线程安全；本身不含定时器，何时调用 take() 由持有者 (CameraService) 安排。
+// =========================================================
+class ParamCommandQueue {
+public:
+    explicit ParamCommandQueue(std::chrono::milliseconds minInterval);
+
+    // 投递一个写请求；返回 true 表示投递前队列是空的 (持有者需要安排一次下发)
+    bool post(CameraParam param, double value);
+
+    // 距离允许下一次下发还需等待多久 (0 表示现在即可)
+    std::chrono::milliseconds timeUntilDue(std::chrono::steady_clock::time_point now) const;
+
+    // 取出所有待下发的命令 (每个参数最多一条，均为最新值)，并把 now 记为本次下发时刻
+    std::vector<ParamCommand> take(std::chrono::steady_clock::time_point now);
+
+    // 该参数是否又有了新的待下发值 (有则不必把刚下发的值回显给界面)
+    bool hasPending(CameraParam param) const;
+
+    ParamQueueStats getStats() const;
+
+private:
+    const std::chrono::milliseconds m_minInterval;
+
+    mutable std::mutex m_mutex;
+    std::array<std::optional<double>, static_cast<size_t>(CameraParam::COUNT)> m_pending;
+    std::chrono::steady_clock::time_point m_lastApply;
+    bool m_hasApplied;
+    ParamQueueStats m_stats;
+};
@@ -0,0 +1,126 @@
+﻿// Service/CameraService/include/ProcessingPipeline.h
+#pragma once
+
+#include "Frame.h"
+#include "RingDetector.h"
+#include "SpscRingQueue.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 在流水线里逐级加工的一件“工件”
+struct PipelineItem {
+    Frame frame;              // 源帧 (元数据 + 原始图像，只读)
+    cv::Mat image;            // 当前工作图像：入口处为显示格式 (黑白或 RGB)，各阶段依次加工
+    float scale = 1.0f;       // image 相对源帧的缩放倍率 (坐标还原时乘回去)
+    RingDetection detection;  // detect 阶段的结果 (源帧图像坐标)
+    cv::Mat annotated;        // annotate 阶段的输出：源帧分辨率的标注图
+};
+
+// 一个阶段：返回 false 表示这件工件到此为止 (不再往下传)
+struct PipelineStage {
+    std::string name;
+    std::function<bool(PipelineItem& item)> process;
+};
+
+// 负压环检测拆成的各个阶段，可以自由组合
+namespace PipelineStages {
+    PipelineStage resize(int targetWidth);
+    PipelineStage gray();
+    PipelineStage clahe(double clipLimit, int tileSize);
+    PipelineStage median(int ksize);
+    PipelineStage detectRing(const RingDetectorConfig& config);
+    PipelineStage annotate();
+
+    // 完整的负压环检测：resize -> gray -> clahe -> median -> detect -> annotate
+    std::vector<PipelineStage> ringDetection(const RingDetectorConfig& config = RingDetectorConfig());
+}
+
+struct PipelineStageStats {
+    std::string name;
+    size_t queueDepth = 0;     // 输入队列当前排队数
+    size_t queueCapacity = 0;
+    uint64_t processed = 0;    // 处理过的工件数
+    uint64_t rejected = 0;     // 阶段返回 false、没有往下传的工件数
+    double lastMs = 0.0;       // 最近一件的处理耗时
+    double avgMs = 0.0;
+    double maxMs = 0.0;
+};
+
+struct PipelineStats {
+    uint64_t pushed = 0;        // 送进入口的帧数
+    uint64_t entryDropped = 0;  // 入口队列满被丢弃的帧数 (最慢的阶段跟不上相机)
+    uint64_t completed = 0;     // 走完全部阶段、交给结果回调的帧数
+    double lastLatencyMs = 0.0; // 最近一帧从到达主机到走完流水线的延迟
+    std::vector<PipelineStageStats> stages;
+};
+
+// 在最后一个阶段的线程上调用
+using PipelineResultCallback = std::function<void(const PipelineItem& item)>;
+
+// =========================================================
+// ProcessingPipeline：按阶段拆开的处理流水线
+// 每个阶段一条线程，相邻阶段之间用无锁 SPSC 环形队列连接：第 N 帧在做霍夫圆时，
+// 第 N+1 帧已经在做中值滤波、第 N+2 帧在做 CLAHE ... 吞吐量取决于最慢的那一级，而不是各级之和。
+//
+// 背压：入口队列满时直接丢掉新帧 (计入 entryDropped)，相机侧永不等待；
+//      阶段之间不丢帧，下游满了上游就等，保证进了流水线的帧按顺序走完。
+// 线程：push() 只能在同一条线程上调用 (入口队列是单生产者)；addStage() 需在 start() 之前调用。
+// =========================================================
+class ProcessingPipeline {
+public:
+    explicit ProcessingPipeline(size_t queueDepth = 4);
+    ~ProcessingPipeline();
+
+    ProcessingPipeline(const ProcessingPipeline&) = delete;
+    ProcessingPipeline& operator=(const ProcessingPipeline&) = delete;
+
+    void addStage(PipelineStage stage);
+    void addStages(const std::vector<PipelineStage>& stages);
+
+    // 启动各阶段线程；没有阶段或已启动时返回 false
+    bool start(PipelineResultCallback callback);
+    // 停止：丢弃仍在排队的工件，等正在处理的那一件做完
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * @brief 送入一帧 (永不阻塞)
+     * @return false 表示入口队列已满，帧被丢弃
+     */
+    bool push(const Frame& frame);
+
+    PipelineStats getStats() const;
+
+private:
+    struct StageRuntime {
+        StageRuntime(PipelineStage s, size_t depth) : stage(std::move(s)), input(depth) {}
+        PipelineStage stage;
+        SpscRingQueue<PipelineItem> input;   // 本阶段的输入队列 (上一阶段或 push() 是唯一的生产方)
+        std::thread thread;
+        std::atomic<uint64_t> processed{ 0 };
+        std::atomic<uint64_t> rejected{ 0 };
+        std::atomic<double> totalMs{ 0.0 };
+        std::atomic<double> lastMs{ 0.0 };
+        std::atomic<double> maxMs{ 0.0 };
+    };
+
+    void stageLoop(size_t index);
+    // 阻塞式交接：下游满了就等门铃，停止时放弃
+    bool handOff(StageRuntime& next, PipelineItem& item);
+
+private:
+    size_t m_queueDepth;
+    std::vector<std::unique_ptr<StageRuntime>> m_stages;
+    PipelineResultCallback m_callback;
+    std::atomic<bool> m_running;
+
+    std::atomic<uint64_t> m_pushed;
+    std::atomic<uint64_t> m_entryDropped;
+    std::atomic<uint64_t> m_completed;
+    std::atomic<double> m_lastLatencyMs;
+};
@@ -0,0 +1,88 @@
+﻿// Service/CameraService/include/SpscRingQueue.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =========================================================
+// SpscRingQueue：单生产者/单消费者的无锁环形队列 (流水线相邻两级之间的连接)
+// 生产方只写 m_tail，消费方只写 m_head，两边各自一个原子下标，入队出队都不加锁；
+// 两个下标分放在不同的缓存行上，避免两条线程来回抢同一行。
+//
+// 等待：队列本身从不阻塞 (tryPush/tryPop)。空/满时需要让出 CPU 的一方先记下门铃值，
+//      再确认一次条件，然后 waitXxx() 睡在门铃上；对方每次出入队都会按门铃 (C++20 atomic wait/notify)。
+//      wake() 用于停止时把两边都叫醒。
+// 约束：tryPush() 只能在同一条线程上调用，tryPop() 也只能在同一条线程上调用。
+// =========================================================
+template <typename T>
+class SpscRingQueue {
+public:
+    // 容量向上取整到 2 的幂 (下标取模变成按位与)
+    explicit SpscRingQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscRingQueue(const SpscRingQueue&) = delete;
+    SpscRingQueue& operator=(const SpscRingQueue&) = delete;
+
+    size_t capacity() const { return m_slots.size(); }
+
+    // 近似值 (两边都在动)，仅用于统计
+    size_t size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    // 生产方：队列满时返回 false，item 保持不变
+    bool tryPush(T& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= m_slots.size()) return false;
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        ring(m_pushBell);
+        return true;
+    }
+
+    // 消费方：队列空时返回 false
+    bool tryPop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        item = std::move(m_slots[head & m_mask]);
+        m_slots[head & m_mask] = T(); // 立即释放槽里的引用 (如 cv::Mat)，不等被覆盖
+        m_head.store(head + 1, std::memory_order_release);
+        ring(m_popBell);
+        return true;
+    }
+
+    // 门铃：先取值，再检查条件，条件不满足才 wait
+    uint32_t pushBell() const { return m_pushBell.load(std::memory_order_acquire); }
+    uint32_t popBell() const { return m_popBell.load(std::memory_order_acquire); }
+    void waitForPush(uint32_t seen) const { m_pushBell.wait(seen, std::memory_order_acquire); }
+    void waitForPop(uint32_t seen) const { m_popBell.wait(seen, std::memory_order_acquire); }
+
+    // 叫醒所有等待方 (停止时用)
+    void wake() {
+        ring(m_pushBell);
+        ring(m_popBell);
+    }
+
+private:
+    static void ring(std::atomic<uint32_t>& bell) {
+        bell.fetch_add(1, std::memory_order_release);
+        bell.notify_all();
+    }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> m_slots;
+    size_t m_mask = 0;
+    alignas(kCacheLine) std::atomic<size_t> m_head{ 0 };   // 消费方写
+    alignas(kCacheLine) std::atomic<size_t> m_tail{ 0 };   // 生产方写
+    alignas(kCacheLine) std::atomic<uint32_t> m_pushBell{ 0 };
+    alignas(kCacheLine) std::atomic<uint32_t> m_popBell{ 0 };
+};
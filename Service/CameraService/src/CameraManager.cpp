@@ -0,0 +1,241 @@
+﻿// Service/CameraService/src/CameraManager.cpp
+#include "CameraManager.h"
+#include <QDebug>
+
+static constexpr int kDefaultStatsIntervalMs = 1000;
+
+CameraManager::CameraManager(CameraFactory factory, QObject* parent)
+    : QObject(parent), m_factory(std::move(factory)), m_statsTimer(new QTimer(this)) {
+    m_statsTimer->setInterval(kDefaultStatsIntervalMs);
+    connect(m_statsTimer, &QTimer::timeout, this, [this]() { sampleStats(); });
+}
+
+CameraManager::~CameraManager() {
+    closeAll();
+}
+
+// ==========================================
+// 1. 打开：每台相机一个独立的驱动实例
+// ==========================================
+int CameraManager::openAll(const std::vector<std::string>& serialNumbers) {
+    if (!m_factory || !m_units.empty() || m_openThread.joinable()) return cameraCount();
+    adoptCameras(openCameras(serialNumbers));
+    return cameraCount();
+}
+
+void CameraManager::openAllAsync(const std::vector<std::string>& serialNumbers) {
+    if (!m_factory || !m_units.empty() || m_openThread.joinable()) return;
+
+    m_openThread = std::thread([this, serialNumbers]() {
+        std::vector<OpenedCamera> opened = openCameras(serialNumbers);
+        {
+            std::lock_guard<std::mutex> lock(m_openMutex);
+            m_openedPending = opened;
+        }
+        // 回到管理器线程装配 (CameraService 是 QObject，必须在将要管理它的线程上创建)
+        QMetaObject::invokeMethod(this, [this]() {
+            finishAsyncOpen();
+            emit openFinished(cameraCount());
+            }, Qt::QueuedConnection);
+        });
+}
+
+void CameraManager::finishAsyncOpen() {
+    if (!m_openThread.joinable()) return;
+    m_openThread.join();
+
+    std::vector<OpenedCamera> opened;
+    {
+        std::lock_guard<std::mutex> lock(m_openMutex);
+        opened.swap(m_openedPending);
+    }
+    adoptCameras(opened);
+}
+
+std::vector<CameraManager::OpenedCamera> CameraManager::openCameras(const std::vector<std::string>& serialNumbers) {
+    std::vector<std::string> targets = serialNumbers;
+    if (targets.empty()) {
+        // 借一个临时实例做枚举；驱动实例本身不占用设备
+        ICamera* probe = m_factory();
+        for (const CameraInfo& info : probe->enumDevices()) {
+            targets.push_back(info.serialNumber);
+        }
+        delete probe;
+    }
+
+    std::vector<OpenedCamera> opened;
+    for (const std::string& serial : targets) {
+        ICamera* camera = m_factory();
+        CameraStatus status = camera->openDevice(serial);
+        if (status != CameraStatus::SUCCESS) {
+            qDebug() << "[CameraManager] 相机打开失败:" << QString::fromStdString(serial) << "错误码:" << static_cast<int>(status);
+            emit serviceMessage(QString("Failed to open camera %1.").arg(QString::fromStdString(serial)));
+            delete camera;
+            continue;
+        }
+
+        camera->getParams(); // 顺带把参数快照读好，界面初始化时不必再访问设备
+        opened.push_back(OpenedCamera{ serial, camera });
+    }
+
+    qDebug() << "[CameraManager] 已打开相机:" << opened.size() << "/" << targets.size();
+    return opened;
+}
+
+void CameraManager::adoptCameras(const std::vector<OpenedCamera>& opened) {
+    for (const OpenedCamera& camera : opened) {
+        CameraUnit unit;
+        unit.serialNumber = camera.serialNumber;
+        unit.camera = camera.camera;
+        unit.service = new CameraService(camera.camera);
+        m_units.push_back(unit);
+    }
+}
+
+// ==========================================
+// 2. 启动：一台相机一条线程，互不影响
+// ==========================================
+void CameraManager::startAll() {
+    auto now = std::chrono::steady_clock::now();
+    for (CameraUnit& unit : m_units) {
+        if (unit.thread) continue;
+
+        unit.thread = new QThread();
+        unit.service->moveToThread(unit.thread);
+        connect(unit.thread, &QThread::started, unit.service, &CameraService::startWorkLoop);
+
+        unit.lastReceived = unit.service->getFrameFlowStats().received;
+        unit.lastSample = now;
+        unit.thread->start();
+    }
+    m_statsTimer->start();
+}
+
+void CameraManager::closeAll() {
+    m_statsTimer->stop();
+
+    // 0. 后台还在打开：等它结束并收下成果，下面一并关闭
+    finishAsyncOpen();
+
+    // 1. 先让所有硬件停止抓图，掐断回调源头
+    //    停流交给服务自己的线程执行 (阻塞等它做完)，不与该线程上的参数下发、策略切换并发访问驱动
+    for (CameraUnit& unit : m_units) {
+        if (unit.thread && unit.thread->isRunning() && QThread::currentThread() != unit.thread) {
+            CameraService* service = unit.service;
+            QMetaObject::invokeMethod(service, [service]() { service->stopWorkLoop(); }, Qt::BlockingQueuedConnection);
+        }
+        else {
+            unit.service->stopWorkLoop(); // 线程还没启动：服务仍归当前线程所有
+        }
+    }
+
+    // 2. 再退出各自的线程，之后驱动只剩当前线程在用，可以安全关闭
+    for (CameraUnit& unit : m_units) {
+        if (unit.thread) {
+            unit.thread->quit();
+            unit.thread->wait();
+        }
+        unit.camera->closeDevice();
+    }
+
+    // 没凑齐的组按残组结算，统计才完整
+    if (m_synchronizer) m_synchronizer->flush();
+
+    // 3. 最后释放 (此时不会再有回调了)
+    for (CameraUnit& unit : m_units) {
+        delete unit.service;
+        delete unit.thread;
+        delete unit.camera;
+    }
+    m_units.clear();
+}
+
+int CameraManager::cameraCount() const {
+    return static_cast<int>(m_units.size());
+}
+
+ICamera* CameraManager::camera(int index) const {
+    return (index >= 0 && index < cameraCount()) ? m_units[index].camera : nullptr;
+}
+
+CameraService* CameraManager::service(int index) const {
+    return (index >= 0 && index < cameraCount()) ? m_units[index].service : nullptr;
+}
+
+std::string CameraManager::serialNumber(int index) const {
+    return (index >= 0 && index < cameraCount()) ? m_units[index].serialNumber : std::string();
+}
+
+// ==========================================
+// 3. 触发与多相机组帧
+// ==========================================
+CameraStatus CameraManager::setTriggerMode(TriggerMode mode, int line) {
+    CameraStatus result = CameraStatus::SUCCESS;
+    for (CameraUnit& unit : m_units) {
+        CameraStatus status = unit.camera->setTriggerMode(mode, line);
+        if (status != CameraStatus::SUCCESS && result == CameraStatus::SUCCESS) {
+            qDebug() << "[CameraManager] 设置触发模式失败:" << QString::fromStdString(unit.serialNumber);
+            result = status;
+        }
+    }
+    return result;
+}
+
+int CameraManager::triggerAll() {
+    int triggered = 0;
+    for (CameraUnit& unit : m_units) {
+        if (unit.camera->triggerSoftware() == CameraStatus::SUCCESS) triggered++;
+    }
+    return triggered;
+}
+
+void CameraManager::enableSynchronization(const SyncConfig& config, FrameSetCallback callback) {
+    m_synchronizer = std::make_unique<FrameSynchronizer>(m_units.size(), config);
+    m_synchronizer->setCallback(std::move(callback));
+
+    FrameSynchronizer* synchronizer = m_synchronizer.get();
+    for (size_t i = 0; i < m_units.size(); i++) {
+        m_units[i].service->setFrameObserver([synchronizer, i](const Frame& frame) {
+            synchronizer->push(i, frame);
+            });
+    }
+}
+
+SyncStats CameraManager::getSyncStats() const {
+    return m_synchronizer ? m_synchronizer->getStats() : SyncStats{};
+}
+
+// ==========================================
+// 4. 统计：帧率 = 采样周期内新增的帧数 / 周期时长
+// ==========================================
+CameraManagerStats CameraManager::sampleStats() {
+    CameraManagerStats stats;
+    auto now = std::chrono::steady_clock::now();
+
+    for (CameraUnit& unit : m_units) {
+        FrameFlowStats flow = unit.service->getFrameFlowStats();
+
+        CameraRuntimeStats camera;
+        camera.serialNumber = unit.serialNumber;
+        camera.received = flow.received;
+        camera.dropped = flow.sequenceGaps + flow.incomplete;
+        camera.lastLatencyMs = flow.lastLatencyMs;
+
+        double seconds = std::chrono::duration<double>(now - unit.lastSample).count();
+        if (seconds > 0.0) camera.fps = (flow.received - unit.lastReceived) / seconds;
+        unit.lastReceived = flow.received;
+        unit.lastSample = now;
+
+        stats.totalFps += camera.fps;
+        stats.totalReceived += camera.received;
+        stats.totalDropped += camera.dropped;
+        stats.cameras.push_back(camera);
+    }
+
+    emit statsUpdated(stats);
+    return stats;
+}
+
+void CameraManager::setStatsInterval(int intervalMs) {
+    m_statsTimer->setInterval(intervalMs);
+}
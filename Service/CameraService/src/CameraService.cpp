@@ -1,13 +1,59 @@
 ﻿// Service/CameraService/src/CameraService.cpp
 #include "CameraService.h"
 #include <QThread>
+#include <QDateTime>
+#include <QDir>
 #include <QDebug>
 
+// 两次参数下发的最小间隔：拖动数值框时最多每秒下发 20 次
+static constexpr auto kParamWriteInterval = std::chrono::milliseconds(50);
+
 CameraService::CameraService(ICamera* camera, QObject* parent)
-    : QObject(parent), m_camera(camera), m_isWorking(false) {
+    : QObject(parent), m_camera(camera), m_isWorking(false), m_roiFollower(camera), m_roiFollowEnabled(false),
+    m_paramQueue(kParamWriteInterval), m_paramTimer(new QTimer(this)), m_previewSubscriberId(0),
+    m_previewMailbox(std::make_shared<LatestFrameMailbox>()),
+    m_eventSubscriberId(0), m_ringFound(false),
+    m_analysisSubscriberId(0), m_analysisMailbox(std::make_shared<LatestFrameMailbox>()),
+    m_received(0), m_incomplete(0), m_sequenceGaps(0), m_lastLatencyMs(0.0), m_lastExposureLatencyMs(0.0), m_lastFrameNumber(0) {
+    m_paramTimer->setSingleShot(true);
+    connect(m_paramTimer, &QTimer::timeout, this, [this]() { flushParams(); });
+
+    // 预览只要最新一帧：UI 跟不上时挤掉旧帧，格式转换在预览自己的交付线程上做
+    FrameSubscription preview;
+    preview.name = "preview";
+    preview.depth = 1;
+    preview.policy = BackpressurePolicy::DROP_OLDEST;
+    m_previewSubscriberId = m_frameBus.subscribe(preview, [this](const Frame& frame) { deliverPreview(frame); });
+
+    // 断线与重连由驱动自己完成，这里只负责上报 (回调在驱动线程上，emit 会自动排队到接收者线程)
+    if (m_camera) {
+        m_camera->registerDeviceEventCallback([this](DeviceEvent event, double outageMs) {
+            QString msg;
+            switch (event) {
+            case DeviceEvent::DISCONNECTED:
+                qDebug() << "[CameraService] 相机断开，正在自动重连";
+                msg = "Camera disconnected, reconnecting...";
+                break;
+            case DeviceEvent::RECONNECTED:
+                qDebug() << "[CameraService] 相机已重连，中断" << outageMs << "ms";
+                msg = QString("Camera reconnected after %1 ms.").arg(outageMs, 0, 'f', 0);
+                break;
+            case DeviceEvent::RECONNECT_FAILED:
+                qDebug() << "[CameraService] 相机重连失败，已放弃";
+                msg = "Camera reconnect failed. Please check the cable and restart acquisition.";
+                break;
+            }
+            emit serviceMessage(msg);
+            emit connectionStateChanged(event == DeviceEvent::RECONNECTED, msg);
+            });
+    }
 }
 
 CameraService::~CameraService() {
+    if (m_camera) m_camera->registerDeviceEventCallback(nullptr);
+    disableRingAnalysis();
+    disableEventCapture();
+    m_frameBus.unsubscribeAll(); // 交付线程里还会 emit，先于 QObject 析构停掉
     stopWorkLoop();
 }
 
@@ -17,11 +63,14 @@ void CameraService::startWorkLoop() {
     // ====================================================
     // 依赖注入的核心：把带有 Qt 信号的 Lambda 塞给纯 C++ 的底层！
     // ====================================================
-    m_camera->registerFrameCallback([this](const cv::Mat& frame) {
+    m_camera->registerFrameCallback([this](const Frame& frame) {
         // 这个 Lambda 实际是在海康的底层线程中被触发的
-        // 但放心，Qt 的 emit 非常聪明，它发现跨线程时，会自动变成队列投递 (QueuedConnection)
-        // 绝对不会卡死或者搞崩 UI 线程！
-        emit frameReadyToShow(frame);
+        // 残帧在这里就地丢弃，不让它去消耗 UI 线程的转换与绘制
+        if (!acceptFrame(frame)) return;
+        if (m_frameObserver) m_frameObserver(frame);
+
+        // 只入队：预览、分析、录像各自在自己的线程上消费，回调线程马上就能去接下一帧
+        m_frameBus.publish(frame);
         });
 
     // 告诉底层：开始取流吧，有图了就调我上面那个 Lambda
@@ -32,22 +81,399 @@ void CameraService::startWorkLoop() {
 
 void CameraService::stopWorkLoop() {
     m_isWorking = false;
+    // 在服务所在线程上停流，与本线程上的其它驱动调用串行；相机已关闭时驱动直接返回
+    if (m_camera) m_camera->stopStream();
+}
+
+// ==========================================
+// 帧流健康度：帧号断层 = 丢帧，丢包 = 残帧
+// ==========================================
+bool CameraService::acceptFrame(const Frame& frame) {
+    m_received++;
+
+    // 帧号回退说明相机重新开始了取流，重新计数即可
+    if (m_lastFrameNumber != 0 && frame.frameNumber > m_lastFrameNumber + 1) {
+        m_sequenceGaps += frame.frameNumber - m_lastFrameNumber - 1;
+    }
+    m_lastFrameNumber = frame.frameNumber;
+
+    // HikCamera 在采集线程上已提前丢弃残帧，这里为其他相机 (回放、仿真) 兜底
+    if (!frame.isComplete()) {
+        m_incomplete++;
+        return false;
+    }
+    return !frame.empty();
+}
+
+void CameraService::setFrameObserver(FrameCallback observer) {
+    m_frameObserver = observer;
+}
+
+// ==========================================
+// 帧总线：每个订阅者自己的队列与节拍，没轮到的帧连引用计数都不加
+// ==========================================
+int CameraService::addFrameSubscriber(const FrameSubscription& subscription, FrameCallback callback) {
+    return m_frameBus.subscribe(subscription, std::move(callback));
+}
+
+int CameraService::addFrameSubscriber(double targetFps, FrameCallback callback) {
+    FrameSubscription subscription;
+    subscription.targetFps = targetFps;
+    return m_frameBus.subscribe(subscription, std::move(callback));
+}
+
+void CameraService::removeFrameSubscriber(int id) {
+    if (id == m_previewSubscriberId) return; // 预览由服务自己管理
+    m_frameBus.unsubscribe(id);
+}
+
+void CameraService::setSubscriberFrameRate(int id, double targetFps) {
+    m_frameBus.setTargetFps(id, targetFps);
+}
+
+FrameBusSubscriberStats CameraService::getSubscriberStats(int id) const {
+    return m_frameBus.getStats(id);
+}
+
+std::vector<FrameBusSubscriberStats> CameraService::getFrameBusStats() const {
+    return m_frameBus.getAllStats();
+}
+
+void CameraService::setPreviewFrameRate(double fps) {
+    m_frameBus.setTargetFps(m_previewSubscriberId, fps);
+}
+
+FrameBusSubscriberStats CameraService::getPreviewStats() const {
+    return m_frameBus.getStats(m_previewSubscriberId);
+}
+
+std::shared_ptr<LatestFrameMailbox> CameraService::previewMailbox() const {
+    return m_previewMailbox;
+}
+
+MailboxStats CameraService::getPreviewMailboxStats() const {
+    return m_previewMailbox->getStats();
+}
+
+void CameraService::deliverPreview(const Frame& frame) {
+    // 帧以传感器原始格式到达，界面只认黑白或 RGB：按需转换一次，结果缓存在帧上
+    // 图放进信箱而不是塞进信号：UI 线程忙 (缩放窗口、存图) 时旧帧被覆盖，事件队列不会越积越多
+    // 只有信箱由空变满才发通知，跨线程时 Qt 自动排队投递，队列里最多只有一个
+    if (m_previewMailbox->post(frame.toFormat(displayFormatOf(frame.pixelFormat)))) {
+        emit previewFrameAvailable();
+    }
+    m_lastLatencyMs = frame.ageMs();
+    m_lastExposureLatencyMs = frame.exposureAgeMs();
+}
+
+RoiFollowStats CameraService::getRoiFollowStats() const {
+    return m_roiFollower.getStats();
+}
+
+FrameFlowStats CameraService::getFrameFlowStats() const {
+    FrameFlowStats stats;
+    stats.received = m_received;
+    // 驱动在采集线程上就地丢弃的残帧到不了 acceptFrame，只在帧号上留下断层：把它们从断层挪回残帧
+    uint64_t droppedByCamera = m_camera ? m_camera->getDispatchStats().incomplete : 0;
+    stats.incomplete = m_incomplete + droppedByCamera;
+    stats.sequenceGaps = (m_sequenceGaps > droppedByCamera) ? m_sequenceGaps - droppedByCamera : 0;
+    stats.lastLatencyMs = m_lastLatencyMs;
+    stats.lastExposureLatencyMs = m_lastExposureLatencyMs;
+    return stats;
 }
 
 // ==========================================
-// 接收 UI 指令，并转发给底层硬件执行
+// 接收 UI 指令：先合并，再按节拍转发给底层硬件执行
+// 数值框每动一步就来一个新值，逐个下发会让相机线程堵在 SDK 的同步往返上
 // ==========================================
 void CameraService::setExposureTime(double timeUs) {
-    if (m_camera) {
+    m_paramQueue.post(CameraParam::EXPOSURE_TIME, timeUs);
+    scheduleParamFlush();
+}
+
+void CameraService::setGain(double gain) {
+    m_paramQueue.post(CameraParam::GAIN, gain);
+    scheduleParamFlush();
+}
+
+void CameraService::setAcquisitionFrameRate(double fps) {
+    m_paramQueue.post(CameraParam::FRAME_RATE, fps);
+    scheduleParamFlush();
+}
+
+void CameraService::scheduleParamFlush() {
+    if (m_paramTimer->isActive()) return; // 已经安排过，新值会在那时一起下发
+
+    auto wait = m_paramQueue.timeUntilDue(std::chrono::steady_clock::now());
+    if (wait.count() == 0) {
+        flushParams(); // 空闲时第一下立即生效，手感不打折扣
+    }
+    else {
+        m_paramTimer->start(static_cast<int>(wait.count()));
+    }
+}
+
+void CameraService::flushParams() {
+    if (!m_camera) return;
+
+    for (const ParamCommand& command : m_paramQueue.take(std::chrono::steady_clock::now())) {
         // 强转为 float，因为 ICamera 接口定义的是 float
-        m_camera->setExposureTime(static_cast<float>(timeUs));
-        qDebug() << "[CameraService] 已命令硬件修改曝光时间:" << timeUs << "us";
+        float value = static_cast<float>(command.value);
+        CameraStatus status = CameraStatus::SUCCESS;
+        switch (command.param) {
+        case CameraParam::EXPOSURE_TIME:
+            status = m_camera->setExposureTime(value);
+            if (status != CameraStatus::SUCCESS) emit serviceMessage("Failed to set exposure time.");
+            break;
+        case CameraParam::GAIN:
+            status = m_camera->setGain(value);
+            if (status != CameraStatus::SUCCESS) emit serviceMessage("Failed to set gain.");
+            break;
+        case CameraParam::FRAME_RATE:
+            status = m_camera->setFrameRate(command.value);
+            if (status != CameraStatus::SUCCESS) emit serviceMessage("Failed to set acquisition frame rate.");
+            break;
+        default:
+            break;
+        }
+
+        // 又有新值排队时，界面上的数字已经走到前面去了，不再回显这个中间值；回显读的是参数快照，不额外访问设备
+        if (m_paramQueue.hasPending(command.param)) continue;
+        if (command.param == CameraParam::EXPOSURE_TIME) {
+            double applied = m_camera->getParams().exposureTime.current;
+            qDebug() << "[CameraService] 已命令硬件修改曝光时间:" << command.value << "us, 实际:" << applied << "us";
+            emit exposureTimeApplied(command.value, applied);
+        }
+        else if (command.param == CameraParam::GAIN) {
+            double applied = m_camera->getParams().gain.current;
+            qDebug() << "[CameraService] 已命令硬件修改增益:" << command.value << ", 实际:" << applied;
+            emit gainApplied(command.value, applied);
+        }
+        else if (status == CameraStatus::SUCCESS) {
+            qDebug() << "[CameraService] 已命令硬件修改采集帧率:" << command.value << "fps, 实际:" << m_camera->getParams().frameRate.current << "fps";
+        }
+    }
+
+    // 下发期间又来了新值 (直接调用时可能发生)：排到下一个周期
+    for (int i = 0; i < static_cast<int>(CameraParam::COUNT); i++) {
+        if (m_paramQueue.hasPending(static_cast<CameraParam>(i))) {
+            scheduleParamFlush();
+            break;
+        }
     }
 }
 
-void CameraService::setGain(double gain) {
-    if (m_camera) {
-        m_camera->setGain(static_cast<float>(gain));
-        qDebug() << "[CameraService] 已命令硬件修改增益:" << gain;
+ParamQueueStats CameraService::getParamQueueStats() const {
+    return m_paramQueue.getStats();
+}
+
+// ==========================================
+// 传感器读出区域：只平移时取流不中断，改尺寸/合并/抽样时由驱动决定是否短暂停流
+// ==========================================
+void CameraService::setRoi(int offsetX, int offsetY, int width, int height) {
+    if (!m_camera) return;
+
+    if (m_camera->setRoi(SensorRoi{ offsetX, offsetY, width, height }) != CameraStatus::SUCCESS) {
+        emit serviceMessage("Failed to set sensor ROI.");
+        return;
     }
-}
\ No newline at end of file
+    SensorRoi roi = m_camera->getRoi();
+    qDebug() << "[CameraService] ROI:" << roi.offsetX << roi.offsetY << roi.width << "x" << roi.height;
+}
+
+void CameraService::setBinning(int factor) {
+    if (m_camera && m_camera->setBinning(factor) != CameraStatus::SUCCESS) {
+        emit serviceMessage("Sensor does not support the requested binning.");
+    }
+}
+
+void CameraService::setDecimation(int factor) {
+    if (m_camera && m_camera->setDecimation(factor) != CameraStatus::SUCCESS) {
+        emit serviceMessage("Sensor does not support the requested decimation.");
+    }
+}
+
+void CameraService::setRoiFollowEnabled(bool enabled) {
+    m_roiFollowEnabled = enabled;
+    if (!enabled) m_roiFollower.reset();
+    qDebug() << "[CameraService] ROI 跟随:" << (enabled ? "开启" : "关闭");
+}
+
+void CameraService::reportRingDetection(double centerX, double centerY, double radius, bool found) {
+    // 目标丢失是最值得回看的时刻：事件前那几秒的原始帧正好说明它是怎么丢的
+    if (m_ringFound && !found) captureEvent("ring lost");
+    m_ringFound = found;
+
+    if (!m_roiFollowEnabled) return;
+    m_roiFollower.update(found, cv::Point2f(static_cast<float>(centerX), static_cast<float>(centerY)), static_cast<float>(radius));
+}
+
+// ==========================================
+// 事件录制：内存里的“黑匣子”，事件发生时把前后一段落盘
+// ==========================================
+void CameraService::enableEventCapture(const PreTriggerConfig& config, const QString& directory) {
+    disableEventCapture();
+
+    QDir dir;
+    if (!dir.exists(directory)) {
+        dir.mkpath(directory);
+    }
+    m_eventDirectory = directory;
+    m_eventRecorder = std::make_unique<PreTriggerRecorder>(config);
+
+    // 写盘结束的回调在录制器线程上，emit 会自动排队到接收者线程
+    m_eventRecorder->setFlushCallback([this](const std::string& path, uint64_t frames, bool ok) {
+        QString file = QString::fromStdString(path);
+        qDebug() << "[CameraService] 事件录制写盘" << (ok ? "完成:" : "失败:") << file << frames << "帧";
+        emit serviceMessage(ok ? QString("Event saved: %1 (%2 frames).").arg(file).arg(frames)
+            : QString("Failed to save event: %1.").arg(file));
+        emit eventCaptured(file, frames, ok);
+        });
+
+    // push() 本身不阻塞，队列满挤掉最旧的即可；录制器内部还有自己的交接队列
+    FrameSubscription subscription;
+    subscription.name = "event-capture";
+    subscription.depth = 4;
+    PreTriggerRecorder* recorder = m_eventRecorder.get();
+    m_eventSubscriberId = addFrameSubscriber(subscription, [recorder](const Frame& frame) { recorder->push(frame); });
+    qDebug() << "[CameraService] 事件录制已开启:" << directory << "缓冲" << (config.capacityBytes >> 20) << "MB";
+}
+
+void CameraService::disableEventCapture() {
+    if (!m_eventRecorder) return;
+
+    // 先退订 (返回后回调不会再被调用)，再析构录制器 (等已触发的事件写完)
+    removeFrameSubscriber(m_eventSubscriberId);
+    m_eventSubscriberId = 0;
+    m_eventRecorder.reset();
+}
+
+void CameraService::captureEvent(const QString& reason) {
+    if (!m_eventRecorder) return;
+
+    QString fileName = m_eventDirectory + "/EVT_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz") + ".ocvraw";
+    if (!m_eventRecorder->trigger(fileName.toStdString())) {
+        qDebug() << "[CameraService] 事件录制缓冲为空，忽略事件:" << reason;
+        return;
+    }
+    qDebug() << "[CameraService] 事件触发:" << reason << "->" << fileName;
+}
+
+PreTriggerStats CameraService::getEventCaptureStats() const {
+    return m_eventRecorder ? m_eventRecorder->getStats() : PreTriggerStats{};
+}
+
+// ==========================================
+// 实时分析：帧总线 -> 处理流水线 -> 回到 Service 线程
+// ==========================================
+void CameraService::enableRingAnalysis(const RingDetectorConfig& config, double targetFps) {
+    disableRingAnalysis();
+
+    m_analysisPipeline = std::make_unique<ProcessingPipeline>();
+    m_analysisPipeline->addStages(PipelineStages::ringDetection(config));
+    m_analysisPipeline->start([this](const PipelineItem& item) { publishAnalysis(item); });
+
+    // 流水线入口满了会自己丢新帧，总线这一级只需很浅的队列
+    FrameSubscription subscription;
+    subscription.name = "ring-analysis";
+    subscription.depth = 2;
+    subscription.targetFps = targetFps;
+    ProcessingPipeline* pipeline = m_analysisPipeline.get();
+    m_analysisSubscriberId = addFrameSubscriber(subscription, [pipeline](const Frame& frame) { pipeline->push(frame); });
+    qDebug() << "[CameraService] 实时负压环分析已开启，阶段数:" << m_analysisPipeline->getStats().stages.size();
+}
+
+void CameraService::enableParallelRingAnalysis(const ParallelAnalyzerConfig& parallel, const RingDetectorConfig& config, double targetFps) {
+    disableRingAnalysis();
+
+    // 分析任务跑在共享调度器上，每个并发任务借用一套自己的阶段 (各自的 CLAHE 对象)
+    m_parallelAnalyzer = std::make_unique<ParallelAnalyzer>([config]() { return PipelineStages::ringDetection(config); }, parallel);
+    m_parallelAnalyzer->start([this](const PipelineItem& item) { publishAnalysis(item); });
+
+    // 重排窗口满了会自己丢新帧，总线这一级只需很浅的队列
+    FrameSubscription subscription;
+    subscription.name = "ring-analysis";
+    subscription.depth = 2;
+    subscription.targetFps = targetFps;
+    ParallelAnalyzer* analyzer = m_parallelAnalyzer.get();
+    m_analysisSubscriberId = addFrameSubscriber(subscription, [analyzer](const Frame& frame) { analyzer->push(frame); });
+    ParallelAnalyzerStats stats = m_parallelAnalyzer->getStats();
+    qDebug() << "[CameraService] 帧级并行负压环分析已开启，并行度:" << stats.workers << "重排窗口:" << stats.reorderWindow
+        << (parallel.dropLate ? "迟到丢弃" : "严格按序");
+}
+
+void CameraService::disableRingAnalysis() {
+    if (!m_analysisPipeline && !m_parallelAnalyzer) return;
+
+    // 先退订 (不再有人 push)，再停分析线程
+    removeFrameSubscriber(m_analysisSubscriberId);
+    m_analysisSubscriberId = 0;
+    if (m_analysisPipeline) m_analysisPipeline->stop();
+    if (m_parallelAnalyzer) m_parallelAnalyzer->stop();
+    m_analysisPipeline.reset();
+    m_parallelAnalyzer.reset();
+}
+
+void CameraService::publishAnalysis(const PipelineItem& item) {
+    if (m_analysisMailbox->post(item.annotated)) emit analysisFrameAvailable();
+
+    const RingDetection& detection = item.detection;
+    cv::Point2f center = item.frame.toSensor(detection.center);
+    double radius = detection.radius * item.frame.pixelStep;
+    qulonglong frameNumber = item.frame.frameNumber;
+    QMetaObject::invokeMethod(this, [this, detection, center, radius, frameNumber]() {
+        reportRingDetection(center.x, center.y, radius, detection.found);
+        emit ringAnalyzed(detection.found, center.x, center.y, radius, frameNumber);
+        }, Qt::QueuedConnection);
+}
+
+PipelineStats CameraService::getAnalysisStats() const {
+    return m_analysisPipeline ? m_analysisPipeline->getStats() : PipelineStats{};
+}
+
+ParallelAnalyzerStats CameraService::getParallelAnalysisStats() const {
+    return m_parallelAnalyzer ? m_parallelAnalyzer->getStats() : ParallelAnalyzerStats{};
+}
+
+std::shared_ptr<LatestFrameMailbox> CameraService::analysisMailbox() const {
+    return m_analysisMailbox;
+}
+
+// ==========================================
+// 取流策略：同一台相机按场景切换
+// ==========================================
+void CameraService::usePreviewStrategy() {
+    setGrabStrategy(GrabStrategy::LATEST_IMAGES_ONLY);
+}
+
+void CameraService::useRecordingStrategy() {
+    setGrabStrategy(GrabStrategy::ONE_BY_ONE);
+}
+
+void CameraService::setGrabStrategy(GrabStrategy strategy, unsigned int queueSize) {
+    if (!m_camera) return;
+
+    if (m_camera->setGrabStrategy(strategy, queueSize) == CameraStatus::SUCCESS) {
+        qDebug() << "[CameraService] 取流策略已切换为:" << static_cast<int>(strategy) << "队列深度:" << queueSize;
+    }
+    else {
+        emit serviceMessage("Failed to switch grab strategy.");
+    }
+}
+
+// ==========================================
+// 输出格式：优先传感器直出，做不到再由主机转换
+// ==========================================
+void CameraService::setOutputFormat(PixelFormat format) {
+    if (!m_camera) return;
+
+    if (m_camera->setOutputFormat(format) != CameraStatus::SUCCESS) {
+        emit serviceMessage("Sensor cannot deliver the requested pixel format.");
+        return;
+    }
+
+    FormatNegotiation negotiation = m_camera->getFormatNegotiation();
+    qDebug() << "[CameraService] 输出格式:" << static_cast<int>(format)
+        << "传感器格式:" << static_cast<int>(negotiation.sensor)
+        << (negotiation.sensor == format ? "(传感器直出)" : "(主机转换)");
+}
@@ -0,0 +1,213 @@
+﻿// Service/CameraService/src/ParallelAnalyzer.cpp
+#include "ParallelAnalyzer.h"
+#include <algorithm>
+
+ParallelAnalyzer::ParallelAnalyzer(StageFactory factory, const ParallelAnalyzerConfig& config, TaskScheduler& scheduler)
+    : m_factory(std::move(factory)),
+    m_config(config),
+    m_scheduler(scheduler),
+    m_running(false),
+    m_emitting(false),
+    m_activeTasks(0),
+    m_nextSeq(0),
+    m_totalAnalyzeMs(0.0) {
+    if (m_config.workers == 0) m_config.workers = std::max<size_t>(m_scheduler.workerCount(), 1);
+    m_config.reorderWindow = std::max(m_config.reorderWindow, m_config.workers);
+    m_stats.workers = m_config.workers;
+    m_stats.reorderWindow = m_config.reorderWindow;
+}
+
+ParallelAnalyzer::~ParallelAnalyzer() {
+    stop();
+}
+
+// ==========================================
+// 1. 启停
+// ==========================================
+bool ParallelAnalyzer::start(PipelineResultCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return false;
+
+    m_callback = std::move(callback);
+    if (m_chains.empty()) {
+        for (size_t i = 0; i < m_config.workers; i++) {
+            m_chains.push_back(m_factory());
+            m_freeChains.push_back(i);
+        }
+    }
+    m_running = true;
+    return true;
+}
+
+void ParallelAnalyzer::stop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running) return;
+    m_running = false;
+    m_tasks.clear(); // 积压的帧直接丢弃，池化缓冲随之归还
+
+    // 调度器上的任务引用着 this：等它们 (正在分析的那几帧) 全部结束
+    m_idleCond.wait(lock, [this] { return m_activeTasks == 0; });
+    m_window.clear();
+}
+
+bool ParallelAnalyzer::isRunning() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+// ==========================================
+// 2. 入口：永不阻塞，窗口满了就丢新帧
+// ==========================================
+bool ParallelAnalyzer::push(const Frame& frame) {
+    PipelineItem item;
+    item.frame = frame;
+    item.image = frame.toFormat(displayFormatOf(frame.pixelFormat)); // 与预览共享转换缓存，通常不必再转一次
+
+    bool submit = false;
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return false;
+        m_stats.pushed++;
+        // 迟到判定也在这里做一次：队首卡住、其余任务都已结束时，靠新帧到来推动跳过
+        skipLateLocked(std::chrono::steady_clock::now());
+
+        if (item.image.empty() || m_window.size() >= m_config.reorderWindow) {
+            m_stats.entryDropped++;
+        }
+        else {
+            const uint64_t seq = m_nextSeq++;
+            m_window[seq];   // 先占住顺序，结果回来再填
+            m_tasks.push_back({ seq, std::move(item) });
+            accepted = true;
+        }
+        submit = scheduleLocked();
+    }
+    if (submit) m_scheduler.submit(m_config.priority, [this] { runTask(); });
+    return accepted;
+}
+
+bool ParallelAnalyzer::scheduleLocked() {
+    // 有帧要分析，或者队首已经可以交出 (跳过迟到帧之后)，而在途任务还没到并行度上限
+    bool headReady = !m_window.empty() && m_window.begin()->second.state != Slot::State::PENDING;
+    if ((m_tasks.empty() && !headReady) || m_activeTasks >= m_config.workers) return false;
+    m_activeTasks++;
+    return true;
+}
+
+// ==========================================
+// 3. 调度器上的任务：借一套阶段，对整帧跑完整条链
+// ==========================================
+void ParallelAnalyzer::runTask() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_running && !m_tasks.empty() && !m_freeChains.empty()) {
+        Task task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        const size_t chain = m_freeChains.back();
+        m_freeChains.pop_back();
+        lock.unlock();
+
+        auto begin = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (PipelineStage& stage : m_chains[chain]) {
+            ok = stage.process(task.item);
+            if (!ok) break;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        lock.lock();
+        m_freeChains.push_back(chain);
+        if (m_running) completeLocked(task.seq, task.item, ok, ms);
+    }
+    if (m_running) emitReadyLocked(lock);
+
+    // 还有帧排队就接力提交下一个任务 (名额原样转交)，而不是在这里循环：调度器可以在两帧之间插进更高优先级的任务
+    bool relay = m_running && !m_tasks.empty();
+    if (!relay && --m_activeTasks == 0) m_idleCond.notify_all(); // 持锁通知：stop() 一返回 this 就可能析构
+    lock.unlock();
+
+    if (relay) m_scheduler.submit(m_config.priority, [this] { runTask(); });
+}
+
+// ==========================================
+// 4. 重排：结果先放回自己的位置，队首齐了才按序交出
+// ==========================================
+void ParallelAnalyzer::completeLocked(uint64_t seq, PipelineItem& item, bool ok, double analyzeMs) {
+    m_stats.analyzed++;
+    m_stats.lastAnalyzeMs = analyzeMs;
+    m_stats.maxAnalyzeMs = std::max(m_stats.maxAnalyzeMs, analyzeMs);
+    m_totalAnalyzeMs += analyzeMs;
+
+    auto now = std::chrono::steady_clock::now();
+    auto it = m_window.find(seq);
+    if (it != m_window.end()) {
+        // 不在窗口里说明已被当作迟到跳过：结果作废 (跳过时已计入 lateDropped)
+        Slot& slot = it->second;
+        slot.state = ok ? Slot::State::DONE : Slot::State::REJECTED;
+        slot.item = std::move(item);
+        slot.doneAt = now;
+    }
+    item = PipelineItem(); // 作废的结果也尽快归还帧缓冲
+
+    size_t pending = 0;
+    for (const auto& entry : m_window) pending += entry.second.state != Slot::State::PENDING ? 1 : 0;
+    m_stats.peakReorderPending = std::max(m_stats.peakReorderPending, pending);
+
+    skipLateLocked(now);
+}
+
+void ParallelAnalyzer::skipLateLocked(std::chrono::steady_clock::time_point now) {
+    if (!m_config.dropLate) return;
+
+    // 队首还没完成，而它后面最早完成的那一帧已经等够了 maxWait：跳过队首
+    while (!m_window.empty() && m_window.begin()->second.state == Slot::State::PENDING) {
+        bool overdue = false;
+        for (const auto& entry : m_window) {
+            if (entry.second.state != Slot::State::PENDING && now - entry.second.doneAt >= m_config.maxWait) {
+                overdue = true;
+                break;
+            }
+        }
+        if (!overdue) return;
+        m_window.erase(m_window.begin());
+        m_stats.lateDropped++;
+    }
+}
+
+void ParallelAnalyzer::emitReadyLocked(std::unique_lock<std::mutex>& lock) {
+    // 同一时刻只有一个任务在交出：其余任务放下结果就走，由它顺带交出，回调因此严格按序、不会并发
+    if (m_emitting) return;
+    m_emitting = true;
+
+    while (m_running && !m_window.empty() && m_window.begin()->second.state != Slot::State::PENDING) {
+        Slot slot = std::move(m_window.begin()->second);
+        m_window.erase(m_window.begin());
+        if (slot.state == Slot::State::REJECTED) {
+            m_stats.rejected++;
+            continue;
+        }
+
+        double waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - slot.doneAt).count();
+        m_stats.maxReorderWaitMs = std::max(m_stats.maxReorderWaitMs, waitedMs);
+        m_stats.lastLatencyMs = slot.item.frame.ageMs();
+        m_stats.emitted++;
+
+        lock.unlock();
+        if (m_callback) m_callback(slot.item);
+        slot = Slot(); // 尽快归还帧缓冲
+        lock.lock();
+    }
+    m_emitting = false;
+}
+
+// ==========================================
+// 5. 统计
+// ==========================================
+ParallelAnalyzerStats ParallelAnalyzer::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ParallelAnalyzerStats stats = m_stats;
+    stats.inFlight = m_window.size();
+    for (const auto& entry : m_window) stats.reorderPending += entry.second.state != Slot::State::PENDING ? 1 : 0;
+    stats.avgAnalyzeMs = stats.analyzed > 0 ? m_totalAnalyzeMs / static_cast<double>(stats.analyzed) : 0.0;
+    return stats;
+}
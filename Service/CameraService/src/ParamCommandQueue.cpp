@@ -0,0 +1,57 @@
+﻿// Service/CameraService/src/ParamCommandQueue.cpp
+#include "ParamCommandQueue.h"
+
+ParamCommandQueue::ParamCommandQueue(std::chrono::milliseconds minInterval)
+    : m_minInterval(minInterval), m_hasApplied(false) {
+}
+
+bool ParamCommandQueue::post(CameraParam param, double value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool wasEmpty = true;
+    for (const std::optional<double>& pending : m_pending) {
+        if (pending) wasEmpty = false;
+    }
+
+    std::optional<double>& slot = m_pending[static_cast<size_t>(param)];
+    if (slot) m_stats.coalesced++;
+    slot = value;
+    m_stats.posted++;
+    return wasEmpty;
+}
+
+std::chrono::milliseconds ParamCommandQueue::timeUntilDue(std::chrono::steady_clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasApplied) return std::chrono::milliseconds(0);
+
+    auto due = m_lastApply + m_minInterval;
+    if (now >= due) return std::chrono::milliseconds(0);
+    // 向上取整，定时器不会在到期之前醒来
+    return std::chrono::ceil<std::chrono::milliseconds>(due - now);
+}
+
+std::vector<ParamCommand> ParamCommandQueue::take(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<ParamCommand> commands;
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        if (!m_pending[i]) continue;
+        commands.push_back(ParamCommand{ static_cast<CameraParam>(i), *m_pending[i] });
+        m_pending[i].reset();
+    }
+
+    if (!commands.empty()) {
+        m_lastApply = now;
+        m_hasApplied = true;
+        m_stats.applied += commands.size();
+    }
+    return commands;
+}
+
+bool ParamCommandQueue::hasPending(CameraParam param) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending[static_cast<size_t>(param)].has_value();
+}
+
+ParamQueueStats ParamCommandQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
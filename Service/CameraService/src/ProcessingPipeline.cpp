@@ -0,0 +1,229 @@
+﻿// Service/CameraService/src/ProcessingPipeline.cpp
+#include "ProcessingPipeline.h"
+#include <algorithm>
+
+// ==========================================
+// 1. 负压环检测的各个阶段
+// ==========================================
+namespace PipelineStages {
+    PipelineStage resize(int targetWidth) {
+        return { "resize", [targetWidth](PipelineItem& item) {
+            cv::Mat resized;
+            item.scale *= RingDetector::resize(item.image, resized, targetWidth);
+            item.image = resized;
+            return true;
+        } };
+    }
+
+    PipelineStage gray() {
+        return { "gray", [](PipelineItem& item) {
+            cv::Mat gray;
+            RingDetector::toGray(item.image, gray, cv::COLOR_RGB2GRAY); // 入口是显示格式：RGB 或黑白
+            item.image = gray;
+            return true;
+        } };
+    }
+
+    PipelineStage clahe(double clipLimit, int tileSize) {
+        // CLAHE 对象只在本阶段的线程上使用，创建一次反复用
+        RingDetectorConfig config;
+        config.claheClipLimit = clipLimit;
+        config.claheTileSize = tileSize;
+        cv::Ptr<cv::CLAHE> clahe = RingDetector::createClahe(config);
+        return { "clahe", [clahe](PipelineItem& item) {
+            cv::Mat enhanced;
+            RingDetector::enhanceContrast(item.image, enhanced, *clahe);
+            item.image = enhanced;
+            return true;
+        } };
+    }
+
+    PipelineStage median(int ksize) {
+        return { "median", [ksize](PipelineItem& item) {
+            cv::Mat smoothed;
+            RingDetector::smooth(item.image, smoothed, ksize);
+            item.image = smoothed;
+            return true;
+        } };
+    }
+
+    PipelineStage detectRing(const RingDetectorConfig& config) {
+        return { "detect", [config](PipelineItem& item) {
+            item.detection = RingDetector::findConcentric(item.image, item.scale, config);
+            return true;
+        } };
+    }
+
+    PipelineStage annotate() {
+        return { "annotate", [](PipelineItem& item) {
+            // 在源帧分辨率上标注；黑白图先转成 RGB，标注颜色才看得见
+            cv::Mat display = item.frame.toFormat(displayFormatOf(item.frame.pixelFormat));
+            if (display.channels() == 1) cv::cvtColor(display, item.annotated, cv::COLOR_GRAY2RGB);
+            else item.annotated = display.clone(); // 转换缓存与预览共享，不能直接在上面画
+            RingDetector::annotate(item.annotated, item.detection, true);
+            return true;
+        } };
+    }
+
+    std::vector<PipelineStage> ringDetection(const RingDetectorConfig& config) {
+        return {
+            resize(config.targetWidth),
+            gray(),
+            clahe(config.claheClipLimit, config.claheTileSize),
+            median(config.medianKsize),
+            detectRing(config),
+            annotate()
+        };
+    }
+}
+
+// ==========================================
+// 2. 组装与启停
+// ==========================================
+ProcessingPipeline::ProcessingPipeline(size_t queueDepth)
+    : m_queueDepth(queueDepth == 0 ? 1 : queueDepth),
+    m_running(false),
+    m_pushed(0),
+    m_entryDropped(0),
+    m_completed(0),
+    m_lastLatencyMs(0.0) {
+}
+
+ProcessingPipeline::~ProcessingPipeline() {
+    stop();
+}
+
+void ProcessingPipeline::addStage(PipelineStage stage) {
+    if (m_running) return;
+    m_stages.push_back(std::make_unique<StageRuntime>(std::move(stage), m_queueDepth));
+}
+
+void ProcessingPipeline::addStages(const std::vector<PipelineStage>& stages) {
+    for (const PipelineStage& stage : stages) addStage(stage);
+}
+
+bool ProcessingPipeline::start(PipelineResultCallback callback) {
+    if (m_running || m_stages.empty()) return false;
+
+    m_callback = std::move(callback);
+    m_running = true;
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        m_stages[i]->thread = std::thread(&ProcessingPipeline::stageLoop, this, i);
+    }
+    return true;
+}
+
+void ProcessingPipeline::stop() {
+    if (!m_running.exchange(false)) return;
+
+    for (auto& stage : m_stages) stage->input.wake();
+    for (auto& stage : m_stages) {
+        if (stage->thread.joinable()) stage->thread.join();
+    }
+
+    // 线程都退出了，此时本线程是各队列唯一的使用者：把积压的工件清掉，池化缓冲随之归还
+    PipelineItem item;
+    for (auto& stage : m_stages) {
+        while (stage->input.tryPop(item)) {}
+    }
+}
+
+bool ProcessingPipeline::isRunning() const {
+    return m_running;
+}
+
+// ==========================================
+// 3. 入口：永不阻塞，满了就丢新帧
+// ==========================================
+bool ProcessingPipeline::push(const Frame& frame) {
+    if (!m_running) return false;
+    m_pushed++;
+
+    PipelineItem item;
+    item.frame = frame;
+    item.image = frame.toFormat(displayFormatOf(frame.pixelFormat)); // 与预览共享转换缓存，通常不必再转一次
+    if (item.image.empty() || !m_stages.front()->input.tryPush(item)) {
+        m_entryDropped++;
+        return false;
+    }
+    return true;
+}
+
+// ==========================================
+// 4. 各阶段线程：取一件、做一件、交给下一级
+// ==========================================
+void ProcessingPipeline::stageLoop(size_t index) {
+    StageRuntime& self = *m_stages[index];
+    StageRuntime* next = index + 1 < m_stages.size() ? m_stages[index + 1].get() : nullptr;
+
+    PipelineItem item;
+    while (true) {
+        // 先记门铃再检查：检查之后到达的工件一定会按响门铃，不会睡过头
+        uint32_t bell = self.input.pushBell();
+        if (!m_running) return;
+        if (!self.input.tryPop(item)) {
+            self.input.waitForPush(bell);
+            continue;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        bool ok = self.stage.process(item);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        // 统计只由本线程写
+        uint64_t processed = self.processed.load() + 1;
+        self.processed = processed;
+        self.totalMs = self.totalMs.load() + ms;
+        self.lastMs = ms;
+        if (ms > self.maxMs.load()) self.maxMs = ms;
+
+        if (!ok) {
+            self.rejected++;
+            continue;
+        }
+
+        if (next) {
+            if (!handOff(*next, item)) return;
+            continue;
+        }
+
+        m_lastLatencyMs = item.frame.ageMs();
+        m_completed++;
+        if (m_callback) m_callback(item);
+        item = PipelineItem(); // 尽快归还帧缓冲
+    }
+}
+
+bool ProcessingPipeline::handOff(StageRuntime& next, PipelineItem& item) {
+    while (true) {
+        uint32_t bell = next.input.popBell();
+        if (!m_running) return false;
+        if (next.input.tryPush(item)) return true;
+        next.input.waitForPop(bell); // 下游满了：等它取走一件
+    }
+}
+
+// ==========================================
+// 5. 统计
+// ==========================================
+PipelineStats ProcessingPipeline::getStats() const {
+    PipelineStats stats;
+    stats.pushed = m_pushed;
+    stats.entryDropped = m_entryDropped;
+    stats.completed = m_completed;
+    stats.lastLatencyMs = m_lastLatencyMs;
+
+    for (const auto& stage : m_stages) {
+        PipelineStageStats s;
+        s.name = stage->stage.name;
+        s.queueDepth = stage->input.size();
+        s.queueCapacity = stage->input.capacity();
+        s.processed = stage->processed;
+        s.rejected = stage->rejected;
+        s.lastMs = stage->lastMs;
+        s.maxMs = stage->maxMs;
+        s.avgMs = s.processed > 0 ? stage->totalMs / static_cast<double>(s.processed) : 0.0;
+        stats.stages.push_back(s);
+    }
+    return stats;
+}
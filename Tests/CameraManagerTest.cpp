@@ -0,0 +1,237 @@
+﻿// ===================================================================
+// CameraManager 测试：同时驱动多台模拟相机
+// 验证全部枚举/按序列号打开、后台异步打开、每台相机独立线程取流、分机与汇总帧率统计、触发同步组帧、断线上报与恢复、按订阅者抽稀帧率、预览信箱
+// ===================================================================
+#include "CameraManager.h"
+#include "SimulatedCamera.h"
+#include "TestSupport.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <iostream>
+#include <atomic>
+#include <set>
+#include <thread>
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    std::cout << "========================================" << std::endl;
+    std::cout << " CameraManager 测试 [Multi Camera]      " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    SimulatedCameraConfig config;
+    config.width = 320;
+    config.height = 240;
+    config.format = PixelFormat::MONO8;
+    config.frameRate = 50.0;
+    config.deviceCount = 3;
+    CameraFactory factory = [config]() -> ICamera* { return new SimulatedCamera(config); };
+
+    // 1. 缺省打开枚举到的全部设备
+    {
+        CameraManager manager(factory);
+        check(manager.openAll() == 3, "打开枚举到的全部 3 台相机");
+
+        std::set<std::string> serials;
+        for (int i = 0; i < manager.cameraCount(); i++) serials.insert(manager.serialNumber(i));
+        check(serials.size() == 3 && serials.count("SIM00003") == 1, "每台相机序列号不同");
+
+        manager.startAll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        manager.sampleStats(); // 预热阶段不计入
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        CameraManagerStats stats = manager.sampleStats();
+
+        bool allRunning = stats.cameras.size() == 3;
+        for (const CameraRuntimeStats& camera : stats.cameras) {
+            std::cout << "       " << camera.serialNumber << " fps " << camera.fps << " 丢帧 " << camera.dropped << std::endl;
+            allRunning = allRunning && camera.fps > 40.0 && camera.fps < 60.0;
+        }
+        std::cout << "       合计 fps " << stats.totalFps << std::endl;
+        check(allRunning, "每台相机都以约 50 fps 并行取流");
+        check(stats.totalFps > 120.0 && stats.totalFps < 180.0, "汇总帧率约为 3 x 50");
+        check(stats.totalDropped == 0, "没有丢帧");
+
+        manager.closeAll();
+        check(manager.cameraCount() == 0, "closeAll 后全部释放");
+    }
+
+    // 2. 按序列号打开：不存在的设备被跳过
+    {
+        CameraManager manager(factory);
+        check(manager.openAll({ "SIM00002", "NOT_EXIST" }) == 1, "只打开存在的指定相机");
+        check(manager.serialNumber(0) == "SIM00002", "打开的是指定序列号");
+    }
+
+    // 3. 触发同步：软触发与模拟硬触发下，每次触发恰好拼出一组完整的 FrameSet
+    {
+        CameraManager manager(factory);
+        manager.openAll();
+        check(manager.setTriggerMode(TriggerMode::SOFTWARE) == CameraStatus::SUCCESS, "全部相机切到软触发");
+
+        std::atomic<int> completeSets{ 0 };
+        std::atomic<bool> idsMatch{ true };
+        manager.enableSynchronization(SyncConfig(), [&](const FrameSet& set) {
+            if (!set.complete) return;
+            for (const Frame& frame : set.frames) {
+                if (frame.triggerId != set.triggerId) idsMatch = false;
+            }
+            completeSets++;
+            });
+        manager.startAll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200)); // 等各线程开始取流
+
+        int triggered = 0;
+        for (int i = 0; i < 20; i++) {
+            triggered += manager.triggerAll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        check(triggered == 60, "软触发全部下发成功");
+        check(completeSets == 20 && idsMatch, "20 次软触发拼出 20 组完整的帧");
+
+        check(manager.setTriggerMode(TriggerMode::HARDWARE, 1) == CameraStatus::SUCCESS, "全部相机切到 Line1 硬触发");
+        for (int i = 0; i < 10; i++) {
+            SimulatedCamera::pulseLine(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        check(completeSets == 30, "10 个硬触发脉冲拼出 10 组完整的帧");
+
+        // 第三台相机漏掉一次触发：超时后记为残组，并记在它的名下
+        manager.setTriggerMode(TriggerMode::SOFTWARE);
+        manager.camera(0)->triggerSoftware();
+        manager.camera(1)->triggerSoftware();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        manager.closeAll(); // 停流时结算挂起的组
+
+        SyncStats stats = manager.getSyncStats();
+        std::cout << "       完整 " << stats.completeSets << " 组，残组 " << stats.incompleteSets << " 组，最大组内时差 " << stats.maxSkewMs << " ms" << std::endl;
+        check(stats.incompleteSets == 1 && stats.missingByCamera[2] == 1, "残组被统计并定位到漏触发的相机");
+    }
+
+    // 4. 后台打开：立即返回，完成后在管理器线程上报告台数
+    {
+        CameraManager manager(factory);
+        int finished = -1;
+        QObject::connect(&manager, &CameraManager::openFinished, [&](int opened) { finished = opened; });
+
+        manager.openAllAsync();
+        check(finished == -1 && manager.cameraCount() == 0, "openAllAsync 立即返回，不阻塞调用线程");
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (finished == -1 && std::chrono::steady_clock::now() < deadline) {
+            QCoreApplication::processEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        check(finished == 3 && manager.cameraCount() == 3 && manager.service(2) != nullptr, "后台打开完成后报告 3 台并装配好服务");
+        check(manager.camera(0)->getParams().gain.available, "参数快照已随打开读好");
+
+        // 打开过程中直接关闭：等后台结束并把打开的相机一并释放
+        CameraManager closing(factory);
+        closing.openAllAsync();
+        closing.closeAll();
+        check(closing.cameraCount() == 0, "打开中途 closeAll 不泄漏相机");
+    }
+
+    // 5. 断线：服务把断开与恢复报告出来，恢复后继续出图
+    {
+        CameraManager manager(factory);
+        manager.openAll({ "SIM00001" });
+        QStringList messages;
+        std::vector<bool> states;
+        // 回调来自驱动线程，带上下文对象让 Qt 把信号排队到本线程
+        QObject::connect(manager.service(0), &CameraService::serviceMessage, &manager, [&](const QString& msg) { messages << msg; });
+        QObject::connect(manager.service(0), &CameraService::connectionStateChanged, &manager, [&](bool connected, const QString&) { states.push_back(connected); });
+        manager.startAll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        SimulatedCamera* sim = static_cast<SimulatedCamera*>(manager.camera(0));
+        sim->simulateDisconnect(std::chrono::milliseconds(300));
+        check(!sim->isConnected(), "模拟断线后相机报告离线");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint64_t receivedDuringOutage = manager.service(0)->getFrameFlowStats().received;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        check(manager.service(0)->getFrameFlowStats().received == receivedDuringOutage, "断线期间没有帧");
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (states.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+            QCoreApplication::processEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        check(states.size() == 2 && !states[0] && states[1], "先报告断开，再报告恢复");
+        check(messages.size() >= 2 && messages.last().startsWith("Camera reconnected"), "恢复通过 serviceMessage 上报");
+
+        uint64_t receivedAfter = manager.service(0)->getFrameFlowStats().received;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        check(manager.service(0)->getFrameFlowStats().received > receivedAfter + 5 && sim->isConnected(), "恢复后继续出图");
+        manager.closeAll();
+    }
+
+    // 6. 各取所需：采集 60 fps，预览 30 fps、分析每帧、归档 1 fps
+    {
+        CameraManager manager(factory);
+        manager.openAll({ "SIM00001" });
+        CameraService* service = manager.service(0);
+
+        service->setAcquisitionFrameRate(60.0); // 配置是 50 fps；队列空闲时立即下发
+        check(manager.camera(0)->getParams().frameRate.current == 60.0, "采集帧率经服务下发到相机");
+
+        std::atomic<int> analysis{ 0 }, archive{ 0 };
+        std::atomic<bool> rawFormat{ true };
+        int analysisId = service->addFrameSubscriber(0.0, [&](const Frame&) { analysis++; });
+        int archiveId = service->addFrameSubscriber(1.0, [&](const Frame& frame) {
+            archive++;
+            if (frame.pixelFormat != PixelFormat::MONO8) rawFormat = false;
+            });
+        service->setPreviewFrameRate(30.0);
+
+        manager.startAll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2050));
+
+        FrameBusSubscriberStats preview = service->getPreviewStats();
+        std::cout << "       分析 " << analysis << " 帧，归档 " << archive << " 帧，预览 " << preview.passed << " 帧" << std::endl;
+        check(analysis > 100 && analysis < 140, "不限帧率的订阅者拿到每一帧 (约 60 fps)");
+        check(archive >= 2 && archive <= 3 && rawFormat, "1 fps 的订阅者约每秒一帧，且是传感器原始格式");
+        check(preview.passed > 50 && preview.passed < 70 && preview.skipped > 50, "预览约 30 fps，其余帧没有做显示转换");
+        check(service->getSubscriberStats(archiveId).skipped > 100, "归档订阅者跳过的帧被计数");
+
+        service->removeFrameSubscriber(analysisId);
+        int analysisAfterRemove = analysis;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        check(analysis == analysisAfterRemove, "退订后不再收到帧");
+        manager.closeAll();
+    }
+
+    // 7. 预览信箱：界面线程卡住期间通知不堆积，恢复后直接拿到最新一帧
+    {
+        CameraManager manager(factory);
+        manager.openAll({ "SIM00001" });
+        CameraService* service = manager.service(0);
+        std::shared_ptr<LatestFrameMailbox> mailbox = service->previewMailbox();
+
+        int notifications = 0;
+        cv::Mat shown;
+        QObject::connect(service, &CameraService::previewFrameAvailable, &manager, [&]() {
+            notifications++;
+            mailbox->take(shown);
+            });
+        manager.startAll();
+
+        // 本线程 500 ms 不处理事件，相当于界面忙着重绘或存图
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        MailboxStats busy = service->getPreviewMailboxStats();
+        QCoreApplication::processEvents();
+        std::cout << "       卡住期间放入 " << busy.posted << " 帧，覆盖 " << busy.overwritten << " 帧" << std::endl;
+        check(notifications == 1 && !shown.empty(), "卡住期间只积压了一个通知，恢复后取到一帧");
+        check(busy.posted > 15 && busy.overwritten == busy.posted - 1, "来不及显示的帧被覆盖并计数");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        QCoreApplication::processEvents();
+        check(notifications == 2 && service->getPreviewMailboxStats().taken == 2, "之后每次取到的都是信箱里的最新一帧");
+        manager.closeAll();
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+﻿// ===================================================================
+// ClockCorrelator 测试：用已知的设备时钟与随机的传输延迟构造样本
+// 验证时钟频率拟合、下包络换算精度、调度卡顿的离群样本、设备时钟重置后重新拟合，以及模拟相机的曝光时刻
+// ===================================================================
+#include "ClockCorrelator.h"
+#include "SimulatedCamera.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <random>
+#include <cmath>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double diffUs(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::micro>(a - b).count();
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " ClockCorrelator 测试 [Clock Sync]      " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // 设备时钟：标称 1 GHz，比主机快 80 ppm，起点任意
+    const double ticksPerSecond = 1e9 * (1.0 + 80e-6);
+    const uint64_t tickOrigin = 123456789000ull;
+    const Clock::time_point hostOrigin = Clock::now();
+    auto deviceTicksAt = [&](double seconds) { return tickOrigin + static_cast<uint64_t>(seconds * ticksPerSecond); };
+    auto hostAt = [&](double seconds) {
+        return hostOrigin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    };
+
+    // 到达延迟 = 固定 2ms 读出传输 + 指数分布的排队抖动 (均值 300us)，偶尔调度卡顿 20ms
+    std::mt19937 rng(7);
+    std::exponential_distribution<double> jitter(1.0 / 300e-6);
+    const double fixedLatency = 2e-3;
+
+    ClockCorrelator correlator;
+    check(!correlator.isLocked() && correlator.toHost(tickOrigin) == Clock::time_point{}, "没有样本时不给出换算结果");
+
+    // 1. 100 fps 采 5 秒
+    double maxErrorUs = 0.0;
+    for (int i = 0; i < 500; i++) {
+        double exposure = i * 0.01;
+        double delay = fixedLatency + jitter(rng) + (i % 97 == 50 ? 20e-3 : 0.0);
+        correlator.addSample(deviceTicksAt(exposure), hostAt(exposure + delay));
+        if (i >= 200) {
+            // 换算结果应接近“曝光时刻 + 固定延迟”：排队抖动被下包络扣掉
+            double errorUs = std::abs(diffUs(correlator.toHost(deviceTicksAt(exposure)), hostAt(exposure + fixedLatency)));
+            maxErrorUs = std::max(maxErrorUs, errorUs);
+        }
+    }
+    ClockCorrelationStats stats = correlator.getStats();
+    std::cout << "       频率 " << stats.ticksPerSecond << " Hz，抖动 RMS " << stats.residualRmsUs << " us，最大换算误差 " << maxErrorUs << " us" << std::endl;
+    check(stats.locked, "样本足够后锁定");
+    check(std::abs(stats.ticksPerSecond / ticksPerSecond - 1.0) < 5e-6, "拟合出设备时钟频率 (含 80 ppm 频差)");
+    check(maxErrorUs < 100.0, "换算误差远小于排队抖动");
+    check(stats.rejected >= 3, "调度卡顿的迟到样本不参与拟合");
+
+    // 2. 设备时钟被重置 (重新上电)：作废旧拟合，重新锁定
+    Frame frame;
+    frame.deviceTimestamp = 1000;
+    frame.hostArrival = hostAt(6.0);
+    correlator.correlate(frame);
+    check(!correlator.isLocked() && correlator.getStats().resyncs == 1 && !frame.hasHostExposure(), "设备时钟回退后重新拟合");
+    for (int i = 1; i < 100; i++) {
+        frame.deviceTimestamp = 1000 + static_cast<uint64_t>(i * 0.01 * ticksPerSecond);
+        frame.hostArrival = hostAt(6.0 + i * 0.01);
+        correlator.correlate(frame);
+    }
+    check(correlator.isLocked() && frame.hasHostExposure() && frame.hostExposure <= frame.hostArrival, "重新锁定后帧带上曝光时刻");
+
+    // 3. 模拟相机：设备时间戳是曝光结束时刻，换算后应落在到达时刻之前不远
+    {
+        SimulatedCameraConfig config;
+        config.width = 320;
+        config.height = 240;
+        config.format = PixelFormat::MONO8;
+        config.frameRate = 100.0;
+        SimulatedCamera camera(config);
+        camera.openDevice();
+        camera.startStream();
+
+        Frame grabbed;
+        bool ordered = true;
+        for (int i = 0; i < 60 && camera.grabFrame(grabbed, 500); i++) {
+            if (grabbed.hasHostExposure() && grabbed.hostExposure > grabbed.hostArrival) ordered = false;
+        }
+        camera.closeDevice();
+
+        double leadMs = std::chrono::duration<double, std::milli>(grabbed.hostArrival - grabbed.hostExposure).count();
+        std::cout << "       模拟相机: 曝光到到达 " << leadMs << " ms" << std::endl;
+        check(camera.getClockStats().locked && grabbed.hasHostExposure(), "模拟相机的时钟拟合已锁定");
+        check(ordered && leadMs >= 0.0 && leadMs < 5.0, "曝光时刻早于到达时刻，且相差不超过渲染耗时");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+﻿// ===================================================================
+// FrameBus 测试：用手工构造的帧驱动多订阅者分发
+// 验证零拷贝共享、三种背压策略、慢订阅者 (含 BLOCK) 不拖累发布方与其他订阅者、按帧率抽稀、退订
+// ===================================================================
+#include "FrameBus.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    FrameSubscription makeSubscription(const char* name, size_t depth, BackpressurePolicy policy) {
+        FrameSubscription subscription;
+        subscription.name = name;
+        subscription.depth = depth;
+        subscription.policy = policy;
+        return subscription;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " FrameBus 测试 [Backpressure]          " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // 1. 零拷贝：两个订阅者拿到的是同一块像素
+    {
+        FrameBus bus;
+        std::mutex mutex;
+        std::vector<const uchar*> seen;
+        auto record = [&](const Frame& frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.push_back(frame.image().data);
+        };
+        bus.subscribe(makeSubscription("a", 2, BackpressurePolicy::DROP_OLDEST), record);
+        bus.subscribe(makeSubscription("b", 2, BackpressurePolicy::DROP_OLDEST), record);
+
+        Frame frame = makeTestFrame(1);
+        bus.publish(frame);
+        bool both = waitFor([&] { std::lock_guard<std::mutex> lock(mutex); return seen.size() == 2; });
+        check(both && seen[0] == frame.image().data && seen[1] == frame.image().data, "所有订阅者共享同一份像素，不拷贝");
+    }
+
+    // 2. 慢订阅者只让自己丢帧：发布方不等它，快订阅者一帧不少
+    {
+        FrameBus bus;
+        std::atomic<bool> release{ false };
+        std::atomic<int> fast{ 0 };
+        std::mutex mutex;
+        std::vector<uint64_t> oldest, newest;
+
+        int fastId = bus.subscribe(makeSubscription("fast", 64, BackpressurePolicy::DROP_OLDEST), [&](const Frame&) { fast++; });
+        // 慢订阅者卡在第 0 帧上，队列随后被填满
+        int oldestId = bus.subscribe(makeSubscription("drop-oldest", 3, BackpressurePolicy::DROP_OLDEST), [&](const Frame& frame) {
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard<std::mutex> lock(mutex);
+            oldest.push_back(frame.frameNumber);
+            });
+        int newestId = bus.subscribe(makeSubscription("drop-newest", 3, BackpressurePolicy::DROP_NEWEST), [&](const Frame& frame) {
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard<std::mutex> lock(mutex);
+            newest.push_back(frame.frameNumber);
+            });
+
+        bus.publish(makeTestFrame(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 让慢订阅者先取走第 0 帧
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 1; i <= 20; i++) bus.publish(makeTestFrame(i));
+        double publishMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        check(publishMs < 10.0, "慢订阅者卡住时发布方不受影响");
+        check(waitFor([&] { return fast == 21; }), "快订阅者拿到全部 21 帧");
+
+        FrameBusSubscriberStats oldestStats = bus.getStats(oldestId);
+        FrameBusSubscriberStats newestStats = bus.getStats(newestId);
+        check(oldestStats.queueDepth == 3 && oldestStats.droppedOldest == 17, "DROP_OLDEST：队列保持满，挤掉 17 帧旧帧");
+        check(newestStats.queueDepth == 3 && newestStats.droppedNewest == 17, "DROP_NEWEST：队列保持满，拒收 17 帧新帧");
+
+        release = true;
+        waitFor([&] { std::lock_guard<std::mutex> lock(mutex); return oldest.size() == 4 && newest.size() == 4; });
+        check(oldest == std::vector<uint64_t>({ 0, 18, 19, 20 }), "DROP_OLDEST 留下的是最新的帧");
+        check(newest == std::vector<uint64_t>({ 0, 1, 2, 3 }), "DROP_NEWEST 留下的是最早的连续帧");
+        check(bus.getStats(fastId).dropped() == 0 && bus.getStats(fastId).delivered == 21, "快订阅者没有丢帧");
+    }
+
+    // 3. BLOCK：消费者稍慢时发布方等一等，一帧不丢；消费者卡死时等满超时才丢
+    {
+        FrameBus bus;
+        std::atomic<int> received{ 0 };
+        std::atomic<bool> stuck{ false };
+        FrameSubscription subscription = makeSubscription("recorder", 2, BackpressurePolicy::BLOCK);
+        subscription.blockTimeout = std::chrono::milliseconds(50);
+        int id = bus.subscribe(subscription, [&](const Frame&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            while (stuck) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            received++;
+            });
+
+        for (uint64_t i = 0; i < 20; i++) bus.publish(makeTestFrame(i));
+        check(waitFor([&] { return received == 20; }), "消费者稍慢：20 帧全部交付");
+        FrameBusSubscriberStats stats = bus.getStats(id);
+        check(stats.dropped() == 0 && stats.blockedMs > 0.0, "发布方等待过，但没有丢帧");
+
+        stuck = true;
+        bus.publish(makeTestFrame(100)); // 被交付线程取走并卡住
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        bus.publish(makeTestFrame(101));
+        bus.publish(makeTestFrame(102)); // 队列满 (容量 2)
+        auto begin = std::chrono::steady_clock::now();
+        bus.publish(makeTestFrame(103));
+        double waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        check(waitedMs >= 45.0 && waitedMs < 200.0 && bus.getStats(id).blockTimeouts == 1, "消费者卡死：等满超时后丢帧并计数");
+        stuck = false;
+    }
+
+    // 3.1 BLOCK 订阅者卡住、发布方在等它时：其他订阅者照常按时收到同一帧，订阅与统计也不被挡住
+    {
+        FrameBus bus;
+        std::atomic<bool> stuck{ true };
+        FrameSubscription subscription = makeSubscription("recorder", 1, BackpressurePolicy::BLOCK);
+        subscription.blockTimeout = std::chrono::milliseconds(300);
+        int blockId = bus.subscribe(subscription, [&](const Frame&) {
+            while (stuck) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            });
+        std::atomic<uint64_t> previewLast{ 0 };
+        std::atomic<int64_t> previewAtMs{ -1 };
+        auto begin = std::chrono::steady_clock::now();
+        bus.subscribe(makeSubscription("preview", 2, BackpressurePolicy::DROP_OLDEST), [&](const Frame& frame) {
+            previewLast = frame.frameNumber;
+            if (frame.frameNumber == 3) {
+                previewAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+            }
+            });
+
+        bus.publish(makeTestFrame(1));                                  // 被 BLOCK 的交付线程取走并卡住
+        waitFor([&] { return bus.getStats(blockId).queueDepth == 0 && previewLast == 1; });
+        bus.publish(makeTestFrame(2));                                  // BLOCK 队列满 (容量 1)
+
+        begin = std::chrono::steady_clock::now();
+        std::thread publisher([&] { bus.publish(makeTestFrame(3)); }); // 在 BLOCK 订阅者上等满 300 ms
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+        auto statsBegin = std::chrono::steady_clock::now();
+        bus.getAllStats();
+        int lateId = bus.subscribe(makeSubscription("late", 2, BackpressurePolicy::DROP_OLDEST), [](const Frame&) {});
+        bus.unsubscribe(lateId);
+        double statsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - statsBegin).count();
+
+        check(waitFor([&] { return previewLast == 3; }, 100) && previewAtMs >= 0 && previewAtMs < 100,
+            "BLOCK 订阅者卡住时，另一个订阅者仍按时收到新帧");
+        check(statsMs < 50.0, "发布方等待期间，统计、订阅与退订不被总线锁挡住");
+
+        publisher.join();
+        check(bus.getStats(blockId).blockTimeouts == 1, "BLOCK 订阅者自己等满超时后丢帧");
+        stuck = false;
+    }
+
+    // 4. 抽稀与退订
+    {
+        FrameBus bus;
+        std::atomic<int> received{ 0 };
+        FrameSubscription subscription = makeSubscription("archive", 16, BackpressurePolicy::DROP_OLDEST);
+        subscription.targetFps = 10.0;
+        int id = bus.subscribe(subscription, [&](const Frame&) { received++; });
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; i++) {
+            Frame frame = makeTestFrame(i);
+            frame.hostArrival = start + std::chrono::milliseconds(10 * i); // 100 fps 的到达时刻
+            bus.publish(frame);
+        }
+        waitFor([&] { return bus.getStats(id).queueDepth == 0; });
+        FrameBusSubscriberStats stats = bus.getStats(id);
+        check(stats.passed == 10 && stats.skipped == 90 && stats.dropped() == 0, "100 fps 抽稀到 10 fps，跳过的帧不算丢帧");
+
+        bus.unsubscribe(id);
+        int before = received;
+        bus.publish(makeTestFrame(1000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        check(received == before && bus.getAllStats().empty(), "退订后不再收到帧");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
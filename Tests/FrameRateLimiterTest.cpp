@@ -0,0 +1,86 @@
+﻿// ===================================================================
+// FrameRateLimiter 测试：用手工构造的到达时刻驱动抽稀逻辑
+// 验证整数倍抽稀、非整数比的平均帧率、到达抖动、源头停顿后重新对齐、运行中改目标帧率
+// ===================================================================
+#include "FrameRateLimiter.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // 以 sourceFps 连续送入 count 帧 (可加固定模式的抖动)，返回放行的帧下标
+    std::vector<int> run(FrameRateLimiter& limiter, Clock::time_point& t, double sourceFps, int count, int jitterUs = 0) {
+        std::vector<int> passed;
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / sourceFps));
+        for (int i = 0; i < count; i++) {
+            auto jitter = std::chrono::microseconds((i % 3 - 1) * jitterUs);
+            if (limiter.accept(t + jitter)) passed.push_back(i);
+            t += period;
+        }
+        return passed;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " FrameRateLimiter 测试 [Decimation]     " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // 1. 不限帧率：每帧都放行
+    {
+        FrameRateLimiter limiter;
+        Clock::time_point t = Clock::now();
+        check(run(limiter, t, 60.0, 60).size() == 60, "目标帧率为 0 时每帧都放行");
+    }
+
+    // 2. 60 -> 30：带 ±2ms 抖动也严格隔一帧放一帧
+    {
+        FrameRateLimiter limiter(30.0);
+        Clock::time_point t = Clock::now();
+        std::vector<int> passed = run(limiter, t, 60.0, 120, 2000);
+        bool alternate = passed.size() == 60;
+        for (size_t i = 1; i < passed.size(); i++) alternate = alternate && passed[i] - passed[i - 1] == 2;
+        check(alternate, "60 -> 30 fps 隔一帧放一帧，不被到达抖动打乱");
+        FrameRateLimiterStats stats = limiter.getStats();
+        check(stats.passed == 60 && stats.skipped == 60, "放行与跳过分别计数");
+    }
+
+    // 3. 非整数比：60 -> 25、60 -> 1，长期平均帧率等于目标
+    {
+        FrameRateLimiter limiter(25.0);
+        Clock::time_point t = Clock::now();
+        size_t passed = run(limiter, t, 60.0, 600).size(); // 10 秒
+        std::cout << "       60 -> 25 fps: 10 秒放行 " << passed << " 帧" << std::endl;
+        check(passed >= 249 && passed <= 251, "60 -> 25 fps 平均帧率准确");
+
+        FrameRateLimiter archive(1.0);
+        t = Clock::now();
+        passed = run(archive, t, 60.0, 600).size();
+        check(passed == 10, "60 -> 1 fps 每秒一帧");
+    }
+
+    // 4. 源头停顿 2 秒后恢复：重新对齐，不补发一串突发帧
+    {
+        FrameRateLimiter limiter(10.0);
+        Clock::time_point t = Clock::now();
+        run(limiter, t, 100.0, 100);
+        t += std::chrono::seconds(2);
+        std::vector<int> passed = run(limiter, t, 100.0, 100);
+        check(passed.size() == 10 && passed[0] == 0 && passed[1] == 10, "停顿后立即放行一帧，之后按节拍");
+    }
+
+    // 5. 运行中调高目标帧率：不必等旧周期排好的时刻
+    {
+        FrameRateLimiter limiter(0.5);
+        Clock::time_point t = Clock::now();
+        run(limiter, t, 50.0, 10);
+        limiter.setTargetFps(25.0);
+        std::vector<int> passed = run(limiter, t, 50.0, 50);
+        check(passed.size() == 25 && passed[0] == 0, "调高帧率后立即按新节拍放行");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+﻿// ===================================================================
+// FrameSynchronizer 测试：用手工构造的帧驱动组帧逻辑
+// 验证按触发号组帧、乱序到达、残组超时与统计、迟到帧、时间窗组帧
+// ===================================================================
+#include "FrameSynchronizer.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 组帧只看触发号与到达时刻
+    Frame triggeredFrame(uint64_t triggerId, std::chrono::steady_clock::time_point arrival) {
+        Frame frame = makeTestFrame(0);
+        frame.triggerId = triggerId;
+        frame.hostArrival = arrival;
+        return frame;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " FrameSynchronizer 测试 [Frame Sets]    " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    auto now = std::chrono::steady_clock::now();
+
+    // 1. 按触发号组帧：三台相机乱序到达，凑齐后只交付一次
+    {
+        SyncConfig config;
+        config.timeout = std::chrono::milliseconds(50);
+        config.deliverIncomplete = true;
+        FrameSynchronizer sync(3, config);
+
+        std::vector<FrameSet> sets;
+        sync.setCallback([&](const FrameSet& set) { sets.push_back(set); });
+
+        sync.push(0, triggeredFrame(1, now));
+        sync.push(1, triggeredFrame(2, now));
+        sync.push(2, triggeredFrame(1, now + std::chrono::milliseconds(2)));
+        sync.push(0, triggeredFrame(2, now));
+        check(sets.empty(), "没凑齐之前不交付");
+        sync.push(1, triggeredFrame(1, now + std::chrono::milliseconds(1)));
+        check(sets.size() == 1 && sets[0].triggerId == 1 && sets[0].complete && sets[0].missingCount() == 0, "触发 1 凑齐后交付一次");
+        check(sets.size() == 1 && sets[0].skewMs > 1.9 && sets[0].skewMs < 2.1, "组内时差为最早与最晚到达之差");
+
+        sync.push(1, triggeredFrame(1, now));
+        check(sync.getStats().pendingSets == 2, "已交付组的重复帧会另起一组");
+
+        sync.push(1, triggeredFrame(2, now));
+        check(sync.getStats().duplicateFrames == 1, "同组同相机的重复帧被计数并丢弃");
+
+        // 2. 相机 2 漏掉触发 2：超时后按残组结算
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        sync.push(0, triggeredFrame(3, now));
+        SyncStats stats = sync.getStats();
+        check(stats.incompleteSets == 2 && stats.missingByCamera[2] == 2, "超时残组被统计到缺席的相机上");
+        check(sets.size() == 3 && !sets[1].complete && sets[1].frames[2].empty(), "残组按配置交付，缺失位置为空帧");
+
+        sync.push(2, triggeredFrame(2, now));
+        check(sync.getStats().lateFrames == 1, "残组结算后才到达的帧记为迟到");
+
+        sync.flush();
+        check(sync.getStats().pendingSets == 0 && sync.getStats().incompleteSets == 3, "flush 结算所有挂起的组");
+        check(sets.back().setId == 4, "交付序号连续");
+    }
+
+    // 3. 时间窗组帧：没有触发号时按到达时刻拼组
+    {
+        SyncConfig config;
+        config.policy = SyncPolicy::TIMESTAMP_WINDOW;
+        config.window = std::chrono::microseconds(3000);
+        FrameSynchronizer sync(2, config);
+
+        int complete = 0;
+        sync.setCallback([&](const FrameSet& set) { complete += set.complete ? 1 : 0; });
+
+        sync.push(0, triggeredFrame(0, now));
+        sync.push(1, triggeredFrame(0, now + std::chrono::milliseconds(10))); // 超出窗口：另起一组
+        sync.push(1, triggeredFrame(0, now + std::chrono::milliseconds(1)));  // 落在第一组的窗口内
+        check(complete == 1, "窗口内的两帧拼成一组");
+        sync.push(0, triggeredFrame(0, now + std::chrono::milliseconds(11)));
+        check(complete == 2 && sync.getStats().pendingSets == 0, "第二组按各自的时间窗凑齐");
+        check(sync.getStats().maxSkewMs < 3.0, "组内时差不超过窗口");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
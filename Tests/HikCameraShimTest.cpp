@@ -0,0 +1,480 @@
+﻿// ===================================================================
+// HikCamera 取流引擎测试：用假的海康 SDK (HikSdkShim) 驱动真实的 HikCamera
+// 不需要相机、不需要驱动，验证拉取模式、grabFrame 超时、运行时模式切换、异步转换队列、触发模式、ROI、参数快照、断线重连与停流失败
+// ===================================================================
+#include "HikCamera.h"
+#include "HikSdkShim.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <stdexcept>
+
+namespace {
+    constexpr unsigned short kWidth = 640;
+    constexpr unsigned short kHeight = 480;
+
+    int g_dummyHandle = 0;
+    MV_CC_DEVICE_INFO g_deviceInfo;
+    std::vector<unsigned char> g_sensorBuffer(kWidth * kHeight, 128);
+
+    std::atomic<unsigned int> g_frameNum{ 0 };
+    std::atomic<int> g_outstandingBuffers{ 0 }; // GetImageBuffer 借出、尚未 Free 的节点数
+    std::atomic<bool> g_callbackRegistered{ false };
+    unsigned int g_imageNodeNum = 0;
+    unsigned int g_triggerModeNode = 0;   // 最近写入的 TriggerMode 节点值
+    unsigned int g_triggerSourceNode = 0; // 最近写入的 TriggerSource 节点值
+    std::atomic<int> g_softTriggers{ 0 };
+    std::atomic<int> g_startGrabbing{ 0 };
+    std::atomic<int> g_enumCalls{ 0 };
+    std::atomic<int> g_floatReads{ 0 };   // GetFloatValue 调用次数 (每次都是一个 USB 往返)
+    std::map<std::string, float> g_floatNodes = { { "ExposureTime", 5000.0f }, { "Gain", 0.0f }, { "AcquisitionFrameRate", 60.0f } };
+    std::map<std::string, bool> g_boolNodes;
+    std::map<std::string, int64_t> g_intNodes = {
+        { "Width", kWidth }, { "Height", kHeight }, { "WidthMax", kWidth }, { "HeightMax", kHeight },
+        { "OffsetX", 0 }, { "OffsetY", 0 }
+    };
+    const std::map<std::string, int64_t> kPowerOnIntNodes = g_intNodes;     // 重新上电后的节点缺省值
+    const std::map<std::string, float> kPowerOnFloatNodes = g_floatNodes;
+    std::atomic<bool> g_deviceOnline{ true };     // false：拔掉了，枚举不到也打不开
+    MvExceptionCallback g_exceptionCallback = nullptr;
+    void* g_exceptionUser = nullptr;
+    std::atomic<bool> g_failStopGrabbing{ false };
+    HikCamera* g_camera = nullptr;                // 供抓图线程里回调相机接口
+    std::atomic<bool> g_stopFromGrabThread{ false };
+    std::atomic<int> g_grabThreadStopStatus{ -1 };
+
+    // ---------------- 假 SDK 入口 ----------------
+    int __stdcall MockEnumDevices(unsigned int, MV_CC_DEVICE_INFO_LIST* pList) {
+        g_enumCalls++;
+        if (!g_deviceOnline) {
+            pList->nDeviceNum = 0;
+            return MV_OK;
+        }
+        memset(&g_deviceInfo, 0, sizeof(g_deviceInfo));
+        g_deviceInfo.nTLayerType = MV_USB_DEVICE;
+        strcpy(reinterpret_cast<char*>(g_deviceInfo.SpecialInfo.stUsb3VInfo.chSerialNumber), "MOCK0001");
+        strcpy(reinterpret_cast<char*>(g_deviceInfo.SpecialInfo.stUsb3VInfo.chModelName), "MockCam");
+        pList->nDeviceNum = 1;
+        pList->pDeviceInfo[0] = &g_deviceInfo;
+        return MV_OK;
+    }
+    int __stdcall MockCreateHandle(void** handle, const MV_CC_DEVICE_INFO*) { *handle = &g_dummyHandle; return MV_OK; }
+    int __stdcall MockHandleOnly(void*) { return MV_OK; }
+    int __stdcall MockOpenDevice(void*, unsigned int, unsigned short) { return g_deviceOnline ? MV_OK : MV_E_NODATA; }
+    int __stdcall MockRegisterExceptionCallBack(void*, MvExceptionCallback cb, void* pUser) {
+        g_exceptionCallback = cb;
+        g_exceptionUser = pUser;
+        return MV_OK;
+    }
+    int __stdcall MockRegisterImageCallBackEx(void*, MvImageCallbackEx cb, void*) {
+        g_callbackRegistered = (cb != nullptr);
+        return MV_OK;
+    }
+    int __stdcall MockSetImageNodeNum(void*, unsigned int num) { g_imageNodeNum = num; return MV_OK; }
+    int __stdcall MockStopGrabbing(void*) { return g_failStopGrabbing ? MV_E_NODATA : MV_OK; }
+    int __stdcall MockGetImageBuffer(void*, MV_FRAME_OUT* pFrame, unsigned int) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 模拟 100 fps
+        if (g_stopFromGrabThread.exchange(false)) {
+            g_grabThreadStopStatus = static_cast<int>(g_camera->stopStream()); // 在抓图线程上停流
+        }
+        pFrame->pBufAddr = g_sensorBuffer.data();
+        pFrame->stFrameInfo.nWidth = kWidth;
+        pFrame->stFrameInfo.nHeight = kHeight;
+        pFrame->stFrameInfo.enPixelType = PixelType_Gvsp_Mono8;
+        pFrame->stFrameInfo.nFrameLen = kWidth * kHeight;
+        pFrame->stFrameInfo.nFrameNum = ++g_frameNum;
+        g_outstandingBuffers++;
+        return MV_OK;
+    }
+    int __stdcall MockFreeImageBuffer(void*, MV_FRAME_OUT*) { g_outstandingBuffers--; return MV_OK; }
+    int __stdcall MockSetGrabStrategy(void*, MV_GRAB_STRATEGY) { return MV_OK; }
+    std::atomic<bool> g_failOutputQueue{ false };
+    int __stdcall MockSetOutputQueueSize(void*, unsigned int num) {
+        // 与真实 SDK 一致：输出队列不能比缓存节点还深
+        return (!g_failOutputQueue && num <= g_imageNodeNum) ? MV_OK : MV_E_PARAMETER;
+    }
+    int __stdcall MockGetEnumValue(void*, const char*, MVCC_ENUMVALUE* pValue) {
+        pValue->nCurValue = PixelType_Gvsp_Mono8;
+        pValue->nSupportedNum = 1;
+        pValue->nSupportValue[0] = PixelType_Gvsp_Mono8;
+        return MV_OK;
+    }
+    std::atomic<bool> g_failTriggerSource{ false };
+    int __stdcall MockSetEnumValue(void*, const char* key, unsigned int value) {
+        if (g_failTriggerSource && strcmp(key, "TriggerSource") == 0) return MV_E_PARAMETER;
+        if (strcmp(key, "TriggerMode") == 0) g_triggerModeNode = value;
+        if (strcmp(key, "TriggerSource") == 0) g_triggerSourceNode = value;
+        return MV_OK;
+    }
+    int __stdcall MockSetCommandValue(void*, const char* key) {
+        if (strcmp(key, "TriggerSoftware") == 0) g_softTriggers++;
+        return MV_OK;
+    }
+    int __stdcall MockGetIntValueEx(void*, const char* key, MVCC_INTVALUE_EX* pValue) {
+        auto it = g_intNodes.find(key);
+        if (it == g_intNodes.end()) return MV_E_PARAMETER;
+        bool isOffset = (it->first == "OffsetX" || it->first == "OffsetY");
+        pValue->nCurValue = it->second;
+        pValue->nMin = isOffset ? 0 : 32;
+        pValue->nInc = isOffset ? 2 : 8;
+        return MV_OK;
+    }
+    int __stdcall MockSetIntValueEx(void*, const char* key, int64_t value) {
+        g_intNodes[key] = value;
+        return MV_OK;
+    }
+    int __stdcall MockStartGrabbing(void*) {
+        if (!g_deviceOnline) return MV_E_NODATA;
+        g_startGrabbing++;
+        return MV_OK;
+    }
+    int __stdcall MockGetFloatValue(void*, const char* key, MVCC_FLOATVALUE* pValue) {
+        g_floatReads++;
+        auto it = g_floatNodes.find(key);
+        if (it == g_floatNodes.end()) return MV_E_PARAMETER;
+        pValue->fCurValue = it->second;
+        pValue->fMin = 0.0f;
+        pValue->fMax = (it->first == "Gain") ? 17.0f : 1000000.0f;
+        return MV_OK;
+    }
+    int __stdcall MockSetFloatValue(void*, const char* key, float value) {
+        // 模拟设备钳位：增益超出上限时按上限生效
+        g_floatNodes[key] = (strcmp(key, "Gain") == 0) ? std::min(value, 17.0f) : value;
+        return MV_OK;
+    }
+
+    int __stdcall MockSetBoolValue(void*, const char* key, bool value) { g_boolNodes[key] = value; return MV_OK; }
+
+    HikSdkShim makeMockSdk() {
+        HikSdkShim sdk;
+        sdk.enumDevices = &MockEnumDevices;
+        sdk.createHandle = &MockCreateHandle;
+        sdk.destroyHandle = &MockHandleOnly;
+        sdk.openDevice = &MockOpenDevice;
+        sdk.closeDevice = &MockHandleOnly;
+        sdk.startGrabbing = &MockStartGrabbing;
+        sdk.stopGrabbing = &MockStopGrabbing;
+        sdk.registerImageCallBackEx = &MockRegisterImageCallBackEx;
+        sdk.setImageNodeNum = &MockSetImageNodeNum;
+        sdk.getImageBuffer = &MockGetImageBuffer;
+        sdk.freeImageBuffer = &MockFreeImageBuffer;
+        sdk.setGrabStrategy = &MockSetGrabStrategy;
+        sdk.setOutputQueueSize = &MockSetOutputQueueSize;
+        sdk.getEnumValue = &MockGetEnumValue;
+        sdk.setEnumValue = &MockSetEnumValue;
+        sdk.getIntValueEx = &MockGetIntValueEx;
+        sdk.setCommandValue = &MockSetCommandValue;
+        sdk.setIntValueEx = &MockSetIntValueEx;
+        sdk.getFloatValue = &MockGetFloatValue;
+        sdk.setFloatValue = &MockSetFloatValue;
+        sdk.registerExceptionCallBack = &MockRegisterExceptionCallBack;
+        sdk.setBoolValue = &MockSetBoolValue;
+        return sdk;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " HikCamera 拉取模式测试 [Mock SDK Shim] " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    HikSdkShim sdk = makeMockSdk();
+    HikCamera camera(&sdk);
+    g_camera = &camera;
+
+    check(camera.enumDevices().size() == 1, "枚举到假设备");
+    check(camera.openDevice("MOCK0001") == CameraStatus::SUCCESS, "openDevice 通过序列号找到假设备");
+    check(g_enumCalls == 1, "刚枚举过，openDevice 复用缓存的枚举结果");
+
+    // 1. 拉取模式：grabFrame 必须在超时内拿到新帧
+    camera.setImageNodeNum(7);
+    check(camera.setAcquisitionMode(AcquisitionMode::PULL) == CameraStatus::SUCCESS, "切换到拉取模式");
+    check(camera.startStream() == CameraStatus::SUCCESS, "拉取模式开始取流");
+    check(g_imageNodeNum == 7, "MV_CC_SetImageNodeNum 使用配置的缓存深度");
+    check(!g_callbackRegistered, "拉取模式下不注册 SDK 回调");
+
+    cv::Mat frame;
+    check(camera.grabFrame(frame, 500), "grabFrame 在 500ms 内拿到帧");
+    check(frame.rows == kHeight && frame.cols == kWidth, "帧尺寸正确");
+
+    g_stopFromGrabThread = true;
+    auto stopDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (g_grabThreadStopStatus < 0 && std::chrono::steady_clock::now() < stopDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    check(g_grabThreadStopStatus == static_cast<int>(CameraStatus::STREAM_FAILED), "在抓图线程上停流被拒绝而不是自己 join 自己");
+    check(camera.grabFrame(frame, 500), "拒绝后取流照常进行");
+
+    // 2. 运行时切回回调模式：不需要重新打开设备
+    check(camera.setAcquisitionMode(AcquisitionMode::PUSH) == CameraStatus::SUCCESS, "取流中切换回回调模式");
+    check(g_callbackRegistered, "回调模式重新注册了 SDK 回调");
+    check(g_outstandingBuffers == 0, "抓图线程退出前归还了所有 SDK 缓存节点");
+
+    // 2.1 回调模式取流中加深输出队列：缓存节点同步加深并立即下发；SDK 拒绝时策略回到调用前
+    check(camera.setGrabStrategy(GrabStrategy::LATEST_IMAGES, 12) == CameraStatus::SUCCESS && g_imageNodeNum == 12,
+        "回调模式取流中加深输出队列时缓存节点随之下发");
+    check(g_callbackRegistered, "加深缓存后恢复取流");
+    check(camera.setGrabStrategy(GrabStrategy::ONE_BY_ONE) == CameraStatus::SUCCESS, "切回逐帧策略");
+    g_failOutputQueue = true;
+    check(camera.setGrabStrategy(GrabStrategy::LATEST_IMAGES, 2) == CameraStatus::PARAM_SET_FAILED
+        && camera.getGrabStrategy() == GrabStrategy::ONE_BY_ONE, "SDK 拒绝输出队列深度时回滚取流策略");
+    g_failOutputQueue = false;
+
+    // 3. 回调模式下没有帧到达时，grabFrame 必须按时超时返回
+    auto begin = std::chrono::steady_clock::now();
+    bool got = camera.grabFrame(frame, 50);
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    check(!got && elapsedMs < 500, "没有新帧时 grabFrame 按超时返回");
+
+    // 3.1 传感器不支持的 Bayer 格式被拒绝，输出格式保持调用前的设置 (之后的帧照常交付，见第 4 步)
+    check(camera.setOutputFormat(PixelFormat::BAYER_RG8) == CameraStatus::PARAM_SET_FAILED
+        && camera.getOutputFormat() == PixelFormat::UNKNOWN, "Bayer 协商失败后输出格式回滚");
+
+    // 4. 采集线程只投递不转换：消费者再慢，SDK 回调也必须立即返回；积压超出队列容量时挤掉旧帧
+    std::atomic<int> delivered{ 0 };
+    uint64_t deliveredBefore = camera.getDispatchStats().delivered;
+    camera.registerFrameCallback([&](const Frame&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        delivered++;
+        });
+
+    MV_FRAME_OUT_INFO_EX info;
+    memset(&info, 0, sizeof(info));
+    info.nWidth = kWidth;
+    info.nHeight = kHeight;
+    info.enPixelType = PixelType_Gvsp_Mono8;
+    info.nFrameLen = kWidth * kHeight;
+
+    begin = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < 20; i++) {
+        info.nFrameNum = 1000 + i;
+        camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    }
+    elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    check(elapsedMs < 100, "20 帧投递耗时远小于消费者处理耗时 (回调线程不被拖住)");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    DispatchStats dispatch = camera.getDispatchStats();
+    check(dispatch.dropped > 0, "队列溢出时丢弃旧帧并计数");
+    check(dispatch.delivered - deliveredBefore == static_cast<uint64_t>(delivered.load()) && delivered > 0, "交付计数与回调次数一致");
+    check(dispatch.queueDepth == 0 && dispatch.peakDepth <= dispatch.queueCapacity, "队列深度不超过容量且最终清空");
+
+    info.nFrameNum = 1100;
+    info.nLostPacket = 3;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    info.nLostPacket = 0;
+    DispatchStats afterLoss = camera.getDispatchStats();
+    check(afterLoss.incomplete == 1 && afterLoss.posted == dispatch.posted, "残帧在采集线程上就地丢弃，不进转换队列");
+
+    // 回调抛异常只丢这一帧，交付序号照常推进；帧回调里停流被拒绝而不是等待自己
+    std::atomic<int> afterThrow{ 0 };
+    std::atomic<int> stopInCallback{ -1 };
+    camera.registerFrameCallback([&](const Frame& f) {
+        if (f.frameNumber == 1200) throw std::runtime_error("consumer failure");
+        if (f.frameNumber == 1201) stopInCallback = static_cast<int>(camera.stopStream());
+        afterThrow++;
+        });
+    for (unsigned int i = 0; i < 3; i++) {
+        info.nFrameNum = 1200 + i;
+        camera.processAndTrigger(g_sensorBuffer.data(), &info);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+    check(afterThrow == 2 && camera.getDispatchStats().failed > dispatch.failed, "回调抛异常后后续帧照常交付");
+    check(stopInCallback == static_cast<int>(CameraStatus::STREAM_FAILED), "帧回调里停流被拒绝");
+
+    // 5. 触发模式：软触发下发 TriggerSoftware 命令，帧信息里的触发计数带到 Frame 上
+    check(g_triggerModeNode == MV_TRIGGER_MODE_OFF, "默认关闭触发 (连续采集)");
+    check(camera.setTriggerMode(TriggerMode::SOFTWARE) == CameraStatus::SUCCESS, "取流中切换到软触发");
+    check(g_triggerModeNode == MV_TRIGGER_MODE_ON && g_triggerSourceNode == MV_TRIGGER_SOURCE_SOFTWARE, "TriggerMode/TriggerSource 节点下发正确");
+    check(camera.triggerSoftware() == CameraStatus::SUCCESS && g_softTriggers == 1, "软触发下发 TriggerSoftware 命令");
+
+    std::atomic<uint64_t> triggerId{ 0 };
+    camera.registerFrameCallback([&](const Frame& f) { triggerId = f.triggerId; });
+    info.nFrameNum = 2000;
+    info.nTriggerIndex = 5;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(triggerId == 5, "触发计数随帧交付");
+
+    check(camera.setTriggerMode(TriggerMode::HARDWARE, 9) == CameraStatus::PARAM_SET_FAILED, "不存在的输入线被拒绝");
+    check(camera.setTriggerMode(TriggerMode::HARDWARE, 2) == CameraStatus::SUCCESS && g_triggerSourceNode == MV_TRIGGER_SOURCE_LINE2, "硬触发选择 Line2");
+    check(camera.triggerSoftware() == CameraStatus::PARAM_SET_FAILED, "硬触发模式下拒绝软触发");
+    check(camera.setTriggerMode(TriggerMode::FREE_RUN) == CameraStatus::SUCCESS && g_triggerModeNode == MV_TRIGGER_MODE_OFF, "切回连续采集");
+
+    g_failTriggerSource = true;
+    check(camera.setTriggerMode(TriggerMode::SOFTWARE) == CameraStatus::PARAM_SET_FAILED
+        && camera.getTriggerMode() == TriggerMode::FREE_RUN && g_triggerModeNode == MV_TRIGGER_MODE_OFF, "设备拒绝触发源时回滚到连续采集");
+    g_failTriggerSource = false;
+
+    // 6. ROI：改尺寸短暂停流，只平移则取流中直接生效；每帧带上自己在全幅中的位置
+    SensorGeometry geometry = camera.getSensorGeometry();
+    check(geometry.maxWidth == kWidth && geometry.widthStep == 8 && geometry.liveOffset, "读出传感器几何约束");
+
+    int startsBefore = g_startGrabbing;
+    check(camera.setRoi({ 63, 33, 317, 240 }) == CameraStatus::SUCCESS, "设置 ROI");
+    check(g_intNodes["Width"] == 320 && g_intNodes["OffsetX"] == 62 && g_intNodes["OffsetY"] == 32, "ROI 按步进对齐后下发");
+    check(g_startGrabbing == startsBefore + 1, "改变尺寸时短暂停流后恢复取流");
+
+    startsBefore = g_startGrabbing;
+    check(camera.setRoi({ 128, 64, 320, 240 }) == CameraStatus::SUCCESS && g_intNodes["OffsetX"] == 128, "平移 ROI");
+    check(g_startGrabbing == startsBefore, "只平移时不打断取流");
+
+    cv::Rect sensorRect;
+    camera.registerFrameCallback([&](const Frame& f) { sensorRect = f.sensorRect; });
+    info.nFrameNum = 2001;
+    info.nWidth = 320;
+    info.nHeight = 240;
+    info.nFrameLen = 320 * 240;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(sensorRect == cv::Rect(128, 64, 320, 240), "帧上标注了 ROI 在全幅中的位置");
+
+    // 帧回调里改尺寸：停不了流就整体拒绝，不能先把偏移归零再失败
+    std::atomic<int> roiFromCallback{ -1 };
+    camera.registerFrameCallback([&](const Frame&) { roiFromCallback = static_cast<int>(camera.setRoi({ 0, 0, 160, 120 })); });
+    info.nFrameNum = 2002;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(roiFromCallback == static_cast<int>(CameraStatus::STREAM_FAILED), "帧回调里改变 ROI 尺寸被拒绝");
+    check(g_intNodes["OffsetX"] == 128 && g_intNodes["OffsetY"] == 64 && g_intNodes["Width"] == 320 && camera.getRoi().offsetX == 128,
+        "被拒绝时 ROI 节点一个也没改");
+
+    PixelFormat formatBefore = camera.getOutputFormat();
+    PixelFormat formatTarget = formatBefore == PixelFormat::BGR8 ? PixelFormat::RGB8 : PixelFormat::BGR8;
+    std::atomic<int> formatFromCallback{ -1 };
+    camera.registerFrameCallback([&](const Frame&) { formatFromCallback = static_cast<int>(camera.setOutputFormat(formatTarget)); });
+    info.nFrameNum = 2003;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(formatFromCallback == static_cast<int>(CameraStatus::STREAM_FAILED) && camera.getOutputFormat() == formatBefore,
+        "帧回调里切换输出格式被拒绝，格式保持不变");
+    camera.registerFrameCallback(nullptr);
+
+    check(camera.setBinning(3) == CameraStatus::PARAM_SET_FAILED, "不支持的合并倍数被拒绝");
+    check(camera.setBinning(2) == CameraStatus::SUCCESS && camera.getBinning() == 2, "设置 2x2 合并");
+
+    // 7. 参数快照：一次批量读出后反复查询不再访问设备，写入只重读被写的节点
+    camera.invalidateParams();
+    int readsBefore = g_floatReads;
+    CameraParams params = camera.getParams();
+    check(params.exposureTime.current == 5000.0 && params.gain.max == 17.0 && params.width.increment == 8, "快照包含当前值、范围与步进");
+    camera.getExposureTime();
+    camera.getGain();
+    camera.getMaxGain();
+    camera.getParams();
+    check(g_floatReads == readsBefore + 3, "曝光/增益/帧率各只读一次，之后的查询都命中缓存");
+
+    readsBefore = g_floatReads;
+    check(camera.setGain(20.0f) == CameraStatus::SUCCESS && g_floatReads == readsBefore + 1, "写增益后只重读增益节点");
+    check(camera.getGain() == 17.0f && camera.getParams().revision > params.revision, "快照反映设备钳位后的实际值");
+
+    check(camera.setFrameRate(25.0) == CameraStatus::SUCCESS && g_boolNodes["AcquisitionFrameRateEnable"]
+        && camera.getParams().frameRate.current == 25.0, "设置采集帧率并打开帧率限制");
+    check(camera.setFrameRate(0.0) == CameraStatus::SUCCESS && !g_boolNodes["AcquisitionFrameRateEnable"], "帧率 0 关闭限制");
+    check(camera.setFrameRate(25.0) == CameraStatus::SUCCESS, "断线前限制帧率");
+
+    // 8. 断线重连：设备掉线后重新上电 (节点回到缺省值)，驱动自己重开并恢复断线前的状态
+    std::atomic<int> reconnected{ 0 };
+    std::atomic<bool> reportedDisconnect{ false };
+    camera.registerDeviceEventCallback([&](DeviceEvent event, double) {
+        if (event == DeviceEvent::DISCONNECTED) reportedDisconnect = true;
+        if (event == DeviceEvent::RECONNECTED) reconnected++;
+        });
+    check(camera.setExposureTime(8000.0f) == CameraStatus::SUCCESS, "断线前设置曝光");
+    check(g_exceptionCallback != nullptr, "打开设备时注册了 SDK 异常回调");
+
+    SensorRoi roiBefore = camera.getRoi();
+    std::map<std::string, int64_t> intNodesBefore = g_intNodes;
+    startsBefore = g_startGrabbing;
+
+    g_deviceOnline = false;
+    g_intNodes = kPowerOnIntNodes;
+    g_floatNodes = kPowerOnFloatNodes;
+    g_boolNodes.clear();
+    g_exceptionCallback(MV_EXCEPTION_DEV_DISCONNECT, g_exceptionUser);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    check(reportedDisconnect && !camera.isConnected(), "断线被上报");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(800)); // 设备离线期间重试会失败
+    g_deviceOnline = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (reconnected == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    check(reconnected == 1 && camera.isConnected(), "设备重新上线后自动重连");
+    check(g_floatNodes["ExposureTime"] == 8000.0f && g_floatNodes["Gain"] == 17.0f && g_floatNodes["AcquisitionFrameRate"] == 25.0f,
+        "曝光、增益与帧率恢复到断线前的值");
+    check(g_intNodes["BinningHorizontal"] == intNodesBefore["BinningHorizontal"] && g_intNodes["Width"] == intNodesBefore["Width"]
+        && g_intNodes["OffsetX"] == intNodesBefore["OffsetX"], "合并与 ROI 节点恢复到断线前的值");
+    check(camera.getRoi().width == roiBefore.width && camera.getRoi().offsetX == roiBefore.offsetX && camera.getBinning() == 2, "驱动侧的 ROI 与合并状态一致");
+    check(g_startGrabbing > startsBefore && g_callbackRegistered, "断线前在取流，重连后恢复取流");
+
+    // 8.1 断线期间上层停了流：重连只恢复设备与参数，不能把停掉的流又续上
+    g_deviceOnline = false;
+    g_exceptionCallback(MV_EXCEPTION_DEV_DISCONNECT, g_exceptionUser);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    check(!camera.isConnected(), "第二次断线被上报");
+    camera.stopStream();
+    startsBefore = g_startGrabbing;
+    g_deviceOnline = true;
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (reconnected < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    check(reconnected == 2 && camera.isConnected(), "第二次断线后自动重连");
+    check(g_startGrabbing == startsBefore && !g_callbackRegistered, "断线期间停了流，重连后保持停流");
+    check(camera.startStream() == CameraStatus::SUCCESS && g_startGrabbing == startsBefore + 1, "重连后可以手动重新取流");
+
+    // 8.2 改合并需要短暂停流重启，重启时恰好断线：这不是上层停流，重连后仍要续流
+    g_deviceOnline = false;
+    check(camera.setBinning(1) == CameraStatus::STREAM_FAILED, "断线时改合并，重启取流失败");
+    startsBefore = g_startGrabbing;
+    g_exceptionCallback(MV_EXCEPTION_DEV_DISCONNECT, g_exceptionUser);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    g_deviceOnline = true;
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (reconnected < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    check(reconnected == 3 && g_startGrabbing == startsBefore + 1 && g_callbackRegistered, "内部重启取流时断线，重连后照常续流");
+
+    // 8.3 断线时帧回调正在调用相机接口：重连线程不能持句柄锁等这个回调返回
+    std::atomic<bool> callbackDone{ false };
+    camera.registerFrameCallback([&](const Frame&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        camera.getParams();
+        callbackDone = true;
+        });
+    info.nFrameNum = 3000;
+    camera.processAndTrigger(g_sensorBuffer.data(), &info);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 回调已经开始执行
+    g_deviceOnline = false;
+    g_exceptionCallback(MV_EXCEPTION_DEV_DISCONNECT, g_exceptionUser);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    g_deviceOnline = true;
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (reconnected < 4 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    check(callbackDone && reconnected == 4 && camera.isConnected(), "帧回调里调用相机接口不会卡住重连");
+    camera.registerFrameCallback(nullptr);
+
+    // 9. SDK 停流失败：线程已全部收回，状态也必须如实变为未取流，之后还能重新开始取流
+    g_failStopGrabbing = true;
+    check(camera.stopStream() == CameraStatus::STREAM_FAILED, "SDK 停流失败如实上报");
+    g_failStopGrabbing = false;
+    startsBefore = g_startGrabbing;
+    check(camera.startStream() == CameraStatus::SUCCESS && g_startGrabbing == startsBefore + 1, "停流失败后不再误认为仍在取流");
+
+    camera.closeDevice();
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
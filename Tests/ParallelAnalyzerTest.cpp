@@ -0,0 +1,148 @@
+﻿// ===================================================================
+// ParallelAnalyzer 测试：用手工构造的帧与耗时不定的阶段驱动帧级并行分析
+// 验证乱序完成仍按帧序交出、回调不并发、并行提速、重排窗口满时入口丢帧、迟到帧被跳过
+// 用自己的 4 线程调度器，结果不随测试机的核数变化
+// ===================================================================
+#include "ParallelAnalyzer.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 只有一个阶段、耗时由帧号决定：帧号 slowFrame 的那一帧要 slowMs，其余 fastMs
+    ParallelAnalyzer::StageFactory sleepChain(int fastMs, uint64_t slowFrame, int slowMs) {
+        return [=]() {
+            return std::vector<PipelineStage>{ { "sleep", [=](PipelineItem& item) {
+                int ms = item.frame.frameNumber == slowFrame ? slowMs : fastMs;
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                return true;
+            } } };
+        };
+    }
+
+    bool strictlyIncreasing(const std::vector<uint64_t>& frameNumbers) {
+        for (size_t i = 1; i < frameNumbers.size(); i++) {
+            if (frameNumbers[i] <= frameNumbers[i - 1]) return false;
+        }
+        return true;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " ParallelAnalyzer 测试 [Reorder Buffer] " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    TaskSchedulerConfig schedulerConfig;
+    schedulerConfig.workers = 4;
+    TaskScheduler scheduler(schedulerConfig);
+
+    // 1. 耗时 5~24 ms 不等、完成顺序打乱：按帧序交出，回调从不并发，返回 false 的帧不占顺序
+    {
+        ParallelAnalyzerConfig config;
+        config.workers = 4;
+        config.reorderWindow = 16;
+        ParallelAnalyzer analyzer([]() {
+            return std::vector<PipelineStage>{ { "jitter", [](PipelineItem& item) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 + (item.frame.frameNumber * 7919) % 20));
+                return item.frame.frameNumber % 10 != 3; // 每十帧有一帧“没有结果”
+            } } };
+            }, config, scheduler);
+
+        std::vector<uint64_t> emitted;
+        std::atomic<int> inCallback{ 0 };
+        bool overlapped = false;
+        analyzer.start([&](const PipelineItem& item) {
+            if (inCallback++ > 0) overlapped = true;
+            emitted.push_back(item.frame.frameNumber);
+            inCallback--;
+            });
+
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < 100; i++) {
+            analyzer.push(makeTestFrame(i));
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        analyzer.stop();
+
+        ParallelAnalyzerStats stats = analyzer.getStats();
+        std::cout << "       100 帧用时 " << seconds << " s (串行约 1.5 s)，平均分析 " << stats.avgAnalyzeMs
+            << " ms，最多等待重排 " << stats.maxReorderWaitMs << " ms" << std::endl;
+        check(strictlyIncreasing(emitted), "乱序完成、按帧序交出");
+        check(!overlapped, "结果回调从不并发");
+        check(stats.emitted == 90 && stats.rejected == 10 && stats.entryDropped == 0, "返回 false 的帧跳过，不挡后面的帧");
+        check(seconds < 1.2 && stats.peakReorderPending > 0, "多帧同时分析，重排缓冲确有等待");
+    }
+
+    // 2. 严格按序：队首一帧卡住时后面的帧全都等着，重排窗口满了入口丢新帧
+    {
+        ParallelAnalyzerConfig config;
+        config.workers = 2;
+        config.reorderWindow = 4;
+        ParallelAnalyzer analyzer(sleepChain(2, 0, 200), config, scheduler);
+
+        std::vector<uint64_t> emitted;
+        analyzer.start([&](const PipelineItem& item) { emitted.push_back(item.frame.frameNumber); });
+
+        int accepted = 0;
+        for (uint64_t i = 0; i < 20; i++) {
+            accepted += analyzer.push(makeTestFrame(i)) ? 1 : 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        ParallelAnalyzerStats stats = analyzer.getStats();
+        check(!emitted.empty() && emitted.front() == 0 && strictlyIncreasing(emitted), "队首卡住时不跳帧");
+        check(stats.entryDropped > 0 && stats.entryDropped + accepted == 20, "重排窗口满时入口丢帧并计数");
+        check(stats.emitted == static_cast<uint64_t>(accepted) && stats.inFlight == 0, "进入窗口的帧全部交出");
+    }
+
+    // 3. 迟到丢弃：队首迟迟不出结果，后面的帧等够 maxWait 就跳过它，它的结果回来时作废
+    {
+        ParallelAnalyzerConfig config;
+        config.workers = 3;
+        config.reorderWindow = 8;
+        config.dropLate = true;
+        config.maxWait = std::chrono::milliseconds(30);
+        ParallelAnalyzer analyzer(sleepChain(5, 5, 300), config, scheduler);
+
+        std::vector<uint64_t> emitted;
+        analyzer.start([&](const PipelineItem& item) { emitted.push_back(item.frame.frameNumber); });
+        for (uint64_t i = 0; i < 20; i++) {
+            analyzer.push(makeTestFrame(i));
+            std::this_thread::sleep_for(std::chrono::milliseconds(8));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+
+        ParallelAnalyzerStats stats = analyzer.getStats();
+        bool lateEmitted = false;
+        for (uint64_t frameNumber : emitted) lateEmitted = lateEmitted || frameNumber == 5;
+        check(!lateEmitted && stats.lateDropped == 1 && stats.emitted == 19, "迟到的一帧被跳过，结果作废");
+        check(strictlyIncreasing(emitted), "跳过之后交出的帧序仍然单调递增");
+        check(stats.analyzed == 20, "作废的帧同样计入分析次数");
+
+        analyzer.stop();
+        check(!analyzer.isRunning() && !analyzer.push(makeTestFrame(100)), "停止后拒收");
+    }
+
+    // 4. 并行度 0 取调度器的线程数，重排窗口不小于并行度；分析任务都记在 ANALYSIS 类别下
+    {
+        ParallelAnalyzerConfig config;
+        config.reorderWindow = 1;
+        ParallelAnalyzer analyzer(sleepChain(1, 0, 1), config, scheduler);
+        ParallelAnalyzerStats stats = analyzer.getStats();
+        check(stats.workers == 4 && stats.reorderWindow == 4, "默认并行度与窗口下限");
+
+        TaskSchedulerStats schedulerStats = scheduler.getStats();
+        const TaskClassStats& analysis = schedulerStats.classes[static_cast<size_t>(TaskPriority::ANALYSIS)];
+        check(analysis.completed > 0 && analysis.peakRunning <= 4, "分析任务跑在共享调度器上");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+﻿// ===================================================================
+// 参数命令队列测试：模拟拖动数值框时的一连串写请求
+// 验证同一参数只保留最新值、下发节拍受限、回显的是设备实际采用的值
+// ===================================================================
+#include "CameraService.h"
+#include "SimulatedCamera.h"
+#include "TestSupport.h"
+#include <QCoreApplication>
+#include <iostream>
+#include <thread>
+
+namespace {
+    // 记录真正落到设备上的曝光写入次数
+    class CountingCamera : public SimulatedCamera {
+    public:
+        using SimulatedCamera::SimulatedCamera;
+        CameraStatus setExposureTime(float timeUs) override {
+            exposureWrites++;
+            return SimulatedCamera::setExposureTime(timeUs);
+        }
+        int exposureWrites = 0;
+    };
+
+    void pumpEvents(int ms) {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (std::chrono::steady_clock::now() < end) {
+            QCoreApplication::processEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    std::cout << "========================================" << std::endl;
+    std::cout << " ParamCommandQueue 测试 [Coalescing]    " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // 1. 队列本身：覆盖旧值、按参数各留一条、节拍内不允许再次下发
+    {
+        ParamCommandQueue queue(std::chrono::milliseconds(50));
+        auto now = std::chrono::steady_clock::now();
+        check(queue.post(CameraParam::EXPOSURE_TIME, 1000.0), "空队列投递时提示安排下发");
+        check(!queue.post(CameraParam::EXPOSURE_TIME, 2000.0), "已有待下发值时不重复提示");
+        queue.post(CameraParam::GAIN, 3.0);
+
+        std::vector<ParamCommand> commands = queue.take(now);
+        check(commands.size() == 2 && commands[0].value == 2000.0 && commands[1].value == 3.0, "每个参数只下发最新值");
+        check(queue.getStats().coalesced == 1 && queue.getStats().applied == 2, "统计合并与下发次数");
+
+        queue.post(CameraParam::GAIN, 4.0);
+        auto wait = queue.timeUntilDue(now + std::chrono::milliseconds(20));
+        check(wait.count() >= 29 && wait.count() <= 30, "节拍内需要等到上次下发后 50ms");
+        check(queue.timeUntilDue(now + std::chrono::milliseconds(60)).count() == 0, "过了节拍即可下发");
+    }
+
+    // 2. 接入 CameraService：300ms 内连发 150 个曝光值，设备只被写入少数几次
+    {
+        SimulatedCameraConfig config;
+        config.width = 320;
+        config.height = 240;
+        CountingCamera camera(config);
+        camera.openDevice();
+        CameraService service(&camera);
+
+        double lastRequested = 0.0, lastApplied = 0.0;
+        int echoes = 0;
+        QObject::connect(&service, &CameraService::exposureTimeApplied, [&](double requested, double applied) {
+            lastRequested = requested;
+            lastApplied = applied;
+            echoes++;
+            });
+
+        for (int i = 1; i <= 150; i++) {
+            service.setExposureTime(1000.0 + i * 10.0);
+            pumpEvents(2);
+        }
+        pumpEvents(200);
+
+        ParamQueueStats stats = service.getParamQueueStats();
+        std::cout << "       请求 " << stats.posted << " 次，写入设备 " << camera.exposureWrites << " 次，回显 " << echoes << " 次" << std::endl;
+        check(camera.exposureWrites >= 3 && camera.exposureWrites <= 15, "写入设备的次数受节拍限制");
+        check(camera.getExposureTime() == 2500.0f, "最终生效的是最后一个值");
+        check(lastRequested == 2500.0 && lastApplied == 2500.0, "回显最后一次写入的实际值");
+
+        // 超出设备范围的值：写入失败，回显的仍是设备当前的真实值
+        service.setExposureTime(5.0);
+        pumpEvents(100);
+        check(lastRequested == 5.0 && lastApplied == 2500.0, "设备拒绝时回显真实值，界面随之回退");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
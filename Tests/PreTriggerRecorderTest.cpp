@@ -0,0 +1,154 @@
+﻿// ===================================================================
+// PreTriggerRecorder 测试：用手工构造的帧驱动事件前后录制
+// 验证按字节限量、事件窗口 (事前 + 事后) 写盘内容、写盘期间照常收帧、缓冲不足时窗口滚动
+// ===================================================================
+#include "PreTriggerRecorder.h"
+#include "RawRecording.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int kWidth = 100;
+    constexpr int kHeight = 100; // 每帧 10000 字节
+    constexpr int kIntervalMs = 10;
+
+    // 像素填成帧号，读回时据此核对内容
+    Frame numberedFrame(uint64_t index) {
+        return makeTestFrame(index, cv::Mat(kHeight, kWidth, CV_8UC1, cv::Scalar(static_cast<int>(index % 256))));
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " PreTriggerRecorder 测试 [Event Capture]" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "PreTriggerRecorderTest";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // 1. 按字节限量：时间窗再长，缓冲也不超过给定字节数
+    {
+        PreTriggerConfig config;
+        config.capacityBytes = 105000;
+        config.preTrigger = std::chrono::milliseconds(10000);
+        config.handoffDepth = 64;
+        PreTriggerRecorder recorder(config);
+        check(!recorder.trigger((dir / "empty.ocvraw").string()), "还没有帧时触发被拒绝");
+
+        for (uint64_t i = 0; i < 50; i++) recorder.push(numberedFrame(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        PreTriggerStats stats = recorder.getStats();
+        check(stats.pushed == 50 && stats.handoffDropped == 0, "50 帧全部交接给拷贝线程");
+        check(stats.bufferedBytes <= config.capacityBytes && stats.bufferedFrames == 10, "缓冲只保留装得下的最近 10 帧");
+
+        Frame huge;
+        huge.setImage(cv::Mat(400, 400, CV_8UC1, cv::Scalar(0)));
+        recorder.push(huge);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(recorder.getStats().oversizeFrames == 1, "比整个缓冲还大的帧被计数并跳过");
+    }
+
+    // 2. 事件窗口：事前 300 ms + 事后 100 ms，写盘期间采集照常进行
+    {
+        PreTriggerConfig config;
+        config.capacityBytes = 4u << 20;
+        config.preTrigger = std::chrono::milliseconds(300);
+        config.postTrigger = std::chrono::milliseconds(100);
+        PreTriggerRecorder recorder(config);
+
+        std::atomic<int> flushed{ 0 };
+        uint64_t flushedFrames = 0;
+        bool flushOk = false;
+        recorder.setFlushCallback([&](const std::string&, uint64_t frames, bool ok) {
+            flushedFrames = frames;
+            flushOk = ok;
+            flushed++;
+            });
+
+        std::string path = (dir / "event.ocvraw").string();
+        uint64_t index = 0;
+        double maxPushMs = 0.0;
+        auto pushOne = [&]() {
+            Frame frame = numberedFrame(index++);
+            auto begin = std::chrono::steady_clock::now();
+            recorder.push(frame);
+            maxPushMs = std::max(maxPushMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+            std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
+        };
+
+        for (int i = 0; i < 60; i++) pushOne(); // 600 ms，比事前窗口长
+        uint64_t eventIndex = index;
+        check(recorder.trigger(path), "触发事件");
+        for (int i = 0; i < 40; i++) pushOne(); // 事后继续采集，覆盖写盘全过程
+
+        check(waitFor([&] { return flushed >= 1; }, 3000) && flushOk, "事件窗口写盘完成");
+        std::cout << "       写入 " << flushedFrames << " 帧，push 最长 " << maxPushMs << " ms" << std::endl;
+        check(maxPushMs < 5.0, "push 不承担拷贝与写盘耗时");
+
+        RawRecordingReader reader;
+        check(reader.open(path) && reader.frameCount() == flushedFrames, "录像文件可读，帧数与回调一致");
+
+        // 按帧号核对：覆盖事前约 30 帧与事后约 10 帧，连续且像素对得上
+        bool contentOk = reader.frameCount() > 0;
+        uint64_t firstNumber = 0, lastNumber = 0;
+        for (size_t i = 0; i < reader.frameCount() && contentOk; i++) {
+            Frame frame;
+            contentOk = reader.read(i, frame);
+            if (!contentOk) break;
+            if (i == 0) firstNumber = frame.frameNumber;
+            else contentOk = frame.frameNumber == lastNumber + 1;
+            lastNumber = frame.frameNumber;
+            contentOk = contentOk && frame.image().at<uchar>(kHeight - 1, kWidth - 1) == frame.frameNumber % 256;
+        }
+        std::cout << "       窗口帧号 " << firstNumber << " - " << lastNumber << "，事件发生在 " << eventIndex << std::endl;
+        check(contentOk, "窗口内帧号连续，像素与帧号一致");
+        check(eventIndex - firstNumber >= 25 && eventIndex - firstNumber <= 32, "窗口起点约在事件前 300 ms");
+        check(lastNumber >= eventIndex + 7 && lastNumber <= eventIndex + 12, "窗口终点约在事件后 100 ms");
+
+        PreTriggerStats stats = recorder.getStats();
+        check(stats.events == 1 && stats.pendingEvents == 0 && stats.flushedFrames == flushedFrames, "事件统计完整");
+        check(stats.handoffDropped == 0 && stats.overrunFrames == 0 && stats.bufferedFrames >= 25, "写盘期间没有丢帧，缓冲继续滚动");
+    }
+
+    // 3. 缓冲装不下整个窗口：冻结前照常滚动，保留离冻结时刻最近的帧
+    {
+        PreTriggerConfig config;
+        config.capacityBytes = 205000; // 20 帧
+        config.preTrigger = std::chrono::milliseconds(1000);
+        config.postTrigger = std::chrono::milliseconds(100);
+        PreTriggerRecorder recorder(config);
+
+        std::atomic<int> flushed{ 0 };
+        recorder.setFlushCallback([&](const std::string&, uint64_t, bool) { flushed++; });
+
+        uint64_t index = 0;
+        for (int i = 0; i < 30; i++) {
+            recorder.push(numberedFrame(index++));
+            std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
+        }
+        std::string path = (dir / "rolling.ocvraw").string();
+        recorder.trigger(path);
+        for (int i = 0; i < 20; i++) {
+            recorder.push(numberedFrame(index++));
+            std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
+        }
+        check(waitFor([&] { return flushed >= 1; }, 3000), "窗口写盘完成");
+
+        RawRecordingReader reader;
+        Frame last;
+        bool ok = reader.open(path) && reader.frameCount() > 0 && reader.read(reader.frameCount() - 1, last);
+        check(ok && reader.frameCount() <= 20 && last.frameNumber >= 37, "只保留装得下的最近 20 帧，事后的帧没有被挤掉");
+    }
+
+    fs::remove_all(dir);
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+﻿// ===================================================================
+// ProcessingPipeline 测试：用手工构造的帧驱动分阶段流水线
+// 验证阶段并行 (吞吐量取决于最慢一级)、入口背压、阶段统计、拆开的负压环检测与一口气检测结果一致
+// ===================================================================
+#include "ProcessingPipeline.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 什么都不做、只占用固定时长的阶段
+    PipelineStage sleepStage(const char* name, int ms) {
+        return { name, [ms](PipelineItem&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            return true;
+        } };
+    }
+
+    // 收集结果的帧号
+    struct Collector {
+        std::mutex mutex;
+        std::vector<uint64_t> frameNumbers;
+        void add(const PipelineItem& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameNumbers.push_back(item.frame.frameNumber);
+        }
+        size_t count() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return frameNumbers.size();
+        }
+        bool inOrder() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 1; i < frameNumbers.size(); i++) {
+                if (frameNumbers[i] <= frameNumbers[i - 1]) return false;
+            }
+            return true;
+        }
+    };
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " ProcessingPipeline 测试 [Stage Graph]  " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    cv::Mat blank(48, 64, CV_8UC1, cv::Scalar(0));
+
+    // 1. 阶段并行：4 级各 10 ms，按 80 fps 送帧，全部走完且不丢 (串行的话每帧要 40 ms)
+    {
+        ProcessingPipeline pipeline(4);
+        for (const char* name : { "a", "b", "c", "d" }) pipeline.addStage(sleepStage(name, 10));
+        Collector collector;
+        check(pipeline.start([&](const PipelineItem& item) { collector.add(item); }), "流水线启动");
+
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < 40; i++) {
+            pipeline.push(makeTestFrame(i, blank));
+            std::this_thread::sleep_for(std::chrono::milliseconds(12));
+        }
+        bool all = waitFor([&] { return collector.count() >= 40; }, 3000);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "       40 帧用时 " << seconds << " s (串行至少 1.6 s)" << std::endl;
+        check(all && collector.inOrder(), "40 帧全部按顺序走完");
+        check(seconds < 1.0, "各阶段并行：吞吐量取决于最慢的一级");
+
+        PipelineStats stats = pipeline.getStats();
+        bool timing = stats.stages.size() == 4;
+        for (const PipelineStageStats& stage : stats.stages) {
+            timing = timing && stage.processed == 40 && stage.avgMs >= 9.0 && stage.avgMs < 20.0 && stage.maxMs >= stage.avgMs;
+        }
+        check(timing, "每个阶段的处理计数与耗时统计");
+        check(stats.pushed == 40 && stats.completed == 40 && stats.entryDropped == 0 && stats.lastLatencyMs >= 40.0, "整体计数与端到端延迟");
+    }
+
+    // 2. 入口背压：最慢一级跟不上时只在入口丢新帧，送帧方从不等待，进了流水线的帧按顺序走完
+    {
+        ProcessingPipeline pipeline(2);
+        pipeline.addStage(sleepStage("fast", 1));
+        pipeline.addStage(sleepStage("slow", 20));
+        Collector collector;
+        pipeline.start([&](const PipelineItem& item) { collector.add(item); });
+
+        auto begin = std::chrono::steady_clock::now();
+        int accepted = 0;
+        for (uint64_t i = 0; i < 50; i++) accepted += pipeline.push(makeTestFrame(i, blank)) ? 1 : 0;
+        double pushMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        waitFor([&] { return collector.count() >= static_cast<size_t>(accepted); }, 3000);
+        PipelineStats stats = pipeline.getStats();
+        check(pushMs < 20.0, "送帧方从不等待");
+        check(stats.entryDropped > 0 && stats.entryDropped + accepted == 50, "入口满时丢帧并计数");
+        check(collector.count() == static_cast<size_t>(accepted) && collector.inOrder(), "进入流水线的帧全部按顺序走完");
+
+        pipeline.stop();
+        check(!pipeline.isRunning() && !pipeline.push(makeTestFrame(100, blank)), "停止后拒收");
+    }
+
+    // 3. 负压环检测拆成 6 个阶段，结果与一口气检测完全一致
+    {
+        cv::Mat image(1200, 1600, CV_8UC1, cv::Scalar(170));
+        cv::circle(image, cv::Point(800, 600), 320, cv::Scalar(40), 12, cv::LINE_AA);
+        cv::circle(image, cv::Point(800, 600), 200, cv::Scalar(40), 12, cv::LINE_AA);
+
+        RingDetection expected = RingDetector::detect(image, RingDetectorConfig(), cv::COLOR_RGB2GRAY);
+
+        ProcessingPipeline pipeline;
+        pipeline.addStages(PipelineStages::ringDetection());
+        std::mutex mutex;
+        std::vector<PipelineItem> results;
+        pipeline.start([&](const PipelineItem& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(item);
+            });
+        for (uint64_t i = 0; i < 3; i++) {
+            pipeline.push(makeTestFrame(i, image));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (results.size() == 3) break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        pipeline.stop();
+
+        bool same = results.size() == 3;
+        for (const PipelineItem& item : results) {
+            same = same && item.detection.found == expected.found &&
+                cv::norm(item.detection.center - expected.center) < 1e-3 &&
+                std::abs(item.detection.radius - expected.radius) < 1e-3;
+        }
+        std::cout << "       检测结果: " << (expected.found ? "找到" : "未找到") << " 圆心 (" << expected.center.x << ", " << expected.center.y << ") 半径 " << expected.radius << std::endl;
+        check(same, "分阶段检测与 RingDetector::detect 结果一致");
+        check(!results.empty() && results[0].annotated.cols == 1600 && results[0].annotated.channels() == 3, "标注图为源帧分辨率的彩色图");
+
+        PipelineStats stats = pipeline.getStats();
+        bool named = stats.stages.size() == 6 && stats.stages[0].name == "resize" && stats.stages[5].name == "annotate";
+        check(named, "六个阶段各自有名字与统计");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
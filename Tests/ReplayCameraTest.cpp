@@ -0,0 +1,204 @@
+﻿// ===================================================================
+// ReplayCamera 测试：先用 RawRecordingWriter 录一段，再回放验证
+// 验证帧序与元数据原样还原、原始节拍、全速回放、循环与图片目录源
+// ===================================================================
+#include "ReplayCamera.h"
+#include "RawRecording.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int kFrames = 20;
+    constexpr int kIntervalMs = 20; // 录制时的帧间隔 (50 fps)
+
+    // 每帧像素填成帧号，回放时据此核对内容
+    Frame recordedFrame(int index, std::chrono::steady_clock::time_point origin) {
+        Frame frame = makeTestFrame(1000 + index, cv::Mat(48, 64, CV_8UC1, cv::Scalar(index)), PixelFormat::BAYER_RG8);
+        frame.deviceTimestamp = 5000000ull * index;
+        frame.lostPackets = index % 3;
+        frame.hostArrival = origin + std::chrono::milliseconds(kIntervalMs * index);
+        return frame;
+    }
+
+    // 跑一遍非循环回放，返回收到的帧及到达时刻
+    std::vector<Frame> playAll(ReplayCamera& camera) {
+        std::vector<Frame> received;
+        std::mutex mutex;
+        camera.registerFrameCallback([&](const Frame& frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(frame);
+            });
+        camera.startStream();
+        for (int i = 0; i < 300 && !camera.getReplayStats().finished; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        camera.stopStream();
+        return received;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " ReplayCamera 测试 [Raw & Image Replay] " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "ReplayCameraTest";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string rawPath = (dir / "record.ocvraw").string();
+
+    // 1. 录制
+    {
+        RawRecordingWriter writer;
+        check(writer.open(rawPath), "创建原始录像文件");
+        auto origin = std::chrono::steady_clock::now();
+        bool allWritten = true;
+        for (int i = 0; i < kFrames; i++) {
+            allWritten = writer.write(recordedFrame(i, origin)) && allWritten;
+        }
+        check(allWritten && writer.framesWritten() == kFrames, "写入全部帧");
+    }
+    check(RawRecordingReader::isRawRecording(rawPath), "文件头被识别为原始录像");
+
+    // 2. 全速回放：帧序、像素与元数据原样还原
+    {
+        ReplayConfig config;
+        config.source = rawPath;
+        config.timing = ReplayTiming::AS_FAST_AS_POSSIBLE;
+        config.decodeThreads = 3;
+        config.prefetchDepth = 4;
+        ReplayCamera camera(config);
+        check(camera.openDevice() == CameraStatus::SUCCESS, "打开原始录像");
+
+        std::vector<Frame> frames = playAll(camera);
+        check(frames.size() == kFrames, "全速回放交付全部帧");
+
+        bool ordered = frames.size() == kFrames;
+        for (size_t i = 0; i < frames.size() && ordered; i++) {
+            const Frame& frame = frames[i];
+            ordered = frame.frameNumber == 1000 + i &&
+                frame.deviceTimestamp == 5000000ull * i &&
+                frame.lostPackets == i % 3 &&
+                frame.pixelFormat == PixelFormat::BAYER_RG8 &&
+                frame.image().at<uchar>(10, 10) == static_cast<uchar>(i);
+        }
+        check(ordered, "多线程预取下帧序、像素与元数据与录制时一致");
+        check(camera.setExposureTime(1000.0f) == CameraStatus::PARAM_SET_FAILED, "回放时曝光不可修改");
+
+        // 播完后不调用 stopStream 直接再次开始：取流状态已随播完复位，从头重播
+        std::atomic<int> replayed{ 0 };
+        camera.registerFrameCallback([&](const Frame&) { replayed++; });
+        camera.startStream();
+        for (int i = 0; i < 300 && !camera.getReplayStats().finished; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        check(camera.startStream() == CameraStatus::SUCCESS, "播完后再次开始取流");
+        for (int i = 0; i < 300 && replayed < 2 * kFrames; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        check(replayed == 2 * kFrames, "播完即停止取流，再次开始时从头重播");
+        camera.stopStream();
+        camera.closeDevice();
+    }
+
+    // 2.1 播完后不调用 stopStream 直接关闭 / 析构：线程必须先被回收
+    for (int pass = 0; pass < 2; pass++) {
+        ReplayConfig config;
+        config.source = rawPath;
+        config.timing = ReplayTiming::AS_FAST_AS_POSSIBLE;
+        config.decodeThreads = 3;
+        config.prefetchDepth = 2;
+        ReplayCamera camera(config);
+        camera.openDevice();
+
+        std::atomic<int> played{ 0 };
+        camera.registerFrameCallback([&](const Frame&) { played++; });
+        camera.startStream();
+        for (int i = 0; i < 300 && !camera.getReplayStats().finished; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        check(camera.getReplayStats().finished && played == kFrames, "播完全部帧");
+        if (pass == 0) check(camera.closeDevice() == CameraStatus::SUCCESS, "播完后直接关闭设备");
+        // pass == 1：不关闭，直接析构
+    }
+    check(true, "播完后直接关闭或析构不崩溃");
+
+    // 3. 原始节拍：整段时长应接近录制时长 (19 个间隔)
+    {
+        ReplayConfig config;
+        config.source = rawPath;
+        ReplayCamera camera(config);
+        camera.openDevice();
+
+        std::vector<Frame> frames = playAll(camera);
+        check(frames.size() == kFrames, "原始节拍回放交付全部帧");
+        if (frames.size() == kFrames) {
+            double spanMs = std::chrono::duration<double, std::milli>(frames.back().hostArrival - frames.front().hostArrival).count();
+            std::cout << "       录制跨度 " << kIntervalMs * (kFrames - 1) << " ms，回放跨度 " << spanMs << " ms" << std::endl;
+            check(spanMs > kIntervalMs * (kFrames - 1) * 0.9 && spanMs < kIntervalMs * (kFrames - 1) * 1.5, "回放跨度与录制跨度一致");
+        }
+        camera.closeDevice();
+    }
+
+    // 4. 循环：超过一轮的帧数仍在持续交付
+    {
+        ReplayConfig config;
+        config.source = rawPath;
+        config.timing = ReplayTiming::AS_FAST_AS_POSSIBLE;
+        config.loop = true;
+        ReplayCamera camera(config);
+        camera.openDevice();
+
+        std::atomic<int> count{ 0 };
+        camera.registerFrameCallback([&](const Frame&) { count++; });
+        camera.startStream();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Frame frame;
+        check(camera.grabFrame(frame, 500) && !frame.empty(), "循环回放中 grabFrame 拿到帧");
+        camera.stopStream();
+        check(count > kFrames * 2, "循环模式播完后从头再来");
+        camera.closeDevice();
+    }
+
+    // 5. 图片目录：按 CameraView 的存图命名，以文件名中的时间戳为节拍
+    {
+        fs::path imageDir = dir / "images";
+        fs::create_directories(imageDir);
+        const char* names[] = { "IMG_20240101_235959_900.png", "IMG_20240102_000000_000.png", "IMG_20240102_000000_100.png" };
+        for (int i = 0; i < 3; i++) {
+            cv::Mat bgr(32, 32, CV_8UC3, cv::Scalar(10 * i, 100, 200)); // B G R
+            cv::imwrite((imageDir / names[i]).string(), bgr);
+        }
+
+        ReplayConfig config;
+        config.source = imageDir.string();
+        ReplayCamera camera(config);
+        check(camera.openDevice() == CameraStatus::SUCCESS, "打开图片目录");
+        check(camera.getReplayStats().totalFrames == 3, "扫描到 3 张图片");
+
+        std::vector<Frame> frames = playAll(camera);
+        check(frames.size() == 3, "图片目录回放交付全部帧");
+        if (frames.size() == 3) {
+            cv::Vec3b px = frames[2].image().at<cv::Vec3b>(0, 0);
+            check(frames[2].pixelFormat == PixelFormat::RGB8 && px[0] == 200 && px[2] == 20, "图片按 RGB8 交付");
+            double spanMs = std::chrono::duration<double, std::milli>(frames[2].hostArrival - frames[0].hostArrival).count();
+            check(spanMs > 180 && spanMs < 300, "跨天的文件名时间戳换算正确 (间隔 200 ms)");
+        }
+        camera.closeDevice();
+    }
+
+    ReplayCamera missing(ReplayConfig{ (dir / "none").string() });
+    check(missing.openDevice() == CameraStatus::DEVICE_NOT_FOUND, "回放源不存在时打不开");
+
+    fs::remove_all(dir);
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+﻿// ===================================================================
+// RoiFollower 测试：模拟相机的圆环在画面里移动，ROI 跟着圆心走
+// 验证平移优先、装不下才改尺寸、目标始终留在读出区域内、丢失目标后恢复全幅
+// ===================================================================
+#include "RoiFollower.h"
+#include "SimulatedCamera.h"
+#include "TestSupport.h"
+#include <iostream>
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " RoiFollower 测试 [Dynamic ROI]         " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    SimulatedCameraConfig config;
+    config.width = 640;
+    config.height = 480;
+    config.format = PixelFormat::MONO8;
+    config.frameRate = 60.0;
+
+    SimulatedCamera camera(config);
+    camera.openDevice();
+    camera.startStream();
+
+    RoiFollower follower(&camera);
+    const float radius = 40.0f; // 检测器报告的目标半径 (传感器像素)
+
+    // 1. 跟随 2 秒：检测圆心亮斑 (画面里最亮的点)，换算回全幅坐标后送给跟随器
+    int frames = 0, found = 0, inside = 0;
+    Frame frame;
+    for (int i = 0; i < 120 && camera.grabFrame(frame, 500); i++) {
+        double maxValue = 0.0;
+        cv::Point maxLoc;
+        cv::minMaxLoc(frame.image(), nullptr, &maxValue, nullptr, &maxLoc);
+        bool hit = maxValue > 170.0;
+
+        cv::Point2f center = frame.toSensor(cv::Point2f(static_cast<float>(maxLoc.x), static_cast<float>(maxLoc.y)));
+        frames++;
+        found += hit ? 1 : 0;
+        inside += frame.sensorRect.contains(cv::Point(static_cast<int>(center.x), static_cast<int>(center.y))) ? 1 : 0;
+        follower.update(hit, center, radius);
+    }
+
+    RoiFollowStats stats = follower.getStats();
+    std::cout << "       " << frames << " 帧，平移 " << stats.moves << " 次，改尺寸 " << stats.resizes << " 次，当前 ROI "
+        << stats.current.width << "x" << stats.current.height << std::endl;
+    check(frames == 120 && found == frames, "每一帧都能在读出区域内找到目标");
+    check(inside == frames, "目标始终落在帧标注的传感器区域内");
+    check(stats.resizes >= 1 && stats.current.width < 320 && stats.current.height < 240, "ROI 收缩到目标附近");
+    check(stats.moves > stats.resizes, "跟随以平移为主，很少改尺寸");
+    check(frame.image().cols == frame.sensorRect.width && frame.image().cols < 320, "收缩后帧尺寸随之变小");
+
+    // 2. 连续丢失目标：到达阈值后恢复全幅读出
+    for (int i = 0; i < RoiFollowConfig().lostFramesToReset; i++) {
+        follower.update(false, cv::Point2f(), 0.0f);
+    }
+    check(follower.getStats().resets == 1 && camera.getRoi() == SensorRoi{ 0, 0, 640, 480 }, "丢失目标后恢复全幅");
+
+    camera.closeDevice();
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+﻿// ===================================================================
+// SimulatedCamera 测试：不需要任何硬件，Linux 构建机上也能跑
+// 验证帧率节拍、曝光/增益对亮度的影响、各像素格式输出、帧号连续性与 ROI/合并/抽样
+// ===================================================================
+#include "SimulatedCamera.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 参数修改前已经生成、还在队列里的帧先放过去，再取一帧新的
+    bool grabFresh(SimulatedCamera& camera, Frame& frame) {
+        for (int i = 0; i < 3; i++) {
+            if (!camera.grabFrame(frame, 500)) return false;
+        }
+        return true;
+    }
+
+    double meanOf(const cv::Mat& image) {
+        cv::Scalar m = cv::mean(image);
+        return (m[0] + m[1] + m[2]) / image.channels();
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " SimulatedCamera 测试 [Synthetic Frames] " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    SimulatedCameraConfig config;
+    config.width = 640;
+    config.height = 480;
+    config.frameRate = 100.0;
+    config.format = PixelFormat::MONO8;
+    SimulatedCamera camera(config);
+
+    check(camera.enumDevices().size() == 1, "枚举到一台虚拟设备");
+    check(camera.openDevice("NOT_EXIST") == CameraStatus::DEVICE_NOT_FOUND, "序列号不匹配时打不开");
+    check(camera.openDevice() == CameraStatus::SUCCESS, "openDevice 成功");
+
+    // 1. 节拍：100 fps 跑 1 秒，帧数与帧号都应连续且接近 100
+    std::atomic<int> frames{ 0 };
+    std::atomic<uint64_t> lastNumber{ 0 };
+    std::atomic<int> gaps{ 0 };
+    camera.registerFrameCallback([&](const Frame& frame) {
+        if (lastNumber != 0 && frame.frameNumber != lastNumber + 1) gaps++;
+        lastNumber = frame.frameNumber;
+        frames++;
+        });
+
+    check(camera.startStream() == CameraStatus::SUCCESS, "开始取流");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    int count = frames;
+    std::cout << "       1 秒内收到 " << count << " 帧" << std::endl;
+    check(count >= 90 && count <= 102, "100 fps 节拍误差在 10% 以内");
+    check(gaps == 0, "帧号连续，没有丢帧");
+
+    // 2. 亮度：曝光加倍，画面均值应明显上升；增益 +6dB 同理
+    Frame frame;
+    check(camera.grabFrame(frame, 500), "grabFrame 拿到帧");
+    check(frame.image().rows == 480 && frame.image().cols == 640 && frame.pixelFormat == PixelFormat::MONO8, "尺寸与格式正确");
+    double base = meanOf(frame.image());
+
+    camera.setExposureTime(camera.getExposureTime() * 2.0f);
+    grabFresh(camera, frame);
+    double brighter = meanOf(frame.image());
+    check(brighter > base * 1.6, "曝光加倍后亮度明显上升");
+
+    camera.setExposureTime(camera.getExposureTime() / 2.0f);
+    camera.setGain(6.0f);
+    grabFresh(camera, frame);
+    check(meanOf(frame.image()) > base * 1.6, "增益 +6dB 后亮度明显上升");
+    check(camera.setGain(camera.getMaxGain() + 1.0f) == CameraStatus::PARAM_SET_FAILED, "超出最大增益被拒绝");
+    camera.setGain(0.0f);
+
+    // 3. 格式：取流中切到 Bayer，帧以原始格式到达，按需转换出 RGB
+    check(camera.setOutputFormat(PixelFormat::BAYER_RG8) == CameraStatus::SUCCESS, "取流中切换到 BayerRG8");
+    check(grabFresh(camera, frame) && frame.pixelFormat == PixelFormat::BAYER_RG8 && frame.image().channels() == 1, "Bayer 帧以原始格式到达");
+    cv::Mat rgb = frame.toFormat(PixelFormat::RGB8);
+    check(rgb.channels() == 3 && rgb.rows == 480, "Bayer 帧可按需转换为 RGB8");
+    check(frame.toFormat(PixelFormat::RGB8).data == rgb.data, "同一帧的转换结果被缓存");
+    Frame copy = frame;
+    check(copy.toFormat(PixelFormat::RGB8).data == rgb.data, "拷贝共享转换结果");
+    copy.setImage(cv::Mat(480, 640, CV_8UC1, cv::Scalar(0)));
+    check(copy.toFormat(PixelFormat::RGB8).data != rgb.data && frame.toFormat(PixelFormat::RGB8).data == rgb.data,
+        "拷贝换图后重新转换，原帧的缓存不受影响");
+
+    check(camera.setOutputFormat(PixelFormat::RGB8) == CameraStatus::SUCCESS, "切换到 RGB8");
+    check(grabFresh(camera, frame) && frame.image().channels() == 3, "RGB8 帧为三通道");
+
+    // 4. ROI、合并与抽样：取流中直接生效，帧上标注全幅位置，坐标可换算回传感器
+    check(camera.setRoi({ 101, 50, 200, 151 }) == CameraStatus::SUCCESS, "取流中设置 ROI");
+    check(camera.getRoi() == SensorRoi{ 100, 50, 200, 152 }, "ROI 按 2 像素对齐");
+    check(grabFresh(camera, frame) && frame.image().cols == 200 && frame.image().rows == 152, "帧尺寸等于 ROI");
+    check(frame.sensorRect == cv::Rect(100, 50, 200, 152) && frame.pixelStep == 1, "帧上标注了 ROI 在全幅中的位置");
+
+    check(camera.setBinning(2) == CameraStatus::SUCCESS && camera.setDecimation(2) == CameraStatus::SUCCESS, "2x2 合并 + 2 倍抽样");
+    check(grabFresh(camera, frame) && frame.image().cols == 50 && frame.image().rows == 38 && frame.pixelStep == 4, "输出尺寸缩小为 1/4");
+    cv::Point2f sensor = frame.toSensor(cv::Point2f(10.0f, 10.0f));
+    check(sensor.x == 140.0f && sensor.y == 90.0f, "图像坐标换算回传感器全幅坐标");
+
+    camera.setBinning(1);
+    camera.setDecimation(1);
+    check(camera.setRoi(SensorRoi{}) == CameraStatus::SUCCESS && camera.getRoi() == SensorRoi{ 0, 0, 640, 480 }, "恢复全幅");
+    check(camera.setOutputFormat(PixelFormat::BAYER_RG8) == CameraStatus::SUCCESS && camera.setBinning(2) == CameraStatus::PARAM_SET_FAILED, "Bayer 传感器拒绝合并");
+
+    camera.closeDevice();
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
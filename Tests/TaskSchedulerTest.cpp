@@ -0,0 +1,152 @@
+﻿// ===================================================================
+// TaskScheduler 测试：共享工作窃取线程池
+// 验证优先级顺序、各类别并发上限、任务内提交与窃取、异常不拖垮工作线程、析构时跑完剩余任务
+// ===================================================================
+#include "TaskScheduler.h"
+#include "TestSupport.h"
+#include <iostream>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    void updatePeak(std::atomic<int>& peak, int value) {
+        int current = peak.load();
+        while (value > current && !peak.compare_exchange_weak(current, value)) {}
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << " TaskScheduler 测试 [Work Stealing]     " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // 1. 优先级：唯一的工作线程被占住时排进去的任务，放开后按 显示 > 分析 > 归档 执行
+    {
+        TaskSchedulerConfig config;
+        config.workers = 1;
+        TaskScheduler scheduler(config);
+
+        std::atomic<bool> gate{ false };
+        scheduler.submit(TaskPriority::ARCHIVAL, [&] { while (!gate) std::this_thread::yield(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::mutex mutex;
+        std::vector<int> order;
+        for (int i = 0; i < 3; i++) {
+            scheduler.submit(TaskPriority::ARCHIVAL, [&] { std::lock_guard<std::mutex> lock(mutex); order.push_back(2); });
+            scheduler.submit(TaskPriority::ANALYSIS, [&] { std::lock_guard<std::mutex> lock(mutex); order.push_back(1); });
+            scheduler.submit(TaskPriority::DISPLAY, [&] { std::lock_guard<std::mutex> lock(mutex); order.push_back(0); });
+        }
+        gate = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        check(order == std::vector<int>({ 0, 0, 0, 1, 1, 1, 2, 2, 2 }), "高优先级任务先执行");
+    }
+
+    // 2. 并发上限：4 条线程，分析最多 2 条、归档最多 1 条；析构时跑完全部任务
+    {
+        std::atomic<int> analysisRunning{ 0 }, analysisPeak{ 0 };
+        std::atomic<int> archivalRunning{ 0 }, archivalPeak{ 0 };
+        std::atomic<int> done{ 0 };
+        TaskSchedulerStats stats;
+        {
+            TaskSchedulerConfig config;
+            config.workers = 4;
+            config.maxConcurrent[static_cast<size_t>(TaskPriority::ANALYSIS)] = 2;
+            config.maxConcurrent[static_cast<size_t>(TaskPriority::ARCHIVAL)] = 1;
+            TaskScheduler scheduler(config);
+
+            for (int i = 0; i < 100; i++) {
+                scheduler.submit(TaskPriority::ANALYSIS, [&] {
+                    updatePeak(analysisPeak, ++analysisRunning);
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    analysisRunning--;
+                    done++;
+                    });
+                scheduler.submit(TaskPriority::ARCHIVAL, [&] {
+                    updatePeak(archivalPeak, ++archivalRunning);
+                    std::this_thread::sleep_for(std::chrono::microseconds(300));
+                    archivalRunning--;
+                    done++;
+                    });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            stats = scheduler.getStats();
+        } // 析构：等全部任务执行完
+
+        const TaskClassStats& analysis = stats.classes[static_cast<size_t>(TaskPriority::ANALYSIS)];
+        std::cout << "       分析类 平均等待 " << analysis.avgWaitMs << " ms，因上限跳过 " << analysis.deferred << " 次" << std::endl;
+        check(done == 200, "析构前跑完全部已提交的任务");
+        check(analysisPeak <= 2 && archivalPeak <= 1, "各类别并发不超过上限");
+        check(analysis.peakRunning <= 2 && analysis.submitted == 100, "类别统计");
+    }
+
+    // 3. 任务内提交 (分治)：后续任务进本地队列，空闲线程从别人那里偷
+    {
+        TaskSchedulerConfig config;
+        config.workers = 4;
+        TaskScheduler scheduler(config);
+
+        std::atomic<int> leaves{ 0 };
+        std::function<void(int)> split = [&](int depth) {
+            if (depth == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                leaves++;
+                return;
+            }
+            scheduler.submit(TaskPriority::DISPLAY, [&split, depth] { split(depth - 1); });
+            scheduler.submit(TaskPriority::DISPLAY, [&split, depth] { split(depth - 1); });
+        };
+        scheduler.submit(TaskPriority::DISPLAY, [&] { split(8); });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (leaves < 256 && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        TaskSchedulerStats stats = scheduler.getStats();
+        uint64_t executed = 0;
+        for (const TaskWorkerStats& worker : stats.perWorker) executed += worker.executed;
+        std::cout << "       本地取 " << stats.localPops << "，提交队列取 " << stats.injectedPops << "，窃取 " << stats.steals << std::endl;
+        check(leaves == 256, "分治任务全部完成");
+        check(stats.localPops > 0 && stats.steals > 0, "后续任务走本地队列，空闲线程会窃取");
+        check(executed == 511 && stats.localPops + stats.injectedPops + stats.steals == 511, "每个任务恰好执行一次");
+    }
+
+    // 4. 异常：任务抛出的异常被吞掉，工作线程照常干活
+    {
+        TaskSchedulerConfig config;
+        config.workers = 1;
+        TaskScheduler scheduler(config);
+        std::atomic<bool> after{ false };
+        scheduler.submit(TaskPriority::ANALYSIS, [] { throw std::runtime_error("boom"); });
+        scheduler.submit(TaskPriority::ANALYSIS, [&] { after = true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(after, "任务抛异常后工作线程仍然可用");
+    }
+
+    // 5. 亲和性与共享实例
+    {
+        TaskSchedulerConfig config;
+        config.workers = 2;
+        config.pinWorkers = true;
+        config.cpus = { 0 };
+        TaskScheduler scheduler(config);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        TaskSchedulerStats stats = scheduler.getStats();
+        // 平台不支持绑核时为 -1，支持时两条线程都绑在 0 号核
+        check(stats.perWorker.size() == 2 && stats.perWorker[0].cpu == stats.perWorker[1].cpu, "按 cpus 列表绑核");
+
+        TaskSchedulerConfig shared;
+        shared.workers = 2;
+        check(TaskScheduler::configureShared(shared) && TaskScheduler::shared().workerCount() == 2, "共享实例按配置创建");
+        check(!TaskScheduler::configureShared(shared), "创建之后不能再改配置");
+    }
+
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败用例") << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+﻿// Tests/TestSupport.h
+#pragma once
+
+// =========================================================
+// 各测试程序共用的小工具：断言计数、轮询等待、构造测试帧
+// 每个测试都是独立的可执行文件 (单个 .cpp)，这里的定义全部 inline
+// =========================================================
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// 失败用例计数：main() 末尾据此输出“全部通过”并决定退出码
+inline int g_failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    std::cout << (condition ? "[PASS] " : "[FAIL] ") << what << std::endl;
+    if (!condition) g_failures++;
+}
+
+// 等到条件成立或超时，返回最后一次判断的结果
+template <typename Predicate>
+bool waitFor(Predicate predicate, int timeoutMs = 1000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!predicate() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return predicate();
+}
+
+// 帧相关的工具只给链接了 CameraCore (能找到 Frame.h) 的测试
+#if __has_include("Frame.h")
+#include "Frame.h"
+
+// 手工构造一帧：image 为空时共用一张 48x64 的黑色灰度图 (不关心像素内容的测试用)
+inline Frame makeTestFrame(uint64_t frameNumber, const cv::Mat& image = cv::Mat(), PixelFormat format = PixelFormat::MONO8) {
+    static const cv::Mat blank(48, 64, CV_8UC1, cv::Scalar(0));
+    Frame frame;
+    frame.setImage(image.empty() ? blank : image);
+    frame.pixelFormat = format;
+    frame.sensorFormat = format;
+    frame.frameNumber = frameNumber;
+    frame.hostArrival = std::chrono::steady_clock::now();
+    return frame;
+}
+#endif
@@ -8,6 +8,8 @@
 #include <qpushbutton.h>
 #include <QFormLayout>   // 新增
 #include <QDoubleSpinBox>// 新增
+#include <memory>
+#include "LatestFrameMailbox.h"
 
 class CameraView : public QWidget {
     Q_OBJECT // 必备：启用信号槽机制
@@ -15,20 +17,33 @@ public:
     explicit CameraView(QWidget* parent = nullptr);
     ~CameraView() override;
     void showMessage(const QString& msg);
+    // 非错误的状态提示 (如“正在连接相机...”)，样式比 showMessage 平和
+    void showStatus(const QString& msg);
     // 用于接收相机硬件真实的初始参数
     void setInitialParams(double exposure, double gain, double maxGain);
+    // 预览信箱：收到 onFrameAvailable 通知时从这里取最新一帧
+    void setFrameSource(std::shared_ptr<LatestFrameMailbox> mailbox);
 
 
 
 public slots:
     // 专门用来接收 Service 层发来的图像
     void onFrameReady(const cv::Mat& frame);
+    // 预览信箱有新帧了：取出最新的一帧显示 (中间被覆盖的帧不会再出现)
+    void onFrameAvailable();
+
+    // 相机实际采用的参数值：只回显与最近一次输入对应的结果，被设备对齐/钳位时数值框随之修正
+    void onExposureTimeApplied(double requestedUs, double appliedUs);
+    void onGainApplied(double requested, double applied);
 
 signals:
     // 通知外部参数已修改
     void exposureTimeChanged(double timeUs);
     void gainChanged(double gain);
 
+    // 第一帧画面绘制到界面上 (只发一次，用于统计启动耗时)
+    void firstFrameDisplayed();
+
 private:
     void initLayout();
     void initSignalConnects();
@@ -48,11 +63,15 @@ private:
     QWidget* m_settingsPanel;
     QDoubleSpinBox* m_spinExposure;
     QDoubleSpinBox* m_spinGain;
+    double m_lastExposureSent = 0.0;  // 最近一次发出的曝光值，用来认出过时的回显
+    double m_lastGainSent = 0.0;
 
     // 核心状态阀门
     bool m_isLiveMode = true; // true: 实时刷新, false: 画面定格
     bool m_captureNextFrame = false; // 新增：是否只放行“单帧”的特权标志
     cv::Mat m_lastFrame;      // 暂存最后一张画面，用于存图
+    std::shared_ptr<LatestFrameMailbox> m_frameSource;
+    bool m_firstFrameShown = false;
 
 
 };
\ No newline at end of file
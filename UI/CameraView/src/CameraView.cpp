@@ -88,11 +88,14 @@ void CameraView::initSignalConnects() {
         });
 
     // 4. 数值变化时，向外发射信号
+    //    拖动时每一步都会发出，由 Service 的参数队列负责合并
     connect(m_spinExposure, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double val) {
+        m_lastExposureSent = val;
         emit exposureTimeChanged(val);
         });
 
     connect(m_spinGain, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double val) {
+        m_lastGainSent = val;
         emit gainChanged(val);
         });
 }
@@ -103,6 +106,16 @@ CameraView::~CameraView() {}
 // ==========================================
 // 5. 渲染拦截与画面定格控制
 // ==========================================
+void CameraView::setFrameSource(std::shared_ptr<LatestFrameMailbox> mailbox) {
+    m_frameSource = std::move(mailbox);
+}
+
+void CameraView::onFrameAvailable() {
+    // 通知与图分开走：界面忙了一阵之后，这里拿到的已经是最新的一帧，不会把积压的旧帧挨个画一遍
+    cv::Mat frame;
+    if (m_frameSource && m_frameSource->take(frame)) onFrameReady(frame);
+}
+
 void CameraView::onFrameReady(const cv::Mat& frame) {
     if (frame.empty()) return;
 
@@ -130,6 +143,11 @@ void CameraView::onFrameReady(const cv::Mat& frame) {
         Qt::FastTransformation);
     m_videoLabel->setPixmap(QPixmap::fromImage(scaledImg));
 
+    if (!m_firstFrameShown) {
+        m_firstFrameShown = true;
+        emit firstFrameDisplayed();
+    }
+
     // ---- 拦截后续操作 ----
     // 如果刚才使用的是“单帧放行特权”，现在图已经画到屏幕上了，特权必须立刻收回！
     // 这样下一帧就会被上面的 if 拦截掉，画面完美定格。
@@ -149,6 +167,13 @@ void CameraView::showMessage(const QString& msg) {
     m_videoLabel->setStyleSheet("background-color: black; color: #ff4d4f; font-size: 24px; font-weight: bold;");
 }
 
+void CameraView::showStatus(const QString& msg) {
+    // 画面到来之前在屏幕中央显示灰色的状态文字，第一帧绘制时自然被画面替换
+    m_videoLabel->clear();
+    m_videoLabel->setText(msg);
+    m_videoLabel->setStyleSheet("background-color: black; color: #8c8c8c; font-size: 20px;");
+}
+
 // ==========================================
 // 软硬件同步：设置界面的初始真实值
 // ==========================================
@@ -169,6 +194,25 @@ void CameraView::setInitialParams(double exposure, double gain, double maxGain)
         << "us, 当前增益:" << gain << "dB, 增益极限被锁定为:" << maxGain << "dB";
 }
 
+void CameraView::onExposureTimeApplied(double requestedUs, double appliedUs) {
+    // 用户已经调到别的值了：这是一个过时的回显，忽略
+    if (requestedUs != m_lastExposureSent || appliedUs == m_spinExposure->value()) return;
+
+    m_spinExposure->blockSignals(true);
+    m_spinExposure->setValue(appliedUs);
+    m_spinExposure->blockSignals(false);
+    m_lastExposureSent = appliedUs;
+}
+
+void CameraView::onGainApplied(double requested, double applied) {
+    if (requested != m_lastGainSent || applied == m_spinGain->value()) return;
+
+    m_spinGain->blockSignals(true);
+    m_spinGain->setValue(applied);
+    m_spinGain->blockSignals(false);
+    m_lastGainSent = applied;
+}
+
 void CameraView::saveFrameToFile(const cv::Mat& frame, const QString& dirPath) {
     if (frame.empty()) return;
 